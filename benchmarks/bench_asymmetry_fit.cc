@@ -0,0 +1,78 @@
+// Speed and bias of AsymmetryFit on a toy sample: rows with beam helicity
+// +-1 and phi_h, phi_S distributed as 1 + P (A1 sin(phi_h) + A2
+// sin(phi_h+phi_S-pi) + A3 cos(2phi_h)) are written in the columnar format,
+// then fitted with 1 and with the given number of threads.
+//
+// Usage: bench_asymmetry_fit [number of rows] [threads] [output directory]
+
+#include "AsymmetryFit.h"
+#include "ColumnarFile.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    long nRows = argc > 1 ? atol(argv[1]) : 10000000;
+    int threads = argc > 2 ? atoi(argv[2]) : 8;
+    std::string directory = argc > 3 ? argv[3] : ".";
+    std::string filename = directory + "/bench_asymmetry_fit.scol";
+    const double truth[3] = {0.05, 0.03, -0.02};
+
+    {
+        ColumnarWriter writer(filename);
+        double phi_h, phi_S;
+        int bPol;
+        writer.addColumn("phi_h", &phi_h);
+        writer.addColumn("phi_S", &phi_S);
+        writer.addColumn("bPol", &bPol);
+        std::mt19937_64 rng(23);
+        std::uniform_real_distribution<double> flat(0, 1);
+        for (long i = 0; i < nRows;) {
+            phi_h = M_PI * (2 * flat(rng) - 1);
+            phi_S = M_PI * (2 * flat(rng) - 1);
+            bPol = flat(rng) < 0.5 ? 1 : -1;
+            double density = 1 + bPol * (truth[0] * sin(phi_h) + truth[1] * sin(phi_h + phi_S - M_PI) + truth[2] * cos(2 * phi_h));
+            if (1.2 * flat(rng) < density) {
+                writer.fill();
+                i++;
+            }
+        }
+        writer.write();
+    }
+
+    bool same = true;
+    std::vector<double> first;
+    for (int t : {1, threads}) {
+        AsymmetryFit fit;
+        for (const char* modulation : {"sin(phi_h)", "sin(phi_h+phi_S-pi)", "cos(2phi_h)"}) fit.addModulation(modulation);
+        fit.setThreads(t);
+        auto start = std::chrono::steady_clock::now();
+        fit.load(filename);
+        double loadSeconds = elapsed(start);
+        start = std::chrono::steady_clock::now();
+        AsymmetryFitResult result = fit.fit();
+        double fitSeconds = elapsed(start);
+        cout << t << " thread(s): read " << loadSeconds << " s, fit " << fitSeconds << " s, "
+             << result.iterations << " iterations" << endl;
+        for (std::size_t k = 0; k < result.values.size(); ++k) {
+            double pull = (result.values[k] - truth[k]) / result.errors[k];
+            cout << "  " << result.modulations[k] << ": " << result.values[k] << " +- " << result.errors[k]
+                 << " (pull " << pull << ")" << endl;
+        }
+        if (first.empty()) first = result.values;
+        for (std::size_t k = 0; k < first.size(); ++k) same &= std::fabs(first[k] - result.values[k]) < 1e-9;
+    }
+    cout << "Same result with " << threads << " threads: " << (same ? "yes" : "no") << endl;
+    fs::remove(filename);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+// Scan speed of a DISTree output in the ROOT and in the columnar format:
+// both files are written with the same dihadron rows, then two columns are
+// summed over all rows, through TTree::GetEntry and through mapped column
+// views.
+//
+// Usage: bench_columnar [number of rows] [output directory]
+
+#include "DISTree.h"
+#include "ColumnarFile.h"
+#include "TFile.h"
+#include "TTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int nRows = argc > 1 ? atoi(argv[1]) : 2000000;
+    std::string directory = argc > 2 ? argv[2] : ".";
+    std::string rootFile = directory + "/bench_columnar.root";
+    std::string columnarFile = directory + "/bench_columnar.scol";
+
+    // Beam lepton, target, scattered lepton and a pi+ pi- pair, one pair per event
+    std::mt19937_64 rng(13);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    std::vector<LundEvent> events(2000);
+    std::vector<std::vector<std::vector<Hadronium>>> hadronia(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        auto add = [&](int pid, int status, double px, double py, double pz, double m) {
+            LundParticle p{};
+            p.index = events[i].particles.size() + 1;
+            p.particle_id = pid;
+            p.status = status;
+            p.px = px; p.py = py; p.pz = pz; p.m = m;
+            p.e = sqrt(px*px + py*py + pz*pz + m*m);
+            events[i].particles.push_back(p);
+        };
+        add(11, 21, 0, 0, 10.6, 0.000511);
+        add(2212, 21, 0, 0, 0, 0.938272);
+        add(11, 1, flat(rng), flat(rng), 5 + 2 * flat(rng), 0.000511);
+        std::vector<Hadronium> pair;
+        for (int pid : {211, -211}) {
+            add(pid, 1, flat(rng), flat(rng), 2.5 + 2 * flat(rng), 0.13957);
+            const LundParticle& p = events[i].particles.back();
+            pair.emplace_back(pid, 1, p.px, p.py, p.pz, p.e, std::vector<int>{p.index});
+        }
+        hadronia[i].push_back(pair);
+    }
+
+    OutputOptions columnar;
+    columnar.format = OutputFormat::Columnar;
+    for (const auto& output : {std::make_pair(rootFile, OutputOptions()), std::make_pair(columnarFile, columnar)}) {
+        auto start = std::chrono::steady_clock::now();
+        DISTree tree(output.first, HadroniumAnalysisType::DiHadron, output.second);
+        for (int i = 0; i < nRows; ++i) {
+            size_t e = i % events.size();
+            tree.Fill(events[e], hadronia[e]);
+        }
+        tree.Write();
+        cout << "Wrote " << output.first << " in " << elapsed(start) << " s, " << fs::file_size(output.first) / 1e6 << " MB" << endl;
+    }
+
+    // Sum of sin(phi_h) weighted by z, as in a moment fit
+    auto start = std::chrono::steady_clock::now();
+    TFile* in = TFile::Open(rootFile.c_str());
+    TTree* tree = (TTree*)(in->Get("tree"));
+    double phi_h = 0, z = 0;
+    tree->SetBranchStatus("*", false);
+    tree->SetBranchStatus("phi_h", true);
+    tree->SetBranchStatus("z", true);
+    tree->SetBranchAddress("phi_h", &phi_h);
+    tree->SetBranchAddress("z", &z);
+    double rootSum = 0;
+    Long64_t nEntries = tree->GetEntries();
+    for (Long64_t entry = 0; entry < nEntries; ++entry) {
+        tree->GetEntry(entry);
+        rootSum += z * sin(phi_h);
+    }
+    double rootSeconds = elapsed(start);
+    in->Close();
+    delete in;
+
+    start = std::chrono::steady_clock::now();
+    ColumnarFile file(columnarFile);
+    ColumnView<double> phiColumn = file.column<double>("phi_h");
+    ColumnView<double> zColumn = file.column<double>("z");
+    double columnarSum = 0;
+    for (std::size_t i = 0; i < phiColumn.size(); ++i) {
+        columnarSum += zColumn[i] * sin(phiColumn[i]);
+    }
+    double columnarSeconds = elapsed(start);
+
+    cout << "TTree scan:    " << rootSeconds << " s (" << nEntries / rootSeconds / 1e6 << " M rows/s)" << endl;
+    cout << "Columnar scan: " << columnarSeconds << " s (" << file.rows() / columnarSeconds / 1e6 << " M rows/s)" << endl;
+    bool same = rootSum == columnarSum;
+    cout << "Same sums: " << (same ? "yes" : "no") << endl;
+    fs::remove(rootFile);
+    fs::remove(columnarFile);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+// Throughput of the parametric detector stage (FastSimulation) on generated
+// events, and a check that the same event key gives the same response.
+//
+// Usage: bench_fastsim [map file] [number of events]
+
+#include "FastSimulation.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    std::string map = argc > 1 ? argv[1] : "detector_maps/clas12_forward.map";
+    int nEvents = argc > 2 ? atoi(argv[2]) : 1000000;
+    FastSimulation detector(map, 1);
+
+    // Beam lepton, target, scattered lepton and eight final state hadrons or photons
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    const int pids[] = {211, -211, 111, 22, 22, 321, 2212, -211};
+    std::vector<LundEvent> events(1000);
+    for (auto& event : events) {
+        auto add = [&](int pid, int status, double px, double py, double pz, double m) {
+            LundParticle p{};
+            p.index = event.particles.size() + 1;
+            p.particle_id = pid;
+            p.status = status;
+            p.px = px; p.py = py; p.pz = pz; p.m = m;
+            p.e = sqrt(px*px + py*py + pz*pz + m*m);
+            event.particles.push_back(p);
+        };
+        add(11, 21, 0, 0, 10.6, 0.000511);
+        add(2212, 21, 0, 0, 0, 0.938272);
+        add(11, 1, flat(rng), flat(rng), 5 + 2 * flat(rng), 0.000511);
+        for (int pid : pids) add(pid, 1, flat(rng), flat(rng), 2.5 + 2 * flat(rng), 0.13957);
+    }
+
+    long kept = 0, particles = 0;
+    LundEvent event;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nEvents; ++i) {
+        event = events[i % events.size()];
+        if (!detector.apply(event, FastSimulation::eventKey("bench.dat", i))) continue;
+        kept++;
+        for (const auto& p : event.particles) particles += p.status == 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Same key, same response
+    LundEvent a = events[0], b = events[0];
+    detector.apply(a, FastSimulation::eventKey("bench.dat", 42));
+    detector.apply(b, FastSimulation::eventKey("bench.dat", 42));
+    bool reproducible = true;
+    for (size_t i = 0; i < a.particles.size(); ++i) {
+        reproducible &= a.particles[i].px == b.particles[i].px && a.particles[i].status == b.particles[i].status;
+    }
+
+    cout << nEvents << " events in " << seconds << " s (" << nEvents / seconds / 1e6 << " M events/s, including the event copy)" << endl;
+    cout << kept << " events kept, " << (double)particles / max(kept, 1L) << " final state particles per kept event" << endl;
+    cout << "Reproducible per event key: " << (reproducible ? "yes" : "no") << endl;
+    return reproducible ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+// Compares the kinematics of KinematicsCalculator and KinematicsBatch with the
+// former TLorentzVector implementation, on randomly generated DIS events, and
+// times the three of them.
+//
+// Usage: bench_kinematics [number of events] [candidates per event]
+
+#include "Kinematics.h"
+#include "KinematicsBatch.h"
+#include "TLorentzVector.h"
+#include "TVector3.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Largest accepted difference, relative to max(1, |reference|)
+const double kTolerance = 1e-9;
+
+// The TLorentzVector implementation the calculator had before FourVector
+class ReferenceKinematics {
+    TLorentzVector initialElectron, initialProton, finalElectron, q;
+
+    double azimuth(const TVector3& v) const {
+        TVector3 qcrossL = q.Vect().Cross(initialElectron.Vect());
+        TVector3 qcrossV = q.Vect().Cross(v);
+        double factor1 = (qcrossL * v) / abs(qcrossL * v);
+        double factor2 = (qcrossL * qcrossV) / qcrossL.Mag() / qcrossV.Mag();
+        return factor1 * acos(factor2);
+    }
+    TLorentzVector boosted(TLorentzVector p) const {
+        p.Boost(-(q + initialProton).BoostVector());
+        return p;
+    }
+    double xF(const TLorentzVector& p) const {
+        double W = sqrt(initialProton.M2() + 2.0 * initialProton*q + q*q);
+        return 2 * boosted(p).Pz() / W;
+    }
+    double z(const TLorentzVector& p) const { return (initialProton * p) / (initialProton * q); }
+    double Mx(const TLorentzVector& p) const { return (initialElectron + initialProton - finalElectron - p).M(); }
+
+public:
+    explicit ReferenceKinematics(const LundEvent& event)
+        : initialElectron(event.particles[0].px, event.particles[0].py, event.particles[0].pz, event.particles[0].e),
+          initialProton(event.particles[1].px, event.particles[1].py, event.particles[1].pz, event.particles[1].e),
+          finalElectron(event.particles[2].px, event.particles[2].py, event.particles[2].pz, event.particles[2].e) {
+        q = initialElectron - finalElectron;
+    }
+
+    SingleHadronKinematics single(const HadronCandidate<1>& c) const {
+        TLorentzVector p(c[0].px, c[0].py, c[0].pz, c[0].e);
+        return SingleHadronKinematics{boosted(p).Perp(), z(p), azimuth(p.Vect()), p.M(), xF(p), Mx(p),
+                                      c[0].parentPid, c[0].grandParentPid, c[0].status};
+    }
+
+    DiHadronKinematics di(const HadronCandidate<2>& c) const {
+        TLorentzVector p1(c[0].px, c[0].py, c[0].pz, c[0].e);
+        TLorentzVector p2(c[1].px, c[1].py, c[1].pz, c[1].e);
+        TLorentzVector p = p1 + p2;
+        TVector3 R = (0.5 * (p1 - p2)).Vect();
+        TVector3 RT = R - (R.Dot(q.Vect()) / q.Vect().Mag2()) * q.Vect();
+        double z1 = z(p1), z2 = z(p2);
+        TVector3 P1perp = p1.Vect() - (p1.Vect().Dot(q.Vect()) / q.Vect().Mag2()) * q.Vect();
+        TVector3 P2perp = p2.Vect() - (p2.Vect().Dot(q.Vect()) / q.Vect().Mag2()) * q.Vect();
+        TVector3 Rperp = (z2 * P1perp - z1 * P2perp) * (1 / (z1 + z2));
+        TVector3 comBoost = p.BoostVector();
+        TLorentzVector P1 = p1;
+        P1.Boost(-comBoost);
+        return DiHadronKinematics{boosted(p1).Perp(), boosted(p2).Perp(), boosted(p).Perp(),
+                                  z1, z2, z(p), azimuth(p.Vect()), azimuth(RT), azimuth(Rperp),
+                                  P1.Vect().Angle(comBoost), p.M(), xF(p1), xF(p2), xF(p), Mx(p),
+                                  c[0].parentPid, c[0].grandParentPid, c[0].status,
+                                  c[1].parentPid, c[1].grandParentPid, c[1].status};
+    }
+};
+
+struct Sample {
+    std::vector<LundEvent> events;
+    std::vector<HadronCandidate<2>> candidates; // hadron 0 doubles as single hadron
+    std::vector<int> eventIndex;
+};
+
+Sample generate(int nEvents, int nCandidates) {
+    Sample sample;
+    std::mt19937_64 rng(12345);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    auto particle = [&](int pid, int status, double px, double py, double pz, double m) {
+        LundParticle p{};
+        p.particle_id = pid;
+        p.status = status;
+        p.px = px; p.py = py; p.pz = pz; p.m = m;
+        p.e = sqrt(px*px + py*py + pz*pz + m*m);
+        return p;
+    };
+    for (int i = 0; i < nEvents; ++i) {
+        LundEvent event{};
+        event.target_polarization = i % 2 ? 1 : -1;
+        event.beam_polarization = i % 4 < 2 ? 1 : -1;
+        event.particles.push_back(particle(11, 21, 0, 0, 10.6, 0.000511));
+        event.particles.push_back(particle(2212, 21, 0, 0, 0, 0.938272));
+        event.particles.push_back(particle(11, 1, 1.5 * flat(rng), 1.5 * flat(rng), 6 + 2 * flat(rng), 0.000511));
+        for (int c = 0; c < nCandidates; ++c) {
+            HadronCandidate<2> candidate;
+            for (auto& h : candidate) {
+                h.px = flat(rng); h.py = flat(rng); h.pz = 2.5 + 1.5 * flat(rng);
+                h.e = sqrt(h.px*h.px + h.py*h.py + h.pz*h.pz + 0.13957 * 0.13957);
+                h.parentPid = 113; h.grandParentPid = 2; h.status = 1;
+            }
+            sample.candidates.push_back(candidate);
+            sample.eventIndex.push_back(i);
+        }
+        sample.events.push_back(event);
+    }
+    return sample;
+}
+
+// Number of fields of a and b differing by more than the tolerance
+int compare(const double* a, const double* b, int n) {
+    int bad = 0;
+    for (int f = 0; f < n; ++f) {
+        if (std::isnan(a[f]) && std::isnan(b[f])) continue;
+        if (!(abs(a[f] - b[f]) <= kTolerance * max(1.0, abs(b[f])))) bad++;
+    }
+    return bad;
+}
+
+template<class F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<std::size_t N, class Result>
+int run(const Sample& sample, const char* label) {
+    const int nFields = KinematicsBatch<N>::NFields;
+    std::vector<Result> reference, scalar;
+    KinematicsBatch<N> batch;
+    auto candidate = [&](std::size_t i) {
+        HadronCandidate<N> c;
+        for (std::size_t h = 0; h < N; ++h) c[h] = sample.candidates[i][h];
+        return c;
+    };
+
+    // One calculator per event, as in DISTree::Fill
+    double tReference = seconds([&] {
+        std::size_t i = 0;
+        for (std::size_t e = 0; e < sample.events.size(); ++e) {
+            ReferenceKinematics ref(sample.events[e]);
+            for (; i < sample.candidates.size() && sample.eventIndex[i] == (int)e; ++i) {
+                if constexpr (N == 1) reference.push_back(ref.single(candidate(i)));
+                else reference.push_back(ref.di(candidate(i)));
+            }
+        }
+    });
+    double tScalar = seconds([&] {
+        std::size_t i = 0;
+        for (std::size_t e = 0; e < sample.events.size(); ++e) {
+            KinematicsCalculator kin(sample.events[e]);
+            for (; i < sample.candidates.size() && sample.eventIndex[i] == (int)e; ++i) {
+                scalar.push_back(kin.CalculateHadronKinematics(candidate(i)));
+            }
+        }
+    });
+    double tFill = seconds([&] {
+        std::size_t i = 0;
+        for (std::size_t e = 0; e < sample.events.size(); ++e) {
+            std::size_t event = batch.addEvent(KinematicsCalculator(sample.events[e]));
+            for (; i < sample.candidates.size() && sample.eventIndex[i] == (int)e; ++i) {
+                batch.addCandidate(event, candidate(i));
+            }
+        }
+    });
+    double tCompute = seconds([&] { batch.compute(); });
+    double tBatch = tFill + tCompute;
+
+    int badScalar = 0, badBatch = 0;
+    for (std::size_t i = 0; i < reference.size(); ++i) {
+        Result fromBatch = batch.get(i);
+        const double* ref = reinterpret_cast<const double*>(&reference[i]);
+        badScalar += compare(reinterpret_cast<const double*>(&scalar[i]), ref, nFields);
+        badBatch += compare(reinterpret_cast<const double*>(&fromBatch), ref, nFields);
+    }
+
+    cout << label << ": " << reference.size() << " candidates" << endl;
+    cout << "  TLorentzVector       " << tReference << " s" << endl;
+    cout << "  KinematicsCalculator " << tScalar << " s (x" << tReference / tScalar << "), "
+         << badScalar << " values outside tolerance" << endl;
+    cout << "  KinematicsBatch      " << tBatch << " s (x" << tReference / tBatch << "), "
+         << badBatch << " values outside tolerance" << endl;
+    cout << "    of which compute() " << tCompute << " s (x" << tReference / tCompute << ")" << endl;
+    return badScalar + badBatch;
+}
+
+int main(int argc, char* argv[]) {
+    int nEvents = argc > 1 ? atoi(argv[1]) : 200000;
+    int nCandidates = argc > 2 ? atoi(argv[2]) : 4;
+    Sample sample = generate(nEvents, nCandidates);
+
+    cout << "Tolerance: " << kTolerance << " relative to max(1, |reference|)" << endl;
+    int bad = run<1, SingleHadronKinematics>(sample, "Single hadron");
+    bad += run<2, DiHadronKinematics>(sample, "Dihadron");
+    return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// LUND writers of the generators: the same events, with particle values
+// spanning signs, magnitudes and rounding ties, are written with the chained
+// iostream insertions of the original pythia8_to_gemc_lund and with
+// LundFormatter into a buffer flushed in 1 MB chunks. Reports both write
+// times and checks that the two files are byte-identical.
+//
+// Usage: bench_lund_writer [number of events] [output directory]
+
+#include "LundFormatter.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Row {
+    int index, status, pid, parent, daughter;
+    float lifetime, px, py, pz, e, m, vx, vy, vz;
+};
+
+int main(int argc, char* argv[]) {
+    int nEvents = argc > 1 ? atoi(argv[1]) : 100000;
+    std::string directory = argc > 2 ? argv[2] : ".";
+    std::string streamFile = directory + "/bench_lund_stream.dat";
+    std::string fastFile = directory + "/bench_lund_formatter.dat";
+
+    std::mt19937_64 rng(47);
+    std::uniform_real_distribution<float> flat(-1, 1);
+    std::uniform_real_distribution<float> exponent(-6, 4);
+    auto value = [&]() -> float {
+        switch (rng() % 8) {
+            case 0: return 0.0f;
+            case 1: return -0.0f;
+            case 2: return (int)(rng() % 2001 - 1000) / 32.0f; // ties at the 4th decimal
+            case 3: return flat(rng) * 1e-5f;                  // rounds to (-)0.0000
+            default: return flat(rng) * std::pow(10.0f, exponent(rng));
+        }
+    };
+    std::vector<std::vector<Row>> events(nEvents);
+    for (auto& rows : events) {
+        rows.resize(5 + rng() % 40);
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            rows[i] = {(int)i + 1, (int)(rng() % 2), (int)(rng() % 4000) - 2000, (int)i, (int)i + 2,
+                       rng() % 2 ? 1.0f : -1.0f, value(), value(), value(), value(), value(), value(), value(), value()};
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::ofstream outFile(streamFile);
+        for (const auto& rows : events) {
+            outFile << "\t" << std::left << std::setw(8) << (int)rows.size() << std::setw(8) << rows[0].m << std::setw(8) << 1
+                    << std::setw(8) << 0 << std::setw(8) << 1 << std::setw(8) << 11 << std::setw(8) << rows[0].e
+                    << std::setw(8) << 2212 << std::setw(8) << rows[0].pid << std::setw(8) << rows[0].px << "\n";
+            for (const Row& r : rows) {
+                outFile << std::right << std::setw(4) << r.index
+                        << std::setw(8) << std::setprecision(1) << std::fixed << r.lifetime
+                        << std::setw(4) << r.status
+                        << std::setw(8) << r.pid
+                        << std::setw(8) << r.parent
+                        << std::setw(8) << r.daughter
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.px
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.py
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.pz
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.e
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.m
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.vx
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.vy
+                        << std::setw(12) << std::setprecision(4) << std::fixed << r.vz << "\n";
+            }
+        }
+    }
+    double streamSeconds = elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    {
+        std::ofstream outFile(fastFile, std::ios::binary);
+        LundFormatter formatter;
+        std::string buffer;
+        buffer.reserve(1 << 21);
+        for (const auto& rows : events) {
+            formatter.header(buffer, rows.size(), rows[0].m, 1, 0, 1, 11, rows[0].e, 2212, rows[0].pid, rows[0].px);
+            for (const Row& r : rows) {
+                formatter.particle(buffer, r.index, r.lifetime, r.status, r.pid, r.parent, r.daughter,
+                                   r.px, r.py, r.pz, r.e, r.m, r.vx, r.vy, r.vz);
+            }
+            if (buffer.size() > (1 << 20)) {
+                outFile.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        outFile.write(buffer.data(), buffer.size());
+    }
+    double fastSeconds = elapsed(start);
+
+    std::ifstream a(streamFile, std::ios::binary), b(fastFile, std::ios::binary);
+    bool same = std::equal(std::istreambuf_iterator<char>(a), std::istreambuf_iterator<char>(),
+                           std::istreambuf_iterator<char>(b), std::istreambuf_iterator<char>());
+    double megabytes = fs::file_size(streamFile) / 1e6;
+    cout << "iostream writer:      " << nEvents << " events, " << megabytes << " MB in " << streamSeconds << " s ("
+         << megabytes / streamSeconds << " MB/s)" << endl;
+    cout << "LundFormatter writer: " << nEvents << " events, " << fs::file_size(fastFile) / 1e6 << " MB in "
+         << fastSeconds << " s (" << megabytes / fastSeconds << " MB/s, " << streamSeconds / fastSeconds << "x faster)" << endl;
+    cout << "Byte-identical: " << (same ? "yes" : "no") << endl;
+    fs::remove(streamFile);
+    fs::remove(fastFile);
+    return same ? 0 : 1;
+}
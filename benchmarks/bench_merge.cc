@@ -0,0 +1,110 @@
+// Merging job outputs: the same dihadron trees, split over many files as the
+// batches of an HPC project leave them, are merged with OutputMerger and with
+// hadd. Reports the time and throughput of both, and checks that the merged
+// trees have all the rows.
+//
+// Usage: bench_merge [number of files] [rows per file] [threads] [output directory]
+
+#include "DISTree.h"
+#include "OutputMerger.h"
+#include "TFile.h"
+#include "TTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+Long64_t entries(const std::string& filename) {
+    std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "READ"));
+    TTree* tree = file && !file->IsZombie() ? (TTree*)file->Get("tree") : nullptr;
+    return tree ? tree->GetEntries() : -1;
+}
+
+int main(int argc, char* argv[]) {
+    int nFiles = argc > 1 ? atoi(argv[1]) : 200;
+    int nRows = argc > 2 ? atoi(argv[2]) : 50000;
+    int threads = argc > 3 ? atoi(argv[3]) : 8;
+    std::string directory = argc > 4 ? argv[4] : ".";
+
+    // Beam lepton, target, scattered lepton and a pi+ pi- pair, one pair per event
+    std::mt19937_64 rng(23);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    std::vector<LundEvent> events(2000);
+    std::vector<std::vector<std::vector<Hadronium>>> hadronia(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i].target_polarization = i % 2 ? 1 : -1;
+        auto add = [&](int pid, int status, double px, double py, double pz, double m) {
+            LundParticle p{};
+            p.index = events[i].particles.size() + 1;
+            p.particle_id = pid;
+            p.status = status;
+            p.px = px; p.py = py; p.pz = pz; p.m = m;
+            p.e = sqrt(px*px + py*py + pz*pz + m*m);
+            events[i].particles.push_back(p);
+        };
+        add(11, 21, 0, 0, 10.6, 0.000511);
+        add(2212, 21, 0, 0, 0, 0.938272);
+        add(11, 1, flat(rng), flat(rng), 5 + 2 * flat(rng), 0.000511);
+        std::vector<Hadronium> pair;
+        for (int pid : {211, -211}) {
+            add(pid, 1, flat(rng), flat(rng), 2.5 + 2 * flat(rng), 0.13957);
+            const LundParticle& p = events[i].particles.back();
+            pair.emplace_back(pid, 1, p.px, p.py, p.pz, p.e, std::vector<int>{p.index});
+        }
+        hadronia[i].push_back(pair);
+    }
+
+    std::vector<std::string> inputs;
+    std::string pattern = directory + "/bench_merge_batch*.root";
+    for (int f = 0; f < nFiles; ++f) {
+        inputs.push_back(directory + "/bench_merge_batch" + std::to_string(f) + ".root");
+        DISTree tree(inputs.back(), HadroniumAnalysisType::DiHadron);
+        for (int i = 0; i < nRows; ++i) {
+            size_t e = (f * nRows + i) % events.size();
+            tree.Fill(events[e], hadronia[e]);
+        }
+        tree.Write();
+    }
+
+    std::string mergedFile = directory + "/bench_merge_merger.root";
+    OutputMerger merger;
+    merger.setThreads(threads);
+    MergeStatistics statistics = merger.merge(inputs, mergedFile);
+    double megabytes = statistics.bytesIn / 1e6;
+
+    std::string haddFile = directory + "/bench_merge_hadd.root";
+    auto start = std::chrono::steady_clock::now();
+    int status = std::system(("hadd -f -k " + haddFile + " " + pattern + " > /dev/null").c_str());
+    double haddSeconds = elapsed(start);
+
+    Long64_t expected = (Long64_t)nFiles * nRows;
+    bool complete = entries(mergedFile) == expected;
+    cout << "Inputs: " << nFiles << " files, " << megabytes << " MB" << endl;
+    cout << "OutputMerger (" << threads << " threads): " << statistics.seconds << " s, " << statistics.levels
+         << " level(s), " << megabytes / statistics.seconds << " MB/s" << endl;
+    if (status == 0) {
+        complete &= entries(haddFile) == expected;
+        cout << "hadd: " << haddSeconds << " s, " << megabytes / haddSeconds << " MB/s ("
+             << haddSeconds / statistics.seconds << "x the time of OutputMerger)" << endl;
+    } else {
+        cout << "hadd: not available" << endl;
+    }
+    cout << "All rows merged: " << (complete ? "yes" : "no") << endl;
+
+    for (const auto& input : inputs) fs::remove(input);
+    fs::remove(mergedFile);
+    fs::remove(haddFile);
+    return complete ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+// Cost of event mixing: generated events with a few pi+ and pi- each are
+// reconstructed with "(211) + (-211)" and filled into a dihadron tree, once
+// with the same-event pairs only and once also mixing every event with the
+// pooled pi- of its (Q2, multiplicity) class. Reports the time per event, the
+// number of mixed pairs and the memory of the pools.
+//
+// Usage: bench_mixing [number of events] [depth]
+
+#include "EventMixing.h"
+#include "DISTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int nEvents = argc > 1 ? atoi(argv[1]) : 200000;
+    int depth = argc > 2 ? atoi(argv[2]) : 10;
+    const std::string criteria = "(211) + (-211)";
+
+    // Beam lepton, target, scattered lepton and one to three pions of each charge
+    std::mt19937_64 rng(29);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    std::vector<LundEvent> events(5000);
+    for (auto& event : events) {
+        auto add = [&](int pid, int status, double px, double py, double pz, double m) {
+            LundParticle p{};
+            p.index = event.particles.size() + 1;
+            p.particle_id = pid;
+            p.status = status;
+            p.px = px; p.py = py; p.pz = pz; p.m = m;
+            p.e = sqrt(px*px + py*py + pz*pz + m*m);
+            event.particles.push_back(p);
+        };
+        add(11, 21, 0, 0, 10.6, 0.000511);
+        add(2212, 21, 0, 0, 0, 0.938272);
+        add(11, 1, flat(rng), flat(rng), 5 + 2 * flat(rng), 0.000511);
+        int nPions = 2 + (int)(3 * (flat(rng) + 1));
+        for (int k = 0; k < nPions; ++k) {
+            add(k % 2 ? -211 : 211, 1, flat(rng), flat(rng), 1.5 + flat(rng), 0.13957);
+        }
+    }
+
+    EventMixing mixing;
+    mixing.setDepth(depth);
+    mixing.addAxis("Q2", {0, 2, 4, 6, 8, 20});
+    mixing.addAxis("multiplicity", {0, 4, 6, 8, 20});
+    mixing.setCriteria(criteria);
+    mixing.reset();
+
+    OutputOptions none;
+    none.format = OutputFormat::None;
+    double seconds[2];
+    long mixedPairs = 0;
+    for (int withMixing = 0; withMixing < 2; ++withMixing) {
+        DISTree tree("", HadroniumAnalysisType::DiHadron, none);
+        DISTree mixedTree("", HadroniumAnalysisType::DiHadron, none);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nEvents; ++i) {
+            LundEvent& event = events[i % events.size()];
+            std::vector<Hadronium> particles = convertLundEventToHadronia(event, AcceptanceType::ALL);
+            std::vector<std::vector<Hadronium>> hadronia = reconstruct_hadronia(particles, criteria);
+            if (withMixing) {
+                const auto& mixed = mixing.mix(event, particles);
+                mixedPairs += mixed.size();
+                if (!mixed.empty()) mixedTree.Fill(event, mixed);
+            }
+            if (!hadronia.empty()) tree.Fill(event, hadronia);
+        }
+        seconds[withMixing] = elapsed(start);
+        tree.Write();
+        mixedTree.Write();
+    }
+
+    cout << nEvents << " events, " << mixing.classes() << " classes of depth " << depth
+         << ", pools of " << mixing.poolBytes() / 1e3 << " kB" << endl;
+    cout << "Same-event pairs:        " << seconds[0] / nEvents * 1e6 << " us/event" << endl;
+    cout << "With event mixing:       " << seconds[1] / nEvents * 1e6 << " us/event, "
+         << (double)mixedPairs / nEvents << " mixed pairs/event" << endl;
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Binned moments instead of stored rows: the same dihadron rows are written
+// as a tree, and accumulated into (x, Q2, z, pt, Mh) bins with sin and cos
+// moments and no tree. Reports the time and output size of both, and checks
+// the lookup of BinAxis against a binary search.
+//
+// Usage: bench_moments [number of rows] [output directory]
+
+#include "BinnedMoments.h"
+#include "DISTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int nRows = argc > 1 ? atoi(argv[1]) : 2000000;
+    std::string directory = argc > 2 ? argv[2] : ".";
+    std::string treeFile = directory + "/bench_moments_tree.root";
+    std::string momentsFile = directory + "/bench_moments.root";
+
+    // Beam lepton, target, scattered lepton and a pi+ pi- pair, one pair per event
+    std::mt19937_64 rng(19);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    std::vector<LundEvent> events(2000);
+    std::vector<std::vector<std::vector<Hadronium>>> hadronia(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i].target_polarization = i % 2 ? 1 : -1;
+        auto add = [&](int pid, int status, double px, double py, double pz, double m) {
+            LundParticle p{};
+            p.index = events[i].particles.size() + 1;
+            p.particle_id = pid;
+            p.status = status;
+            p.px = px; p.py = py; p.pz = pz; p.m = m;
+            p.e = sqrt(px*px + py*py + pz*pz + m*m);
+            events[i].particles.push_back(p);
+        };
+        add(11, 21, 0, 0, 10.6, 0.000511);
+        add(2212, 21, 0, 0, 0, 0.938272);
+        add(11, 1, flat(rng), flat(rng), 5 + 2 * flat(rng), 0.000511);
+        std::vector<Hadronium> pair;
+        for (int pid : {211, -211}) {
+            add(pid, 1, flat(rng), flat(rng), 2.5 + 2 * flat(rng), 0.13957);
+            const LundParticle& p = events[i].particles.back();
+            pair.emplace_back(pid, 1, p.px, p.py, p.pz, p.e, std::vector<int>{p.index});
+        }
+        hadronia[i].push_back(pair);
+    }
+
+    BinnedMoments moments;
+    moments.addAxis("x", {0, 0.1, 0.15, 0.2, 0.3, 0.4, 1});
+    moments.addAxis("Q2", {1, 1.5, 2, 3, 5, 10, 100});
+    moments.addAxis("z", {0, 0.3, 0.4, 0.5, 0.6, 0.7, 1});
+    moments.addAxis("pt", {0, 0.2, 0.4, 0.6, 0.8, 1.2, 5});
+    moments.addAxis("Mh", {0, 0.4, 0.6, 0.8, 1, 1.3, 3});
+    for (const char* moment : {"tPol*sin(phi_h+phi_S-pi)", "tPol*sin(phi_h-phi_S)", "tPol*sin(phi_RT+phi_S)",
+                               "tPol*sin(phi_Rperp+phi_S)", "cos(phi_h)", "cos(2phi_h)"}) {
+        moments.addMoment(moment);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        DISTree tree(treeFile, HadroniumAnalysisType::DiHadron);
+        for (int i = 0; i < nRows; ++i) {
+            size_t e = i % events.size();
+            tree.Fill(events[e], hadronia[e]);
+        }
+        tree.Write();
+    }
+    double treeSeconds = elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    {
+        OutputOptions none;
+        none.format = OutputFormat::None;
+        DISTree tree("", HadroniumAnalysisType::DiHadron, none);
+        BinnedMoments::Shard sums = moments.shard();
+        sums.attach(tree);
+        for (int i = 0; i < nRows; ++i) {
+            size_t e = i % events.size();
+            tree.Fill(events[e], hadronia[e]);
+        }
+        tree.Write();
+        moments.write(momentsFile, sums);
+    }
+    double momentsSeconds = elapsed(start);
+
+    cout << nRows << " dihadron rows, " << moments.bins() << " bins" << endl;
+    cout << "Tree:           " << treeSeconds << " s, " << fs::file_size(treeFile) / 1e6 << " MB" << endl;
+    cout << "Binned moments: " << momentsSeconds << " s, " << fs::file_size(momentsFile) / 1e3 << " kB" << endl;
+
+    // Bin lookup against std::upper_bound
+    BinAxis axis("x", {0, 0.1, 0.15, 0.2, 0.3, 0.4, 1});
+    std::uniform_real_distribution<double> value(-0.1, 1.1);
+    std::vector<double> values(1 << 20);
+    for (auto& v : values) v = value(rng);
+    start = std::chrono::steady_clock::now();
+    long lookupSum = 0;
+    for (double v : values) lookupSum += axis.index(v);
+    double lookupSeconds = elapsed(start);
+    start = std::chrono::steady_clock::now();
+    long searchSum = 0;
+    for (double v : values) {
+        int bin = v < axis.edges.front() || v >= axis.edges.back()
+                      ? -1 : (int)(std::upper_bound(axis.edges.begin(), axis.edges.end(), v) - axis.edges.begin()) - 1;
+        searchSum += bin;
+    }
+    double searchSeconds = elapsed(start);
+    bool same = lookupSum == searchSum;
+    for (double v : values) {
+        int bin = (int)(std::upper_bound(axis.edges.begin(), axis.edges.end(), v) - axis.edges.begin()) - 1;
+        if (bin >= axis.bins()) bin = -1;
+        if (bin != axis.index(v)) same = false;
+    }
+    cout << "Bin lookup: " << values.size() / lookupSeconds / 1e6 << " M/s, binary search: "
+         << values.size() / searchSeconds / 1e6 << " M/s" << endl;
+    cout << "Same bins: " << (same ? "yes" : "no") << endl;
+    fs::remove(treeFile);
+    fs::remove(momentsFile);
+    return same ? 0 : 1;
+}
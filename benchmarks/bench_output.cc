@@ -0,0 +1,175 @@
+// Write time and file size of a dihadron DISTree for several output settings
+// (compression algorithm and level, reduced precision columns, basket size),
+// and of the row and per-event layouts for events with nine pairs each.
+//
+// Usage: bench_output [number of rows] [output directory]
+
+#include "DISTree.h"
+#include "Compression.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+typedef ROOT::RCompressionSetting::EAlgorithm Algorithm;
+
+struct Setting {
+    std::string label;
+    OutputOptions options;
+};
+
+OutputOptions compressed(int algorithm, int level) {
+    OutputOptions options;
+    options.compression = algorithm < 0 ? 0 : ROOT::CompressionSettings((Algorithm::EValues)algorithm, level);
+    return options;
+}
+
+// Double columns as Float_t, and the angles packed into angleBits bits if angleBits > 0
+OutputOptions reduced(OutputOptions options, int angleBits) {
+    for (const char* angle : {"phi_h", "phi_RT", "phi_Rperp", "th", "phi_S"}) {
+        options.precision[angle] = angleBits > 0 ? ColumnPrecision{ColumnPrecision::Type::Double32, -3.1415927, 3.1415927, angleBits}
+                                                 : ColumnPrecision{};
+    }
+    for (const char* column : {"x", "y", "Q2", "W", "epsilon", "gamma", "depolA", "depolB", "depolC", "depolV", "depolW",
+                               "pt1", "pt2", "pt", "z1", "z2", "z", "Mh", "xF1", "xF2", "xF", "Mx"}) {
+        options.precision[column] = ColumnPrecision{};
+    }
+    return options;
+}
+
+// Size of the output and of the files it continued in
+std::uintmax_t outputSize(const std::string& filename) {
+    std::uintmax_t size = fs::file_size(filename);
+    std::string stem = filename.substr(0, filename.size() - 5);
+    for (int i = 1; fs::exists(stem + "_" + std::to_string(i) + ".root"); ++i) {
+        size += fs::file_size(stem + "_" + std::to_string(i) + ".root");
+    }
+    return size;
+}
+
+int main(int argc, char* argv[]) {
+    int nRows = argc > 1 ? atoi(argv[1]) : 1000000;
+    std::string directory = argc > 2 ? argv[2] : ".";
+
+    // Beam lepton, target, scattered lepton and a pi+ pi- pair, one pair per event
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    std::vector<LundEvent> events(2000);
+    std::vector<std::vector<std::vector<Hadronium>>> hadronia(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        auto add = [&](int pid, int status, double px, double py, double pz, double m) {
+            LundParticle p{};
+            p.index = events[i].particles.size() + 1;
+            p.particle_id = pid;
+            p.status = status;
+            p.px = px; p.py = py; p.pz = pz; p.m = m;
+            p.e = sqrt(px*px + py*py + pz*pz + m*m);
+            events[i].particles.push_back(p);
+        };
+        add(11, 21, 0, 0, 10.6, 0.000511);
+        add(2212, 21, 0, 0, 0, 0.938272);
+        add(11, 1, flat(rng), flat(rng), 5 + 2 * flat(rng), 0.000511);
+        std::vector<Hadronium> pair;
+        for (int pid : {211, -211}) {
+            add(pid, 1, flat(rng), flat(rng), 2.5 + 2 * flat(rng), 0.13957);
+            const LundParticle& p = events[i].particles.back();
+            pair.emplace_back(pid, 1, p.px, p.py, p.pz, p.e, std::vector<int>{p.index});
+        }
+        hadronia[i].push_back(pair);
+    }
+
+    OutputOptions bigBaskets = compressed(Algorithm::kZSTD, 5);
+    bigBaskets.basketSize = 256000;
+    bigBaskets.autoFlush = -64000000;
+    std::vector<Setting> settings = {
+        {"default", OutputOptions()},
+        {"none", compressed(-1, 0)},
+        {"ZLIB 1", compressed(Algorithm::kZLIB, 1)},
+        {"ZLIB 6", compressed(Algorithm::kZLIB, 6)},
+        {"LZ4 4", compressed(Algorithm::kLZ4, 4)},
+        {"ZSTD 5", compressed(Algorithm::kZSTD, 5)},
+        {"LZMA 9", compressed(Algorithm::kLZMA, 9)},
+        {"ZSTD 5, float", reduced(compressed(Algorithm::kZSTD, 5), 0)},
+        {"ZSTD 5, float, 16 bit angles", reduced(compressed(Algorithm::kZSTD, 5), 16)},
+        {"ZSTD 5, 256 kB baskets", bigBaskets},
+    };
+
+    cout << nRows << " dihadron rows per setting" << endl;
+    cout << left << setw(32) << "setting" << right << setw(12) << "time (s)" << setw(14) << "rows/s" << setw(14) << "size (MB)" << endl;
+    for (const auto& setting : settings) {
+        std::string filename = directory + "/bench_output.root";
+        auto start = std::chrono::steady_clock::now();
+        {
+            DISTree tree(filename, HadroniumAnalysisType::DiHadron, setting.options);
+            for (int i = 0; i < nRows; ++i) {
+                size_t e = i % events.size();
+                tree.Fill(events[e], hadronia[e]);
+            }
+            tree.Write();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::uintmax_t size = outputSize(filename);
+        cout << left << setw(32) << setting.label << right << fixed
+             << setw(12) << setprecision(2) << seconds
+             << setw(14) << setprecision(0) << nRows / seconds
+             << setw(14) << setprecision(1) << size / 1e6 << endl;
+        fs::remove(filename);
+    }
+
+    // Three pi+ and three pi-, all nine pairs pass
+    for (size_t i = 0; i < events.size(); ++i) {
+        LundEvent& event = events[i];
+        event.particles.resize(3);
+        std::vector<LundParticle> pions;
+        for (int h = 0; h < 6; ++h) {
+            LundParticle p{};
+            p.index = event.particles.size() + 1;
+            p.particle_id = h % 2 ? -211 : 211;
+            p.status = 1;
+            p.px = flat(rng); p.py = flat(rng); p.pz = 2.5 + 2 * flat(rng); p.m = 0.13957;
+            p.e = sqrt(p.px*p.px + p.py*p.py + p.pz*p.pz + p.m*p.m);
+            event.particles.push_back(p);
+        }
+        hadronia[i].clear();
+        for (int plus = 3; plus < 9; plus += 2) {
+            for (int minus = 4; minus < 9; minus += 2) {
+                std::vector<Hadronium> pair;
+                for (int h : {plus, minus}) {
+                    const LundParticle& p = event.particles[h];
+                    pair.emplace_back(p.particle_id, 1, p.px, p.py, p.pz, p.e, std::vector<int>{p.index});
+                }
+                hadronia[i].push_back(pair);
+            }
+        }
+    }
+    int nEvents = nRows / 9;
+    cout << endl << nEvents << " events with 9 dihadrons per layout" << endl;
+    for (OutputLayout layout : {OutputLayout::Rows, OutputLayout::Events}) {
+        std::string filename = directory + "/bench_output.root";
+        OutputOptions options = compressed(Algorithm::kZSTD, 5);
+        options.layout = layout;
+        auto start = std::chrono::steady_clock::now();
+        {
+            DISTree tree(filename, HadroniumAnalysisType::DiHadron, options);
+            for (int i = 0; i < nEvents; ++i) {
+                size_t e = i % events.size();
+                tree.Fill(events[e], hadronia[e]);
+            }
+            tree.Write();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cout << left << setw(32) << (layout == OutputLayout::Rows ? "ZSTD 5, rows" : "ZSTD 5, events") << right << fixed
+             << setw(12) << setprecision(2) << seconds
+             << setw(14) << setprecision(0) << nEvents * 9 / seconds
+             << setw(14) << setprecision(1) << outputSize(filename) / 1e6 << endl;
+        fs::remove(filename);
+    }
+    return 0;
+}
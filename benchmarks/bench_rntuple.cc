@@ -0,0 +1,261 @@
+// File size, write and read throughput of TTree and RNTuple on the same
+// generated sample, for the two layouts of the project: per-event particle
+// collections (pythia8_to_ttree, read back with LundReader) and per-candidate
+// kinematics rows (DISTree).
+//
+// Usage: bench_rntuple [number of events] [output directory]
+
+#include "DISTree.h"
+#include "LundReader.h"
+#include "RNTupleSupport.h"
+#include "TFile.h"
+#include "TTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+#ifdef SPINTHYIA_HAS_RNTUPLE
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const std::string& label, const std::string& filename, long n, double writeSeconds, double readSeconds) {
+    cout << left << setw(22) << label << right << fixed
+         << setw(12) << setprecision(1) << fs::file_size(filename) / 1e6
+         << setw(16) << setprecision(3) << n / writeSeconds / 1e6
+         << setw(16) << setprecision(3) << n / readSeconds / 1e6 << endl;
+}
+
+// The event columns of pythia8_to_ttree, filled from a LundEvent
+struct EventColumns {
+    int nParticles, atomic_number_target, target_polarization, beam_polarization, beam_type;
+    int interacted_nucleon_id, process_id;
+    float mass_target, beam_energy, event_weight;
+    std::vector<int> index, status, particle_id, index_of_parent, index_of_first_daughter, index_of_grandparent;
+    std::vector<float> lifetime, px, py, pz, e, m, vx, vy, vz;
+
+    template<class Output>
+    void declare(Output* output) {
+        output->Branch("nParticles", &nParticles);
+        output->Branch("mass_target", &mass_target);
+        output->Branch("atomic_number_target", &atomic_number_target);
+        output->Branch("target_polarization", &target_polarization);
+        output->Branch("beam_polarization", &beam_polarization);
+        output->Branch("beam_type", &beam_type);
+        output->Branch("beam_energy", &beam_energy);
+        output->Branch("interacted_nucleon_id", &interacted_nucleon_id);
+        output->Branch("process_id", &process_id);
+        output->Branch("event_weight", &event_weight);
+        output->Branch("index", &index);
+        output->Branch("lifetime", &lifetime);
+        output->Branch("status", &status);
+        output->Branch("particle_id", &particle_id);
+        output->Branch("index_of_parent", &index_of_parent);
+        output->Branch("index_of_first_daughter", &index_of_first_daughter);
+        output->Branch("index_of_grandparent", &index_of_grandparent);
+        output->Branch("px", &px);
+        output->Branch("py", &py);
+        output->Branch("pz", &pz);
+        output->Branch("e", &e);
+        output->Branch("m", &m);
+        output->Branch("vx", &vx);
+        output->Branch("vy", &vy);
+        output->Branch("vz", &vz);
+    }
+    void set(const LundEvent& event) {
+        nParticles = event.nParticles;
+        mass_target = event.mass_target;
+        atomic_number_target = event.atomic_number_target;
+        target_polarization = event.target_polarization;
+        beam_polarization = event.beam_polarization;
+        beam_type = event.beam_type;
+        beam_energy = event.beam_energy;
+        interacted_nucleon_id = event.interacted_nucleon_id;
+        process_id = event.process_id;
+        event_weight = event.event_weight;
+        for (auto* v : {&index, &status, &particle_id, &index_of_parent, &index_of_first_daughter, &index_of_grandparent}) v->clear();
+        for (auto* v : {&lifetime, &px, &py, &pz, &e, &m, &vx, &vy, &vz}) v->clear();
+        for (const auto& p : event.particles) {
+            index.push_back(p.index);
+            lifetime.push_back(p.lifetime);
+            status.push_back(p.status);
+            particle_id.push_back(p.particle_id);
+            index_of_parent.push_back(p.index_of_parent);
+            index_of_first_daughter.push_back(p.index_of_first_daughter);
+            px.push_back(p.px); py.push_back(p.py); pz.push_back(p.pz);
+            e.push_back(p.e); m.push_back(p.m);
+            vx.push_back(p.vx); vy.push_back(p.vy); vz.push_back(p.vz);
+        }
+    }
+};
+
+// As in pythia8_to_ttree
+struct NTupleOutput {
+    std::unique_ptr<ROOT::RNTupleModel> model = ROOT::RNTupleModel::Create();
+    std::vector<std::function<void(ROOT::REntry&)>> bindings;
+    std::unique_ptr<ROOT::RNTupleWriter> writer;
+    std::unique_ptr<ROOT::REntry> entry;
+
+    template<class T>
+    void Branch(const char* name, T* address) {
+        model->MakeField<T>(name);
+        bindings.push_back([name, address](ROOT::REntry& e) { e.BindRawPtr(name, address); });
+    }
+    void open(const std::string& fileName) {
+        writer = ROOT::RNTupleWriter::Recreate(std::move(model), "tree", fileName);
+        entry = writer->CreateEntry();
+        for (const auto& bind : bindings) bind(*entry);
+    }
+};
+
+double readEvents(const std::string& filename, long& nParticles) {
+    auto start = std::chrono::steady_clock::now();
+    LundReader reader(filename);
+    LundEvent event;
+    nParticles = 0;
+    while (reader.readEvent(event)) nParticles += event.particles.size();
+    return elapsed(start);
+}
+
+int main(int argc, char* argv[]) {
+    long nEvents = argc > 1 ? atol(argv[1]) : 200000;
+    std::string directory = argc > 2 ? argv[2] : ".";
+
+    // Beam lepton, target, scattered lepton and 5 to 20 final state hadrons
+    std::mt19937_64 rng(17);
+    std::uniform_real_distribution<double> flat(-1, 1);
+    std::uniform_int_distribution<int> multiplicity(5, 20);
+    std::vector<LundEvent> events(5000);
+    std::vector<std::vector<std::vector<Hadronium>>> hadronia(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        LundEvent& event = events[i];
+        event = LundEvent{};
+        event.mass_target = 0.938272;
+        event.atomic_number_target = 1;
+        event.beam_polarization = i % 2 ? 1 : -1;
+        event.beam_type = 11;
+        event.beam_energy = 10.6;
+        event.interacted_nucleon_id = 2212;
+        event.process_id = 99;
+        event.event_weight = 1;
+        auto add = [&](int pid, int status, double px, double py, double pz, double m) {
+            LundParticle p{};
+            p.index = event.particles.size() + 1;
+            p.lifetime = 1;
+            p.particle_id = pid;
+            p.status = status;
+            p.px = px; p.py = py; p.pz = pz; p.m = m;
+            p.e = sqrt(px*px + py*py + pz*pz + m*m);
+            event.particles.push_back(p);
+        };
+        add(11, 21, 0, 0, 10.6, 0.000511);
+        add(2212, 21, 0, 0, 0, 0.938272);
+        add(11, 1, flat(rng), flat(rng), 5 + 2 * flat(rng), 0.000511);
+        int n = multiplicity(rng);
+        for (int h = 0; h < n; ++h) add(h % 2 ? 211 : -211, 1, flat(rng), flat(rng), 2.5 + 2 * flat(rng), 0.13957);
+        event.nParticles = event.particles.size();
+        // One pi+ pi- candidate per event for the kinematics rows
+        std::vector<Hadronium> pair;
+        for (int h = 3; h < 5; ++h) {
+            const LundParticle& p = event.particles[h];
+            pair.emplace_back(p.particle_id, 1, p.px, p.py, p.pz, p.e, std::vector<int>{p.index});
+        }
+        hadronia[i].push_back(pair);
+    }
+
+    cout << nEvents << " events" << endl;
+    cout << left << setw(22) << "" << right << setw(12) << "size (MB)" << setw(16) << "write (M/s)" << setw(16) << "read (M/s)" << endl;
+
+    // Per-event particle collections
+    std::string treeEvents = directory + "/bench_events_ttree.root";
+    std::string ntupleEvents = directory + "/bench_events_rntuple.root";
+    EventColumns columns;
+    auto start = std::chrono::steady_clock::now();
+    {
+        TFile out(treeEvents.c_str(), "RECREATE");
+        TTree* tree = new TTree("tree", "tree");
+        columns.declare(tree);
+        for (long i = 0; i < nEvents; ++i) {
+            columns.set(events[i % events.size()]);
+            tree->Fill();
+        }
+        out.WriteTObject(tree);
+        out.Close();
+    }
+    double treeWrite = elapsed(start);
+    start = std::chrono::steady_clock::now();
+    {
+        NTupleOutput out;
+        columns.declare(&out);
+        out.open(ntupleEvents);
+        for (long i = 0; i < nEvents; ++i) {
+            columns.set(events[i % events.size()]);
+            out.writer->Fill(*out.entry);
+        }
+    }
+    double ntupleWrite = elapsed(start);
+    long treeParticles, ntupleParticles;
+    double treeRead = readEvents(treeEvents, treeParticles);
+    double ntupleRead = readEvents(ntupleEvents, ntupleParticles);
+    report("events, TTree", treeEvents, nEvents, treeWrite, treeRead);
+    report("events, RNTuple", ntupleEvents, nEvents, ntupleWrite, ntupleRead);
+
+    // Per-candidate kinematics rows
+    std::string treeRows = directory + "/bench_rows_ttree.root";
+    std::string ntupleRows = directory + "/bench_rows_rntuple.root";
+    double rowWrite[2];
+    for (int format = 0; format < 2; ++format) {
+        OutputOptions options;
+        options.format = format == 0 ? OutputFormat::ROOT : OutputFormat::RNTuple;
+        start = std::chrono::steady_clock::now();
+        DISTree tree(format == 0 ? treeRows : ntupleRows, HadroniumAnalysisType::DiHadron, options);
+        for (long i = 0; i < nEvents; ++i) {
+            size_t e = i % events.size();
+            tree.Fill(events[e], hadronia[e]);
+        }
+        tree.Write();
+        rowWrite[format] = elapsed(start);
+    }
+    // Read every column of every row
+    start = std::chrono::steady_clock::now();
+    {
+        TFile in(treeRows.c_str());
+        TTree* tree = (TTree*)(in.Get("tree"));
+        Long64_t nEntries = tree->GetEntries();
+        for (Long64_t entry = 0; entry < nEntries; ++entry) tree->GetEntry(entry);
+    }
+    double treeRowRead = elapsed(start);
+    start = std::chrono::steady_clock::now();
+    {
+        auto reader = ROOT::RNTupleReader::Open("tree", ntupleRows);
+        for (std::uint64_t entry = 0; entry < reader->GetNEntries(); ++entry) reader->LoadEntry(entry);
+    }
+    double ntupleRowRead = elapsed(start);
+    report("dihadron rows, TTree", treeRows, nEvents, rowWrite[0], treeRowRead);
+    report("dihadron rows, RNTuple", ntupleRows, nEvents, rowWrite[1], ntupleRowRead);
+
+    bool same = treeParticles == ntupleParticles;
+    cout << "Same particles read back: " << (same ? "yes" : "no") << endl;
+    for (const auto& f : {treeEvents, ntupleEvents, treeRows, ntupleRows}) fs::remove(f);
+    return same ? 0 : 1;
+}
+
+#else
+
+int main() {
+    cout << "RNTuple needs ROOT 6.36 or later; nothing to compare" << endl;
+    return 0;
+}
+
+#endif
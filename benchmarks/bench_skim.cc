@@ -0,0 +1,77 @@
+// Reprocessing a skim: a LUND file of generated events is read in full, and
+// read again with LundReader::selectEvents keeping every n-th event, which
+// skips the other events without parsing them. Reports both read times and
+// checks that the selected events come back unchanged.
+//
+// Usage: bench_skim [number of events] [keep one event in] [output directory]
+
+#include "LundReader.h"
+#include "SkimList.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int nEvents = argc > 1 ? atoi(argv[1]) : 200000;
+    int keep = argc > 2 ? atoi(argv[2]) : 100;
+    std::string directory = argc > 3 ? argv[3] : ".";
+    std::string filename = directory + "/bench_skim.dat";
+
+    {
+        std::ofstream out(filename);
+        std::mt19937_64 rng(31);
+        std::uniform_real_distribution<double> flat(-1, 1);
+        for (int e = 0; e < nEvents; ++e) {
+            int n = 10 + e % 20;
+            out << n << " 0.938 1 1 -1 11 10.6 2212 1 " << e << "\n";
+            for (int i = 0; i < n; ++i) {
+                out << i + 1 << " 0 1 211 0 0 " << flat(rng) << " " << flat(rng) << " " << 2 + flat(rng)
+                    << " 2.5 0.13957 0 0 0\n";
+            }
+        }
+    }
+
+    SkimList skim({filename});
+    for (int e = 0; e < nEvents; e += keep) skim.mark(0, e);
+
+    LundEvent event;
+    auto start = std::chrono::steady_clock::now();
+    long nRead = 0;
+    {
+        LundReader reader(filename);
+        while (reader.readEvent(event)) nRead++;
+    }
+    double fullSeconds = elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    long nSelected = 0;
+    bool same = true;
+    {
+        LundReader reader(filename);
+        reader.selectEvents(*skim.find(filename));
+        while (reader.readEvent(event)) {
+            same &= reader.eventIndex() % keep == 0 && (int)event.event_weight == reader.eventIndex() &&
+                    (int)event.particles.size() == 10 + reader.eventIndex() % 20;
+            nSelected++;
+        }
+    }
+    double skimSeconds = elapsed(start);
+    same &= nSelected == (long)skim.selected(0);
+
+    cout << "Full read: " << nRead << " events in " << fullSeconds << " s" << endl;
+    cout << "Skim read: " << nSelected << " events in " << skimSeconds << " s ("
+         << fullSeconds / skimSeconds << "x faster)" << endl;
+    cout << "Selected events intact: " << (same ? "yes" : "no") << endl;
+    fs::remove(filename);
+    return same ? 0 : 1;
+}
@@ -32,6 +32,7 @@ options = {
   output_dir: "#{Dir.pwd}/out",
   force: false,
   process_macros: nil,
+  analysis_cards: nil,
   batch: -1
 }
 
@@ -48,6 +49,9 @@ OptionParser.new do |opts|
   opts.on("-p", "--process-macros MACROS", "Comma-separated list of process macros to run after the executable (ex: -p macro1.C,macro2.C)") do |m|
     options[:process_macros] = m.split(',')
   end
+  opts.on("-a", "--analysis-cards CARDS", "Comma-separated list of analysis cards, located in ./analysis_cards, to run with ./bin/lund_analysis after the executable (ex: -a card1.card,card2.card)") do |a|
+    options[:analysis_cards] = a.split(',')
+  end
   opts.on_tail("-h", "--help", "Show this message") do
     puts opts
     exit
@@ -114,20 +118,34 @@ case executable_name
     check_missing_parameters(required_params, options)
     puts_lightblue("Running 'pythia8_to_gemc_lund'")
     FileUtils.mkdir_p(gen_out_dir_v2)
-    executable_line = "./bin/pythia8_to_gemc_lund #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 0 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
-    executable_line += "\n./bin/pythia8_to_gemc_lund #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 1 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
-    executable_line += "\n./bin/pythia8_to_gemc_lund #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 2 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
-    executable_line += "\n./bin/pythia8_to_gemc_lund #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 3 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
+    # The four polarisation modes, each on its own thread
+    executable_line = "./bin/pythia8_to_gemc_lund #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 0,1,2,3 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
   when "pythia8_to_ttree"
     gen_out_dir_v2 = "#{gen_out_dir}/pythia8"
     required_params = [:events, :project_name, :run_card]
     check_missing_parameters(required_params, options)
     puts_lightblue("Running 'pythia8_to_ttree'")
     FileUtils.mkdir_p(gen_out_dir_v2)
-    executable_line = "./bin/pythia8_to_ttree #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 0 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
-    executable_line += "\n./bin/pythia8_to_ttree #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 1 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
-    executable_line += "\n./bin/pythia8_to_ttree #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 2 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
-    executable_line += "\n./bin/pythia8_to_ttree #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 3 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
+    # The four polarisation modes, each on its own thread
+    executable_line = "./bin/pythia8_to_ttree #{gen_out_dir_v2} #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 0,1,2,3 #{rand(1000000)}" + (options[:batch]==-1 ? "" : " #{options[:batch]}")
+  when "generate_and_analyze"
+    required_params = [:events, :project_name, :run_card, :analysis_cards]
+    check_missing_parameters(required_params, options)
+    if options[:process_macros]
+      puts "ERROR in create_project.rb ... 'generate_and_analyze' writes no event files for the ROOT macros, use analysis cards (-a) instead."
+      exit
+    end
+    puts_lightblue("Running 'generate_and_analyze'")
+    # Every card analyzes its own events of the four polarisation modes,
+    # generated on four threads, without event files
+    seed = rand(1000000)
+    executable_line = options[:analysis_cards].map do |card|
+      card_filename_without_extension = File.basename(card, File.extname(card))
+      output_filename = "#{project_dir}/" + (options[:batch] >= 0 ? "batch#{options[:batch]}_" : "") + "analysis_#{card_filename_without_extension}.root"
+      "./bin/generate_and_analyze '#{Dir.pwd}/analysis_cards/#{card}' #{runcard_dir}/#{options[:run_card]} #{options[:events]/4} 0,1,2,3 #{seed} 1 '#{output_filename}'"
+    end.join(" && ")
+    # The cards have been run
+    options[:analysis_cards] = nil
   when "clasdis"
     gen_out_dir_v2 = "#{gen_out_dir}/clasdis"
     required_params = [:events, :run_card]
@@ -176,6 +194,34 @@ def run_root_macros(project_dir, macros, gen_out_dir_v2, batch)
   end
 end
 
+def run_analysis_cards(project_dir, cards, gen_out_dir_v2, batch)
+  cards.each do |card|
+    card_path = "#{Dir.pwd}/analysis_cards/#{card}"
+    unless File.exist?(card_path)
+      puts_lightred("Analysis card #{card} not found at #{card_path}. Skipping...")
+      next
+    end
+    puts_lightblue("Running lund_analysis with card: #{card}")
+    card_filename_without_extension = File.basename(card, File.extname(card))
+    if batch >= 0 # Use wildcard with batch
+        output_filename = "#{project_dir}/batch#{batch}_analysis_#{card_filename_without_extension}.root"
+        system("./bin/lund_analysis '#{card_path}' '#{gen_out_dir_v2}/batch#{batch}_*' '#{output_filename}'")
+    else
+        output_filename = "#{project_dir}/analysis_#{card_filename_without_extension}.root"
+        system("./bin/lund_analysis '#{card_path}' '#{gen_out_dir_v2}/*' '#{output_filename}'")
+    end
+  end
+end
+
+# If analysis cards are specified, run them (before the macros, which remove the generated files)
+if options[:analysis_cards]
+  puts_lightgreen("\nRunning analysis cards...")
+  run_analysis_cards(project_dir, options[:analysis_cards], gen_out_dir_v2, options[:batch])
+  unless options[:process_macros]
+    system(options[:batch] >= 0 ? "rm #{gen_out_dir_v2}/batch#{options[:batch]}_*" : "rm #{gen_out_dir_v2}/*")
+  end
+end
+
 # If process macros are specified, run them
 if options[:process_macros]
   puts_lightgreen("\nRunning process macros...")
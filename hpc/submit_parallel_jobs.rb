@@ -91,6 +91,10 @@ OptionParser.new do |opts|
     options[:process_macros] = p
   end
 
+  opts.on("-a", "--analysis-cards CARDS", "Analysis cards for ./bin/lund_analysis.") do |a|
+    options[:analysis_cards] = a
+  end
+
   opts.on("-b", "--num-batches BATCHES", Integer, "Number of batches for parallel processing (default: 1).") do |b|
     options[:num_batches] = b
   end
@@ -156,6 +160,11 @@ FileUtils.mkdir_p(slurm_dir)
 # Array to hold job IDs
 job_ids = []
 
+# The Pythia programs and generate_and_analyze generate the four polarisation
+# modes on four threads
+program = File.basename(options[:executable_name], ".*")
+batch_cpus = program.start_with?("pythia8_") || program == "generate_and_analyze" ? 4 : 1
+
 # Generate and submit a Slurm job for each batch
 options[:num_batches].times do |batch_index|
   slurm_script = <<-SLURM
@@ -164,13 +173,13 @@ options[:num_batches].times do |batch_index|
 #SBATCH --account=clas12
 #SBATCH --partition=production
 #SBATCH --mem-per-cpu=1000
-#SBATCH --cpus-per-task=1
+#SBATCH --cpus-per-task=#{batch_cpus}
 #SBATCH --output=#{log_dir}/#{options[:project_name]}_#{batch_index}.out
 #SBATCH --error=#{log_dir}/#{options[:project_name]}_#{batch_index}.err
 #SBATCH --time=24:00:00
 
 # Execute the create_project.rb script with batch-specific parameters
-ruby create_project.rb -n #{options[:project_name]} -e #{options[:executable_name]} -r #{options[:run_card]} -c #{options[:events]} -f -b #{batch_index} #{options[:process_macros] ? "-p #{options[:process_macros]}" : ''}
+ruby create_project.rb -n #{options[:project_name]} -e #{options[:executable_name]} -r #{options[:run_card]} -c #{options[:events]} -f -b #{batch_index} #{options[:process_macros] ? "-p #{options[:process_macros]}" : ''} #{options[:analysis_cards] ? "-a #{options[:analysis_cards]}" : ''}
 
   SLURM
 
@@ -191,24 +200,33 @@ puts "Submitted #{options[:num_batches]} batch jobs for project #{options[:proje
 # Create a dependency string for the job IDs
 dependency_str = job_ids.join(':')
 
-# Submit a final job to run hadd after all other jobs have completed
+# Submit a final job to merge the batch outputs after all other jobs have completed
+merge_threads = 8
 final_slurm_script = <<-SLURM
 #!/bin/bash
 #SBATCH --dependency=afterok:#{dependency_str}
 #SBATCH --job-name=#{options[:project_name]}_merge
 #SBATCH --account=clas12
 #SBATCH --partition=production
-#SBATCH --mem-per-cpu=8000
-#SBATCH --cpus-per-task=1
+#SBATCH --mem-per-cpu=1000
+#SBATCH --cpus-per-task=#{merge_threads}
 #SBATCH --output=#{log_dir}/#{options[:project_name]}_merge.out
 #SBATCH --error=#{log_dir}/#{options[:project_name]}_merge.err
 #SBATCH --time=01:00:00
 
-# Command to merge ROOT files
-hadd -f #{project_dir}/analysis.root #{project_dir}/batch*.root
-
-# Remove all .root files apart from the first one, just to save it
-find #{project_dir} -type f -name "batch*.root" | grep -vE "^#{project_dir}/batch0_.*\.root$" | xargs rm -f
+# Merge the outputs of each analysis (batch<N>_<name>.root) into <name>.root.
+# Outputs with provenance (Output:provenance) are not merged, each batch has
+# its own file table.
+merged=1
+for name in $(ls #{project_dir}/batch*.root | sed 's|.*/batch[0-9]*_||' | sort -u); do
+  ./bin/spinthyia_merge -j #{merge_threads} #{project_dir}/${name} #{project_dir}/batch*_${name} || merged=0
+done
+
+# Remove all .root files apart from the first one, just to save it, unless
+# some were not merged
+if [ $merged -eq 1 ]; then
+  find #{project_dir} -type f -name "batch*.root" | grep -vE "^#{project_dir}/batch0_.*\.root$" | xargs rm -f
+fi
 
 
 SLURM
@@ -0,0 +1,96 @@
+#include "AsymmetryFit.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Unbinned maximum likelihood fit of azimuthal modulations to DISTree
+// outputs (see src/AsymmetryFit.h), e.g. the Collins and Sivers moments of
+// a transversely polarized target
+//
+//   asymmetry_fit -p tPol -m "sin(phi_h+phi_S-pi)" -m "sin(phi_h-phi_S)" -r "x 0.1 0.2" out/*.root
+
+namespace {
+
+void usage(const char* program) {
+    std::cout << "Usage: " << program << " [options] <output.root | output.scol> [...]\n"
+              << "  -m <modulation>         modulation to fit, e.g. \"sin(phi_RT)\" (repeatable)\n"
+              << "  -p <column>             polarization column, bPol (default) or tPol\n"
+              << "  -w <column>             weight column\n"
+              << "  -r \"<column> <min> <max>\" only fit rows in the range (repeatable)\n"
+              << "  -t <threads>            threads summing the likelihood (default 1)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  AsymmetryFit fit;
+  std::vector<std::string> modulations;
+  std::vector<std::string> files;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg.size() == 2 && arg[0] == '-' && i + 1 < argc) {
+        std::string value = argv[++i];
+        if (arg == "-m") modulations.push_back(value);
+        else if (arg == "-p") fit.setPolarization(value);
+        else if (arg == "-w") fit.setWeight(value);
+        else if (arg == "-t") fit.setThreads(std::stoi(value));
+        else if (arg == "-r") {
+          std::istringstream iss(value);
+          std::string column;
+          double min, max;
+          if (!(iss >> column >> min >> max)) throw std::runtime_error("Malformed range: " + value);
+          fit.addRange(column, min, max);
+        }
+        else {
+          usage(argv[0]);
+          return 1;
+        }
+      } else {
+        files.push_back(arg);
+      }
+    }
+    if (modulations.empty() || files.empty()) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    for (const auto& modulation : modulations) fit.addModulation(modulation);
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& file : files) fit.load(file);
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    AsymmetryFitResult result = fit.fit();
+    double fitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << result.rows << " polarized rows, read in " << loadSeconds << " s, fitted in " << fitSeconds
+              << " s (" << result.iterations << " iterations" << (result.converged ? "" : ", NOT CONVERGED") << ")" << std::endl;
+    std::cout << std::left << std::setw(32) << "modulation" << std::right << std::setw(14) << "value" << std::setw(14) << "error" << std::endl;
+    for (std::size_t k = 0; k < result.values.size(); ++k) {
+      std::cout << std::left << std::setw(32) << result.modulations[k] << std::right << std::fixed << std::setprecision(6)
+                << std::setw(14) << result.values[k] << std::setw(14) << result.errors[k] << std::endl;
+    }
+    if (result.values.size() > 1) {
+      std::cout << "correlations" << std::endl;
+      for (std::size_t k = 0; k < result.values.size(); ++k) {
+        for (std::size_t l = 0; l < result.values.size(); ++l) {
+          std::cout << std::setw(10) << std::setprecision(3)
+                    << result.covariance[k][l] / (result.errors[k] * result.errors[l]);
+        }
+        std::cout << std::endl;
+      }
+    }
+    if (!result.converged) return 2;
+  } catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "ColumnarFile.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Converts the tree of a DISTree output to the columnar format and back.
+// The direction follows the input: a columnar file (by its magic, whatever
+// its name) is converted to a TTree, anything else is read as a ROOT file
+// and converted to columnar.
+// Float_t branches stay float; Double32_t branches are stored as double.
+// Branches that are not a single number (such as vectors) are skipped.
+
+namespace {
+
+void treeToColumnar(const std::string& input, const std::string& output) {
+    TFile* in = TFile::Open(input.c_str());
+    if (!in || in->IsZombie()) {
+        throw std::runtime_error("Unable to open " + input);
+    }
+    TTree* tree = (TTree*)(in->Get("tree"));
+    if (!tree) {
+        throw std::runtime_error(input + " has no tree 'tree'");
+    }
+
+    ColumnarWriter writer(output);
+    std::deque<double> doubles;
+    std::deque<int> ints;
+    std::deque<std::pair<float, double*>> floats;
+    TObjArray* branches = tree->GetListOfBranches();
+    for (int b = 0; b < branches->GetEntries(); ++b) {
+        TBranch* branch = (TBranch*)(branches->At(b));
+        std::string name = branch->GetName();
+        TLeaf* leaf = branch->GetLeaf(name.c_str());
+        std::string type = leaf ? leaf->GetTypeName() : "";
+        if (leaf && leaf->GetLen() != 1) type = "";
+        if (type == "Double_t" || type == "Double32_t") {
+            doubles.push_back(0);
+            tree->SetBranchAddress(name.c_str(), &doubles.back());
+            writer.addColumn(name, &doubles.back());
+        } else if (type == "Float_t") {
+            doubles.push_back(0);
+            floats.emplace_back(0.0f, &doubles.back());
+            tree->SetBranchAddress(name.c_str(), &floats.back().first);
+            writer.addColumn(name, ColumnType::Float, &doubles.back(), nullptr);
+        } else if (type == "Int_t") {
+            ints.push_back(0);
+            tree->SetBranchAddress(name.c_str(), &ints.back());
+            writer.addColumn(name, &ints.back());
+        } else {
+            std::cerr << "WARNING: Skipping branch '" << name << "', which is not a single Double_t, Float_t or Int_t" << std::endl;
+            tree->SetBranchStatus(name.c_str(), false);
+        }
+    }
+
+    Long64_t nEntries = tree->GetEntries();
+    for (Long64_t entry = 0; entry < nEntries; ++entry) {
+        tree->GetEntry(entry);
+        for (auto& f : floats) *f.second = f.first;
+        writer.fill();
+    }
+    writer.write();
+    in->Close();
+    delete in;
+}
+
+void columnarToTree(const std::string& input, const std::string& output) {
+    ColumnarFile in(input);
+    TFile* out = new TFile(output.c_str(), "RECREATE");
+    TTree* tree = new TTree("tree", "Kinematics Data Tree");
+    const auto& columns = in.columns();
+    std::vector<double> doubles(columns.size());
+    std::vector<float> floats(columns.size());
+    std::vector<int> ints(columns.size());
+    for (std::size_t c = 0; c < columns.size(); ++c) {
+        const std::string& name = columns[c].name;
+        switch (columns[c].type) {
+            case ColumnType::Double: tree->Branch(name.c_str(), &doubles[c], (name + "/D").c_str()); break;
+            case ColumnType::Float: tree->Branch(name.c_str(), &floats[c], (name + "/F").c_str()); break;
+            case ColumnType::Int: tree->Branch(name.c_str(), &ints[c], (name + "/I").c_str()); break;
+        }
+    }
+
+    for (std::uint64_t row = 0; row < in.rows(); ++row) {
+        for (std::size_t c = 0; c < columns.size(); ++c) {
+            switch (columns[c].type) {
+                case ColumnType::Double: doubles[c] = static_cast<const double*>(columns[c].data)[row]; break;
+                case ColumnType::Float: floats[c] = static_cast<const float*>(columns[c].data)[row]; break;
+                case ColumnType::Int: ints[c] = static_cast<const int*>(columns[c].data)[row]; break;
+            }
+        }
+        tree->Fill();
+    }
+    out->WriteTObject(tree);
+    out->Close();
+    delete out;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cout << "Usage: " << argv[0] << " <input.root | input.scol> <output>" << std::endl;
+    return 1;
+  }
+
+  try {
+    std::string input = argv[1], output = argv[2];
+    if (ColumnarFile::isColumnar(input)) columnarToTree(input, output);
+    else treeToColumnar(input, output);
+  } catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,35 @@
+#include "AnalysisConfig.h"
+#include "LundAnalysis.h"
+
+#include <iostream>
+#include <stdexcept>
+
+// Compiled counterpart of the ROOT macros in ./macros. The analysis is
+// described by a card (see src/AnalysisConfig.h); the input pattern and
+// output file of the card may be overridden on the command line, which is
+// how create_project.rb runs it on each batch.
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 4) {
+    std::cout << "Usage: " << argv[0] << " <path/to/analysis.card> <optional: input pattern> <optional: output file>" << std::endl;
+    return 1;
+  }
+
+  try {
+    AnalysisConfig config = readAnalysisConfig(argv[1]);
+    if (argc >= 3) config.input = argv[2];
+    if (argc == 4) config.output = argv[3];
+    if (config.input.empty() || config.output.empty()) {
+      std::cerr << "The analysis card must set Analysis:input and Analysis:output, or they must be passed as arguments" << std::endl;
+      return 1;
+    }
+
+    LundAnalysis analysis(config.input, config.output, config.analysisType, config.verbosity);
+    configureAnalysis(analysis, config);
+    analysis.run();
+  } catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include "OutputMerger.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Merges DISTree outputs and binned moments files of several jobs in
+// parallel (see src/OutputMerger.h), replacing hadd in the HPC workflow
+//
+//   spinthyia_merge -j 8 out/my_project/analysis_two_pion.root out/my_project/batch*_analysis_two_pion.root
+
+namespace {
+
+void usage(const char* program) {
+    std::cout << "Usage: " << program << " [options] <output> <input> [<input> ...]\n"
+              << "  -j <threads>      threads merging groups of files (default: all cores)\n"
+              << "  -n <fan-in>       most files merged at once by one thread (default 64)\n"
+              << "  -c <compression>  ROOT compression setting, e.g. 505 (default: that of the first input)\n"
+              << "  -d                delete the inputs once the output is complete" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  OutputMerger merger;
+  merger.setThreads(std::thread::hardware_concurrency());
+  std::vector<std::string> files;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "-d") merger.setRemoveInputs(true);
+      else if (arg.size() == 2 && arg[0] == '-' && i + 1 < argc) {
+        std::string value = argv[++i];
+        if (arg == "-j") merger.setThreads(std::stoi(value));
+        else if (arg == "-n") merger.setFanIn(std::stoi(value));
+        else if (arg == "-c") merger.setCompression(std::stoi(value));
+        else {
+          usage(argv[0]);
+          return 1;
+        }
+      } else {
+        files.push_back(arg);
+      }
+    }
+    if (files.size() < 2) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    std::string output = files.front();
+    files.erase(files.begin());
+    MergeStatistics statistics = merger.merge(files, output);
+    std::cout << "Merged " << statistics.files << " files (" << statistics.bytesIn / 1e6 << " MB) into " << output
+              << " (" << statistics.bytesOut / 1e6 << " MB) in " << statistics.seconds << " s, "
+              << statistics.levels << " level(s), " << statistics.bytesIn / 1e6 / statistics.seconds << " MB/s" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
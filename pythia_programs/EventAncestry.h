@@ -0,0 +1,49 @@
+#ifndef EVENT_ANCESTRY_H
+#define EVENT_ANCESTRY_H
+
+#include "Pythia8/Pythia.h"
+
+#include <vector>
+
+// Ancestry of the particles of a Pythia event along their mother1 chains,
+// computed in one forward pass: Pythia stores mothers before their
+// daughters, so whether a particle descends from a diquark follows from its
+// mother. A mother stored after its daughter, if any, is resolved by walking
+// the chain as before.
+class EventAncestry {
+public:
+  void compute(const Pythia8::Event& event) {
+    int n = event.size();
+    diquark.assign(n, 0);
+    grandparents.assign(n, 0);
+    for (int i = 0; i < n; ++i) {
+      int parentIndex = event[i].mother1();
+      if (parentIndex <= 0) continue;
+      if (parentIndex < i) {
+        diquark[i] = event[parentIndex].isDiquark() || diquark[parentIndex];
+      } else {
+        diquark[i] = walk(event, i);
+      }
+      grandparents[i] = event[parentIndex].mother1();
+    }
+  }
+
+  // Whether any ancestor of particle i was a diquark
+  bool fromDiquark(int i) const { return diquark[i]; }
+  // mother1 of the mother1 of particle i, 0 without one
+  int grandparent(int i) const { return grandparents[i]; }
+
+private:
+  std::vector<char> diquark;
+  std::vector<int> grandparents;
+
+  static bool walk(const Pythia8::Event& event, int i) {
+    for (int step = 0, parentIndex = event[i].mother1(); parentIndex > 0 && step < event.size();
+         parentIndex = event[parentIndex].mother1(), ++step) {
+      if (event[parentIndex].isDiquark()) return true;
+    }
+    return false;
+  }
+};
+
+#endif // EVENT_ANCESTRY_H
@@ -0,0 +1,47 @@
+#ifndef GENERATOR_FILTER_H
+#define GENERATOR_FILTER_H
+
+#include "EventSelector.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+// Numbers of generated and selected events of one mode, summed over the
+// EventSelectors of its generators, for the normalization of filtered samples
+struct FilterCounts {
+  std::uint64_t generated = 0;
+  std::uint64_t accepted = 0;
+  std::mutex mutex;
+
+  void add(const EventSelector& selector) {
+    std::lock_guard<std::mutex> lock(mutex);
+    generated += selector.generated();
+    accepted += selector.accepted();
+  }
+
+  void add(std::uint64_t generatedEvents, std::uint64_t acceptedEvents) {
+    std::lock_guard<std::mutex> lock(mutex);
+    generated += generatedEvents;
+    accepted += acceptedEvents;
+  }
+
+  // Writes <output>/<filePrefix>counts, which LundAnalysis does not take as an input
+  bool write(const std::string& outputFilePath, const std::string& filePrefix, const std::string& card) const {
+    std::string fileName = outputFilePath + "/" + filePrefix + "counts";
+    std::ofstream out(fileName);
+    if (!out) {
+      std::cerr << "Failed to open file: " << fileName << std::endl;
+      return false;
+    }
+    out << "card " << card << "\n"
+        << "generated " << generated << "\n"
+        << "accepted " << accepted << "\n";
+    std::cout << filePrefix << ": " << accepted << " of " << generated << " events selected by " << card << std::endl;
+    return true;
+  }
+};
+
+#endif // GENERATOR_FILTER_H
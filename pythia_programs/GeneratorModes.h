@@ -0,0 +1,131 @@
+#ifndef GENERATOR_MODES_H
+#define GENERATOR_MODES_H
+
+#include "Pythia8/Pythia.h"
+#include "StringSpinner.h"
+#include "CounterRandom.h"
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Polarisation modes of the generators: 0: LU+, 1: LU-, 2: UL+, 3: UL-
+
+// Part of the file names of a mode, "" for an invalid mode
+inline std::string modeFileTag(int mode) {
+  switch(mode){
+      case 0: return "LU.1.";
+      case 1: return "LU.-1.";
+      case 2: return "UL.1.";
+      case 3: return "UL.-1.";
+  }
+  return "";
+}
+
+// Modes of a comma separated list, e.g. "0,1,2,3"; empty when an entry is
+// not a mode or repeats one
+inline std::vector<int> parseModes(const std::string& list) {
+  std::vector<int> modes;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.size() != 1 || modeFileTag(item[0] - '0').empty()) return {};
+    int mode = item[0] - '0';
+    for (int other : modes) {
+      if (other == mode) return {};
+    }
+    modes.push_back(mode);
+  }
+  return modes;
+}
+
+// Seed of generator `stream` of a job: the base seed for stream 0, so a
+// single generator reproduces the serial programs, and hashes of the base
+// seed within Pythia's range 1..900000000 for the others
+inline int generatorSeed(int seed, int stream) {
+    if (stream == 0) return seed;
+    std::uint64_t key = (std::uint64_t)(std::uint32_t)seed << 32 | (std::uint32_t)stream;
+    return 1 + (int)(splitmix64(key) % 899999999);
+}
+
+// Sets the quark or target polarisation of a mode. The polarisations are
+// settings of this Pythia instance, read by its own StringSpinner hooks.
+inline void setPolarisation(Pythia8::Pythia& pythia, int mode, int& beamSpin, int& targetSpin) {
+  bool beamPolarized   = false;
+  bool targetPolarized = false;
+  switch(mode) {
+    case 0: // LU, spin +
+      beamPolarized = true;
+      beamSpin      = 1;
+      targetSpin    = 0;
+      break;
+    case 1: // LU, spin -
+      beamPolarized = true;
+      beamSpin      = -1;
+      targetSpin    = 0;
+      break;
+    case 2: // UL, spin +
+      targetPolarized = true;
+      beamSpin        = 0;
+      targetSpin      = 1;
+      break;
+    case 3: // UL, spin -
+      targetPolarized = true;
+      beamSpin        = 0;
+      targetSpin      = -1;
+      break;
+  }
+    
+  std::string polStr;
+  if(beamPolarized) {
+    switch(beamSpin) {
+      case 1:  polStr = "0.0,0.0,-1.0"; break; // minus sign, since quark momentum is reversed after hard scattering
+      case -1: polStr = "0.0,0.0,1.0";  break; 
+    }
+    std::vector<std::string> quarks = {"u", "d", "s", "ubar", "dbar", "sbar"};
+    for(auto quark : quarks)
+      pythia.readString("StringSpinner:" + quark + "Polarisation = " + polStr);
+  }
+  if(targetPolarized) {
+    switch(targetSpin) {
+      case 1:  polStr = "0.0,0.0,1.0";  break;
+      case -1: polStr = "0.0,0.0,-1.0"; break;
+    }
+    pythia.readString("StringSpinner:targetPolarisation = " + polStr);
+  }
+}
+
+// Pythia with its StringSpinner hooks, which live as long as the generator,
+// set up from a runcard for one mode and seed
+struct SpinGenerator {
+  Pythia8::Pythia pythia;
+  std::shared_ptr<SimpleStringSpinner> hooks;
+  int beamSpin = 0;
+  int targetSpin = 0;
+
+  // False, after a message, when Pythia fails to initialize
+  bool init(const std::string& runCardName, int mode, int seed) {
+    hooks = std::make_shared<SimpleStringSpinner>();
+    hooks->plugInto(pythia);
+
+    // load steering file
+    pythia.readFile(runCardName);
+
+    // Seed
+    pythia.readString("Random:setSeed = on");
+    pythia.readString("Random:seed = " + std::to_string(seed));
+
+    // Choose to assign polarisations.
+    setPolarisation(pythia, mode, beamSpin, targetSpin);
+
+    if (!pythia.init()) {
+      std::cerr << "Pythia initialization failed for mode " << mode << ", seed " << seed << std::endl;
+      return false;
+    }
+    return true;
+  }
+};
+
+#endif // GENERATOR_MODES_H
@@ -0,0 +1,175 @@
+#ifndef GENERATOR_PROCESS_H
+#define GENERATOR_PROCESS_H
+
+#include "LundReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// Every generator of the programs runs in its own process. The StringSpinner
+// Fortran routines (mc3P0.o, def.o) come from the deps/stringspinner
+// submodule, whose sources are not part of this tree, so it cannot be ruled
+// out that their module variables hold per-generator state (polarisations,
+// spin density of the string decay). All Pythia instances of one process
+// would share it, in init() and in every next(), so generators with other
+// seeds or modes are never run on threads of one process. A generator sends
+// its output to the parent through a pipe.
+class GeneratorProcess {
+public:
+  // Forks a process running body with the write end of the pipe; the process
+  // exits with status 0 when body returns true. Start all processes before
+  // the parent starts any thread.
+  bool start(const std::function<bool(int)>& body) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      std::perror("pipe");
+      return false;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    pid = fork();
+    if (pid < 0) {
+      std::perror("fork");
+      close(fds[0]);
+      close(fds[1]);
+      return false;
+    }
+    if (pid == 0) {
+      // Only the parent holds the read ends, so that closing one stops its writer
+      close(fds[0]);
+      for (int other : parentEnds()) close(other);
+      bool ok = body(fds[1]);
+      close(fds[1]);
+      std::cout.flush();
+      std::cerr.flush();
+      std::fflush(nullptr);
+      _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    fd = fds[0];
+    parentEnds().push_back(fd);
+    return true;
+  }
+
+  // Read end of the pipe in the parent
+  int output() const { return fd; }
+
+  // Closes the pipe, which stops a process still writing, and returns true if
+  // the process succeeded
+  bool wait() {
+    if (fd >= 0) {
+      close(fd);
+      parentEnds().erase(std::find(parentEnds().begin(), parentEnds().end(), fd));
+    }
+    fd = -1;
+    if (pid <= 0) return false;
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+      if (errno != EINTR) return false;
+    }
+    pid = -1;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+
+private:
+  pid_t pid = -1;
+  int fd = -1;
+
+  static std::vector<int>& parentEnds() {
+    static std::vector<int> ends;
+    return ends;
+  }
+};
+
+inline bool writeAll(int fd, const void* data, std::size_t size) {
+  const char* p = (const char*)data;
+  while (size > 0) {
+    ssize_t n = write(fd, p, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+// False at the end of the pipe or on an error
+inline bool readAll(int fd, void* data, std::size_t size) {
+  char* p = (char*)data;
+  while (size > 0) {
+    ssize_t n = read(fd, p, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Messages of a generator: a length followed by that many bytes
+inline bool writeMessage(int fd, const std::string& text) {
+  std::int64_t size = text.size();
+  return writeAll(fd, &size, sizeof(size)) && writeAll(fd, text.data(), text.size());
+}
+
+inline bool readMessage(int fd, std::string& text) {
+  std::int64_t size;
+  if (!readAll(fd, &size, sizeof(size)) || size < 0) return false;
+  text.resize(size);
+  return readAll(fd, &text[0], size);
+}
+
+// A LundEvent and its number, as raw fields; both ends are the same program
+struct EventMessage {
+  std::int64_t index;
+  std::int64_t nStored; // particles that follow
+  int nParticles;
+  float mass_target;
+  int atomic_number_target;
+  int target_polarization;
+  int beam_polarization;
+  int beam_type;
+  float beam_energy;
+  int interacted_nucleon_id;
+  int process_id;
+  float event_weight;
+};
+
+inline bool writeEvent(int fd, long index, const LundEvent& event) {
+  EventMessage header = {index, (std::int64_t)event.particles.size(), event.nParticles, event.mass_target,
+                         event.atomic_number_target, event.target_polarization, event.beam_polarization,
+                         event.beam_type, event.beam_energy, event.interacted_nucleon_id, event.process_id,
+                         event.event_weight};
+  return writeAll(fd, &header, sizeof(header)) &&
+         writeAll(fd, event.particles.data(), event.particles.size() * sizeof(LundParticle));
+}
+
+inline bool readEvent(int fd, long& index, LundEvent& event) {
+  EventMessage header;
+  if (!readAll(fd, &header, sizeof(header)) || header.nStored < 0) return false;
+  index = header.index;
+  event.nParticles = header.nParticles;
+  event.mass_target = header.mass_target;
+  event.atomic_number_target = header.atomic_number_target;
+  event.target_polarization = header.target_polarization;
+  event.beam_polarization = header.beam_polarization;
+  event.beam_type = header.beam_type;
+  event.beam_energy = header.beam_energy;
+  event.interacted_nucleon_id = header.interacted_nucleon_id;
+  event.process_id = header.process_id;
+  event.event_weight = header.event_weight;
+  event.particles.resize(header.nStored);
+  return readAll(fd, event.particles.data(), header.nStored * sizeof(LundParticle));
+}
+
+#endif // GENERATOR_PROCESS_H
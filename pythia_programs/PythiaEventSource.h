@@ -0,0 +1,112 @@
+#ifndef PYTHIA_EVENT_SOURCE_H
+#define PYTHIA_EVENT_SOURCE_H
+
+#include "BoundedQueue.h"
+#include "EventAncestry.h"
+#include "EventSource.h"
+#include "GeneratorModes.h"
+#include "GeneratorProcess.h"
+#include "PythiaLundEvent.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Events of Pythia+StringSpinner generators, converted to LundEvent in memory
+// (fillLundEvent, so without the rounding to 4 decimals of the LUND files).
+// Every mode has threadsPerMode generators, seeded as those of
+// pythia8_to_gemc_lund; generator t of mode k makes the events
+// iEvent = t, t + threadsPerMode, ... < nEvent, numbered k * nEvent + iEvent.
+// Each generator is a process of its own (see GeneratorProcess.h), forked by
+// the constructor, which must run before the program starts any thread. A
+// thread per generator takes its events from the pipe into a queue of at most
+// capacity events for the analysis threads, in the order they arrive.
+class PythiaEventSource : public EventSource {
+public:
+    PythiaEventSource(const std::string& runCardName, const std::vector<int>& modes, int seed, int nEvent,
+                      int threadsPerMode, std::size_t capacity = 1024)
+    : runCardName(runCardName), modes(modes), seed(seed), queue(capacity) {
+        if (modes.empty()) throw std::runtime_error("No polarisation modes to generate");
+        if (threadsPerMode < 1) threadsPerMode = 1;
+        processes.resize(modes.size() * threadsPerMode);
+        for (std::size_t job = 0; job < modes.size(); ++job) {
+            for (int thread = 0; thread < threadsPerMode; ++thread) {
+                GeneratorProcess& process = processes[job * threadsPerMode + thread];
+                if (!process.start([&](int fd) { return generate(fd, (int)job, thread, threadsPerMode, nEvent); })) {
+                    for (auto& started : processes) started.wait();
+                    throw std::runtime_error("Cannot start the generators of " + name());
+                }
+            }
+        }
+        running = (int)processes.size();
+        for (auto& process : processes) readers.emplace_back(&PythiaEventSource::read, this, process.output());
+    }
+
+    ~PythiaEventSource() override {
+        queue.close();
+        for (auto& thread : readers) thread.join();
+    }
+
+    bool next(LundEvent& event, long& index) override {
+        std::pair<long, LundEvent> item;
+        if (!queue.pop(item)) {
+            if (failed) throw std::runtime_error("Generation failed for " + name());
+            return false;
+        }
+        index = item.first;
+        event = std::move(item.second);
+        return true;
+    }
+
+    std::string name() const override {
+        std::string list;
+        for (int mode : modes) list += (list.empty() ? "" : ",") + std::to_string(mode);
+        return "pythia:" + runCardName + ":" + list + ":" + std::to_string(seed);
+    }
+
+private:
+    std::string runCardName;
+    std::vector<int> modes;
+    int seed;
+    BoundedQueue<std::pair<long, LundEvent>> queue;
+    std::vector<GeneratorProcess> processes;
+    std::vector<std::thread> readers;
+    std::atomic<int> running{0};
+    std::atomic<bool> failed{false};
+
+    // Runs in the process of a generator
+    bool generate(int fd, int job, int thread, int threadsPerMode, int nEvent) {
+        SpinGenerator generator;
+        if (!generator.init(runCardName, modes[job], generatorSeed(seed, job * threadsPerMode + thread))) return false;
+        EventAncestry ancestry;
+        LundEvent event;
+        for (int iEvent = thread; iEvent < nEvent; iEvent += threadsPerMode) {
+            if (!generator.pythia.next()) continue;
+            fillLundEvent(event, generator.pythia, ancestry, generator.beamSpin, generator.targetSpin);
+            if (!writeEvent(fd, (long)job * nEvent + iEvent, event)) return false;
+        }
+        return true;
+    }
+
+    void read(int fd) {
+        std::pair<long, LundEvent> item;
+        while (readEvent(fd, item.first, item.second)) {
+            if (!queue.push(std::move(item))) break;
+        }
+        // The last reader to finish collects the generators, which stops
+        // those still running when the source is destroyed early, and ends
+        // the events
+        if (--running == 0) {
+            for (auto& process : processes) {
+                if (!process.wait()) failed = true;
+            }
+            queue.close();
+        }
+    }
+};
+
+#endif // PYTHIA_EVENT_SOURCE_H
@@ -0,0 +1,75 @@
+#ifndef PYTHIA_LUND_EVENT_H
+#define PYTHIA_LUND_EVENT_H
+
+#include "Pythia8/Pythia.h"
+#include "EventAncestry.h"
+#include "LundReader.h"
+
+#include <cmath>
+
+// Mass as TLorentzVector::M() computes it, negative for spacelike vectors
+inline double tlorentzvector_mass(const Pythia8::Vec4& vec){
+    double mm = vec.e()*vec.e() - (vec.px()*vec.px() + vec.py()*vec.py() + vec.pz()*vec.pz());
+    return mm < 0.0 ? -std::sqrt(-mm) : std::sqrt(mm);
+}
+
+// Fills lund with the current event of pythia as pythia8_to_gemc_lund writes
+// it, before the rounding to 4 decimals: all particles but the system
+// (PID 90), lifetime -1 for the descendants of a diquark, floats for the
+// momenta, masses and vertices (cm), and momenta and vertices below 1e-9
+// set to 0. ancestry is computed for the event.
+inline void fillLundEvent(LundEvent& lund, Pythia8::Pythia& pythia, EventAncestry& ancestry, int beamSpin, int targetSpin) {
+  Pythia8::Event& event = pythia.event;
+  const double eps = 1e-9; // Threshold for considering a value as zero
+  ancestry.compute(event);
+
+  lund.nParticles = event.size() - 1; // -1 --> accounts for PID==90, which represents the "system"
+  lund.mass_target = tlorentzvector_mass(event[2].p());
+  lund.atomic_number_target = 1; // assuming proton
+  lund.target_polarization = targetSpin;
+  lund.beam_polarization = beamSpin;
+  lund.beam_type  = event[1].id();
+  lund.beam_energy = event[1].e();
+  lund.interacted_nucleon_id = event[2].id();
+  lund.process_id = pythia.info.code();
+  lund.event_weight = pythia.info.weight();
+
+  lund.particles.clear();
+  for (int i = 0; i < event.size(); ++i){
+      const Pythia8::Particle& particle = event[i];
+      if ( particle.id() == 90 ){ continue; } // skip PID==90 (system)
+      float px = particle.px();
+      float py = particle.py();
+      float pz = particle.pz();
+      float vx = particle.xProd()/10.; // mm -> cm
+      float vy = particle.yProd()/10.; // mm -> cm
+      float vz = particle.zProd()/10.; // mm -> cm
+      
+      // Apply threshold check and adjust values
+      if (std::abs(px) < eps) px = 0.0;
+      if (std::abs(py) < eps) py = 0.0;
+      if (std::abs(pz) < eps) pz = 0.0;
+      if (std::abs(vx) < eps) vx = 0.0;
+      if (std::abs(vy) < eps) vy = 0.0;
+      if (std::abs(vz) < eps) vz = 0.0;
+
+      LundParticle p;
+      p.index = i;
+      p.lifetime = ancestry.fromDiquark(i) ? -1.0 : 1.0;
+      p.status = particle.isFinal(); // 1 --> propogate through GEANT
+      p.particle_id = particle.id();
+      p.index_of_parent = particle.mother1();
+      p.index_of_first_daughter = particle.daughter1();
+      p.px = px;
+      p.py = py;
+      p.pz = pz;
+      p.e  = (float)particle.e();
+      p.m  = (float)tlorentzvector_mass(particle.p());
+      p.vx = vx;
+      p.vy = vy;
+      p.vz = vz;
+      lund.particles.push_back(p);
+  }
+}
+
+#endif // PYTHIA_LUND_EVENT_H
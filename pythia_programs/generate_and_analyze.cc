@@ -0,0 +1,52 @@
+#include "AnalysisConfig.h"
+#include "LundAnalysis.h"
+#include "PythiaEventSource.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+// Runs the analysis of a card (see src/AnalysisConfig.h) on the events of
+// Pythia+StringSpinner generators in the same process, as pythia8_to_gemc_lund
+// followed by lund_analysis would, but without writing event files: the
+// generator processes hand the events to the analysis threads (Analysis:threads)
+// through a bounded queue (see PythiaEventSource.h).
+int main(int argc, char* argv[]) {
+  if (argc < 6 || argc > 8) {
+    std::cout << "Usage: " << argv[0] << " <path/to/analysis.card> <path/to/runcard.cmnd> <nEvent per mode> <mode[,mode...]> <seed> <optional: generator threads per mode (0: all cores)> <optional: output file>" << std::endl;
+    return 1;
+  }
+  std::string analysisCard = argv[1];
+  std::string runCardName  = argv[2];
+  int nEvent = std::atoi(argv[3]);
+  std::vector<int> modes = parseModes(argv[4]);
+  int seed   = std::atoi(argv[5]);
+  int threads = argc >= 7 ? std::atoi(argv[6]) : 1;
+  if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  if (modes.empty()) {
+      std::cerr << "Invalid mode value. Must be 0,1,2, or 3, or a comma separated list of them" << std::endl;
+      return -1;
+  }
+
+  try {
+    AnalysisConfig config = readAnalysisConfig(analysisCard);
+    if (argc == 8) config.output = argv[7];
+    if (config.output.empty()) {
+      std::cerr << "The analysis card must set Analysis:output, or it must be passed as an argument" << std::endl;
+      return 1;
+    }
+
+    // The generators are forked before the analysis sets up anything
+    PythiaEventSource source(runCardName, modes, seed, nEvent, threads);
+    LundAnalysis analysis("", config.output, config.analysisType, config.verbosity);
+    configureAnalysis(analysis, config);
+    analysis.run(source);
+  } catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
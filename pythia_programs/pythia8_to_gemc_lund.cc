@@ -1,274 +1,199 @@
 #include "Pythia8/Pythia.h"
 #include "StringSpinner.h"
-#include "TLorentzVector.h"
-#include "TVector3.h"
 #include "TString.h"
+#include "EventAncestry.h"
+#include "GeneratorFilter.h"
+#include "GeneratorModes.h"
+#include "GeneratorProcess.h"
+#include "LundFormatter.h"
+#include "PythiaLundEvent.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <iomanip> 
+#include <memory>
+#include <sstream>
+#include <thread>
 
 using namespace Pythia8;
 
-double get_mass(Vec4 vec){
-    return sqrt(pow(vec.e(),2)-pow(vec.px(),2)-pow(vec.py(),2)-pow(vec.pz(),2));
+// Appends an event in the GEMC LUND format
+void writeLundEvent(std::string& out, LundFormatter& formatter, const LundEvent& event) {
+  formatter.header(out, event.nParticles, event.mass_target, event.atomic_number_target, event.target_polarization,
+                   event.beam_polarization, event.beam_type, event.beam_energy, event.interacted_nucleon_id,
+                   event.process_id, event.event_weight);
+  for (const LundParticle& p : event.particles) {
+    formatter.particle(out, p.index, p.lifetime, p.status, p.particle_id, p.index_of_parent, p.index_of_first_daughter,
+                       p.px, p.py, p.pz, p.e, p.m, p.vx, p.vy, p.vz);
+  }
 }
 
-TLorentzVector get_tlorentzvector(Event& event, int index){
-    Vec4 vec = event[index].p();
-    TLorentzVector vec2;
-    vec2.SetPxPyPzE(vec.px(),vec.py(),vec.pz(),vec.e());
-    return vec2;
-}
+// Writes the blocks of events of a mode in the order of their events, and
+// opens a new file every eventsPerFile events (a multiple of the block size)
+class LundFileWriter {
+public:
+  LundFileWriter(const std::string& outputFilePath, const std::string& filePrefix, int eventsPerFile, int blockSize)
+    : outputFilePath(outputFilePath), filePrefix(filePrefix), eventsPerFile(eventsPerFile), blockSize(blockSize) {}
 
-// Function to check if any ancestor particle was a diquark
-bool hasDiquarkAncestor(Event& event, int currentParticleIndex) {
-    int parentIndex = event[currentParticleIndex].mother1();
-    // Base case: no parent
-    if (parentIndex <= 0) {
+  // Returns false if a file could not be opened
+  bool write(int block, const std::string& text) {
+    // Open a new file at the start or every eventsPerFile events
+    if ((long)block * blockSize % eventsPerFile == 0) {
+      if (outFile.is_open()) {
+        outFile.close(); // Close the current file if it's open
+      }
+      std::stringstream fileName;
+      fileName << outputFilePath << "/" << filePrefix
+               << std::setw(4) << std::setfill('0') << fileIndex
+               << ".dat";
+      outFile.open(fileName.str());
+      if (!outFile.is_open()) {
+        std::cerr << "Failed to open file: " << fileName.str() << std::endl;
         return false;
+      }
+      fileIndex++; // Increment fileIndex for the next file
     }
-    
-    if (event[parentIndex].isDiquark()) {
-        return true;
-    }
-    // Recursive call to check the next ancestor in the lineage
-    return hasDiquarkAncestor(event, parentIndex);
-}
+    outFile.write(text.data(), text.size());
+    return true;
+  }
+
+private:
+  std::string outputFilePath;
+  std::string filePrefix;
+  int eventsPerFile;
+  int blockSize;
+  int fileIndex = 0; // Index for file naming
+  std::ofstream outFile;
+};
 
 int main(int argc, char* argv[]) {
-  if (argc < 6) {
-    std::cout << "Usage: " << argv[0] << " <path/to/output> <path/to/runcard.cmnd> <nEvent> <mode> <seed> <optional: batch>" << std::endl;
+  if (argc < 6 || argc > 9) {
+    std::cout << "Usage: " << argv[0] << " <path/to/output> <path/to/runcard.cmnd> <nEvent> <mode[,mode...]> <seed> <optional: batch (-1: none)> <optional: threads per mode (0: all cores)> <optional: analysis card selecting the events>" << std::endl;
     return 1;
   }
   std::string outputFilePath = argv[1];
   std::string runCardName    = argv[2];
   int nEvent = std::atoi(argv[3]);
-  int mode   = std::atoi(argv[4]);
+  std::vector<int> modes = parseModes(argv[4]);
   int seed   = std::atoi(argv[5]);
   int batch  = -1;
   std::string baseFilePrefixPrefix="";
-  if (argc == 7){
+  if (argc >= 7){
       batch = std::atoi(argv[6]);
-      baseFilePrefixPrefix=Form("batch%d_",batch);
+      if (batch >= 0) baseFilePrefixPrefix=Form("batch%d_",batch);
   }
-    
-  const std::string baseFilePrefix = baseFilePrefixPrefix+"stringspinner.pythia8.gemc.lund."; // File prefix
-  std::string filePrefix;
-   
-  switch(mode){
-      case 0:
-          filePrefix = baseFilePrefix+"LU.1.";
-          break;
-      case 1:
-          filePrefix = baseFilePrefix+"LU.-1.";
-          break;
-      case 2:
-          filePrefix = baseFilePrefix+"UL.1.";
-          break;
-      case 3:
-          filePrefix = baseFilePrefix+"UL.-1.";
-          break;
-      default:
-          std::cerr << "Invalid mode value. Must be 0,1,2, or 3" << std::endl;
-          return -1;
+  int threads = argc >= 8 ? std::atoi(argv[7]) : 1;
+  if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  if (modes.empty()) {
+      std::cerr << "Invalid mode value. Must be 0,1,2, or 3, or a comma separated list of them" << std::endl;
+      return -1;
+  }
+  // Only the events with a candidate of the analysis card are written
+  std::string analysisCard = argc == 9 ? argv[8] : "";
+  AnalysisConfig selection;
+  if (!analysisCard.empty()) {
+    try {
+      selection = readAnalysisConfig(analysisCard);
+      EventSelector check(selection);
+    } catch (const std::exception& e) {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return -1;
+    }
   }
     
-  int fileIndex = 0; // Index for file naming
+  const std::string baseFilePrefix = baseFilePrefixPrefix+"stringspinner.pythia8.gemc.lund."; // File prefix
   int eventsPerFile = 100000; // Number of events per file
-    
-    
-  Pythia pythia;
-  Event& event = pythia.event;
-  auto fhooks = std::make_shared<SimpleStringSpinner>();
-  fhooks->plugInto(pythia); 
 
-  // load steering file
-  pythia.readFile(runCardName);
-    
-    
-  // Seed
-  pythia.readString("Random:setSeed = on");
-  pythia.readString("Random:seed = " + std::to_string(seed));
-    
-  // Choose to assign polarisations.
-  int beamSpin, targetSpin;
-  bool beamPolarized   = false;
-  bool targetPolarized = false;
-  switch(mode) {
-    case 0: // LU, spin +
-      beamPolarized = true;
-      beamSpin      = 1;
-      targetSpin    = 0;
-      break;
-    case 1: // LU, spin -
-      beamPolarized = true;
-      beamSpin      = -1;
-      targetSpin    = 0;
-      break;
-    case 2: // UL, spin +
-      targetPolarized = true;
-      beamSpin        = 0;
-      targetSpin      = 1;
-      break;
-    case 3: // UL, spin -
-      targetPolarized = true;
-      beamSpin        = 0;
-      targetSpin      = -1;
-      break;
-  }
-    
-  
-  std::string polStr;
-  Vec4 SNucleon;
-  if(beamPolarized) {
-    switch(beamSpin) {
-      case 1:  polStr = "0.0,0.0,-1.0"; break; // minus sign, since quark momentum is reversed after hard scattering
-      case -1: polStr = "0.0,0.0,1.0";  break; 
+  // Each mode writes nEvent events, or those selected among them, into its own files. The events of a mode
+  // are generated in blocks, block b by generator b % threads of the mode, each
+  // generator a process (see GeneratorProcess.h) with its own Pythia and seed, so
+  // the files depend only on the seed, the list of modes and the number of
+  // threads. Blocks never straddle two files.
+  int blockSize = std::min(1000, std::max(1, nEvent / (4 * threads)));
+  while (eventsPerFile % blockSize != 0) blockSize--;
+  int nBlocks = (nEvent + blockSize - 1) / blockSize;
+  std::vector<FilterCounts> counts(modes.size());
+
+  // A generator sends its blocks of formatted events, then its numbers of
+  // generated and selected events
+  auto generate = [&](int job, int thread, int fd) {
+    SpinGenerator generator;
+    if (!generator.init(runCardName, modes[job], generatorSeed(seed, job * threads + thread))) return false;
+    Pythia* pythia = &generator.pythia;
+    EventAncestry ancestry;
+    LundEvent lund;
+    std::unique_ptr<EventSelector> selector;
+    if (!analysisCard.empty()) selector.reset(new EventSelector(selection));
+
+    // Begin event loop.
+    for (int block = thread; block < nBlocks; block += threads) {
+      std::string text;
+      // In the serial program only the first header of all is not in fixed format
+      LundFormatter formatter(block > 0);
+      int end = std::min(nEvent, (block + 1) * blockSize);
+      for (int iEvent = block * blockSize; iEvent < end; ++iEvent) {
+        if (!pythia->next()) continue;
+
+        // Listings of the first mode only, not to interleave them
+        if (iEvent < 20 && job == 0){pythia->event.list();}
+
+        fillLundEvent(lund, *pythia, ancestry, generator.beamSpin, generator.targetSpin);
+        if (selector && !selector->select(lund)) continue;
+        writeLundEvent(text, formatter, lund);
+      }
+      if (!writeMessage(fd, text)) return false;
     }
-    std::vector<std::string> quarks = {"u", "d", "s", "ubar", "dbar", "sbar"};
-    for(auto quark : quarks)
-      pythia.readString("StringSpinner:" + quark + "Polarisation = " + polStr);
-  }
-  if(targetPolarized) {
-    SNucleon.p(0.0, 0.0, (double)targetSpin, 0.0);
-    switch(targetSpin) {
-      case 1:  polStr = "0.0,0.0,1.0";  break;
-      case -1: polStr = "0.0,0.0,-1.0"; break;
+    std::uint64_t numbers[2] = {selector ? selector->generated() : 0, selector ? selector->accepted() : 0};
+    return writeAll(fd, numbers, sizeof(numbers));
+  };
+
+  std::vector<GeneratorProcess> processes(modes.size() * threads);
+  std::atomic<bool> failed(false);
+  for (std::size_t job = 0; job < modes.size() && !failed; ++job) {
+    for (int thread = 0; thread < threads && !failed; ++thread) {
+      if (!processes[job * threads + thread].start([&](int fd) { return generate(job, thread, fd); })) failed = true;
     }
-    pythia.readString("StringSpinner:targetPolarisation = " + polStr);
   }
-  
-    
-   
-  // Initialize.
-  pythia.init();
 
-    
-  // Header variables for LUND
-  int nParticles;
-  float mass_target;
-  int atomic_number_target = 1; // assuming proton
-  int target_polarization = targetSpin;
-  int beam_polarization = beamSpin;
-  int beam_type;
-  float beam_energy;
-  int interacted_nucleon_id;
-  int process_id;
-  float event_weight;
-    
-  // Particle variables for LUND GEMC
-  int index;
-  float lifetime;
-  int status;
-  int particle_id;
-  int index_of_parent;
-  int index_of_first_daughter;
-  int index_of_grandparent;
-  float px;
-  float py;
-  float pz;
-  float e;
-  float m;
-  float vx;
-  float vy;
-  float vz;
-    
-  const double eps = 1e-9; // Threshold for considering a value as zero
-  // Begin event loop.
-  std::ofstream outFile;
-  for (int iEvent = 0; iEvent < nEvent; ++iEvent) {
-    // Open a new file at the start or every eventsPerFile events
-    if (iEvent % eventsPerFile == 0) {
-        if (outFile.is_open()) {
-            outFile.close(); // Close the current file if it's open
-        }
-        std::stringstream fileName;
-        fileName << outputFilePath << "/" << filePrefix
-                 << std::setw(4) << std::setfill('0') << fileIndex
-                 << ".dat";
-        outFile.open(fileName.str());
-        if (!outFile.is_open()) {
-            std::cerr << "Failed to open file: " << fileName.str() << std::endl;
-            return -1; // or handle error appropriately
-        }
-        fileIndex++; // Increment fileIndex for the next file
+  // The blocks of a mode are written by one thread, taking them from the
+  // generators in turn
+  auto collect = [&](int job) {
+    LundFileWriter writer(outputFilePath, baseFilePrefix + modeFileTag(modes[job]), eventsPerFile, blockSize);
+    GeneratorProcess* generators = &processes[job * threads];
+    std::string text;
+    for (int block = 0; block < nBlocks && !failed; ++block) {
+      if (!readMessage(generators[block % threads].output(), text) || !writer.write(block, text)) {
+        failed = true;
+        return;
+      }
     }
-
-    if (!pythia.next()) continue;
-
-    if (iEvent < 20){event.list();}
-   
-    TLorentzVector init_lepton = get_tlorentzvector(event,1);
-    TLorentzVector init_target = get_tlorentzvector(event,2);
-    TLorentzVector scattered_lepton = get_tlorentzvector(event,5);
-    TLorentzVector q = init_lepton - scattered_lepton;
-    
-    nParticles = event.size() - 1; // -1 --> accounts for PID==90, which represents the "system"
-    mass_target = init_target.M();
-    beam_type  = event[1].id();
-    beam_energy = init_lepton.E();
-    interacted_nucleon_id = event[2].id();
-    process_id = pythia.info.code();
-    event_weight = pythia.info.weight();
-      
-    // Assuming outFile is an std::ofstream and is already open
-outFile << "\t" << std::left << std::setw(8) << nParticles << std::setw(8) << mass_target << std::setw(8) << atomic_number_target << std::setw(8) << target_polarization << std::setw(8) << beam_polarization << std::setw(8) << beam_type << std::setw(8) << beam_energy << std::setw(8) << interacted_nucleon_id << std::setw(8) << process_id << std::setw(8) << event_weight << "\n";
-
-    // Loop inside the event output.
-    for (int i = 0; i < event.size(); ++i){
-        TLorentzVector particle = get_tlorentzvector(event,i);
-        index = i;
-        status      = event[i].isFinal(); // 1 --> propogate through GEANT
-        particle_id = event[i].id();
-        if ( particle_id == 90 ){ continue; } // skip PID==90 (system)
-        index_of_parent = event[i].mother1();
-        
-        // Use the recursive function to check for an ancestor diquark
-        if (hasDiquarkAncestor(event, i)) {
-            lifetime = -1.0; // If true, set lifetime to -1
-        }else{
-            lifetime = 1.0;
-        }
-        
-        index_of_first_daughter = event[i].daughter1();
-        px = particle.Px();
-        py = particle.Py();
-        pz = particle.Pz();
-        e  = particle.E();
-        m  = particle.M();
-        vx = event[i].xProd()/10.; // mm -> cm
-        vy = event[i].yProd()/10.; // mm -> cm
-        vz = event[i].zProd()/10.; // mm -> cm
-        
-        // Apply threshold check and adjust values
-        if (std::abs(px) < eps) px = 0.0;
-        if (std::abs(py) < eps) py = 0.0;
-        if (std::abs(pz) < eps) pz = 0.0;
-        if (std::abs(vx) < eps) vx = 0.0;
-        if (std::abs(vy) < eps) vy = 0.0;
-        if (std::abs(vz) < eps) vz = 0.0;
-        
-        // Output using fixed and setprecision
-        outFile << std::right << std::setw(4) << index 
-                << std::setw(8) << std::setprecision(1) << std::fixed << lifetime 
-                << std::setw(4) << status 
-                << std::setw(8) << particle_id 
-                << std::setw(8) << index_of_parent 
-                << std::setw(8) << index_of_first_daughter 
-                << std::setw(12) << std::setprecision(4) << std::fixed << px 
-                << std::setw(12) << std::setprecision(4) << std::fixed << py 
-                << std::setw(12) << std::setprecision(4) << std::fixed << pz 
-                << std::setw(12) << std::setprecision(4) << std::fixed << e 
-                << std::setw(12) << std::setprecision(4) << std::fixed << m 
-                << std::setw(12) << std::setprecision(4) << std::fixed << vx 
-                << std::setw(12) << std::setprecision(4) << std::fixed << vy 
-                << std::setw(12) << std::setprecision(4) << std::fixed << vz << "\n";
+    for (int thread = 0; thread < threads && !failed; ++thread) {
+      std::uint64_t numbers[2];
+      if (!readAll(generators[thread].output(), numbers, sizeof(numbers))) {
+        failed = true;
+        return;
+      }
+      counts[job].add(numbers[0], numbers[1]);
     }
+  };
+
+  if (!failed) {
+    std::vector<std::thread> pool;
+    for (std::size_t job = 1; job < modes.size(); ++job) pool.emplace_back(collect, job);
+    collect(0);
+    for (auto& thread : pool) thread.join();
   }
-    
-  if (outFile.is_open()) {
-    outFile.close(); // Make sure to close the last file
+  // Closing the pipes stops the generators of a failed run
+  for (auto& process : processes) {
+    if (!process.wait()) failed = true;
+  }
+  if (!analysisCard.empty() && !failed) {
+    for (std::size_t job = 0; job < modes.size(); ++job) {
+      if (!counts[job].write(outputFilePath, baseFilePrefix + modeFileTag(modes[job]), analysisCard)) failed = true;
+    }
   }
     
-  return 0;
-}
\ No newline at end of file
+  return failed ? -1 : 0;
+}
@@ -5,9 +5,18 @@
 #include "TString.h"
 #include "TFile.h"
 #include "TTree.h"
+#include "RNTupleSupport.h"
+#include "EventAncestry.h"
+#include "GeneratorFilter.h"
+#include "GeneratorModes.h"
+#include "GeneratorProcess.h"
+#include "PythiaLundEvent.h"
 
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iomanip> 
+#include <memory>
 
 using namespace Pythia8;
 
@@ -22,128 +31,46 @@ TLorentzVector get_tlorentzvector(Event& event, int index){
     return vec2;
 }
 
-// Function to check if any ancestor particle was a diquark
-bool hasDiquarkAncestor(Event& event, int currentParticleIndex) {
-    int parentIndex = event[currentParticleIndex].mother1();
-    // Base case: no parent
-    if (parentIndex <= 0) {
-        return false;
+#ifdef SPINTHYIA_HAS_RNTUPLE
+// RNTuple with the columns of the TTree, bound to the same variables:
+// the event header as scalar fields, the particles as collections
+struct NTupleOutput {
+    std::unique_ptr<ROOT::RNTupleModel> model = ROOT::RNTupleModel::Create();
+    std::vector<std::function<void(ROOT::REntry&)>> bindings;
+    std::unique_ptr<ROOT::RNTupleWriter> writer;
+    std::unique_ptr<ROOT::REntry> entry;
+
+    template<class T>
+    void Branch(const char* name, T* address) {
+        model->MakeField<T>(name);
+        bindings.push_back([name, address](ROOT::REntry& e) { e.BindRawPtr(name, address); });
     }
-    
-    if (event[parentIndex].isDiquark()) {
-        return true;
+    void open(const std::string& fileName) {
+        writer = ROOT::RNTupleWriter::Recreate(std::move(model), "tree", fileName);
+        entry = writer->CreateEntry();
+        for (const auto& bind : bindings) bind(*entry);
     }
-    // Recursive call to check the next ancestor in the lineage
-    return hasDiquarkAncestor(event, parentIndex);
-}
+    void Fill() { writer->Fill(*entry); }
+    // Writes the footer and closes the file
+    void Write() {
+        entry.reset();
+        writer.reset();
+    }
+};
+#endif
 
-int main(int argc, char* argv[]) {
-  if (argc < 6) {
-    std::cout << "Usage: " << argv[0] << " <path/to/output> <path/to/runcard.cmnd> <nEvent> <mode> <seed> <optional: batch>" << std::endl;
-    return 1;
-  }
-  std::string outputFilePath = argv[1];
-  std::string runCardName    = argv[2];
-  int nEvent = std::atoi(argv[3]);
-  int mode   = std::atoi(argv[4]);
-  int seed   = std::atoi(argv[5]);
-  int batch  = -1;
-  std::string baseFilePrefixPrefix="";
-  if (argc == 7){
-      batch = std::atoi(argv[6]);
-      baseFilePrefixPrefix=Form("batch%d_",batch);
-  }
-    
-  const std::string baseFilePrefix = baseFilePrefixPrefix+"stringspinner.pythia8.gemc.lund."; // File prefix
-  std::string filePrefix;
-   
-  switch(mode){
-      case 0:
-          filePrefix = baseFilePrefix+"LU.1.";
-          break;
-      case 1:
-          filePrefix = baseFilePrefix+"LU.-1.";
-          break;
-      case 2:
-          filePrefix = baseFilePrefix+"UL.1.";
-          break;
-      case 3:
-          filePrefix = baseFilePrefix+"UL.-1.";
-          break;
-      default:
-          std::cerr << "Invalid mode value. Must be 0,1,2, or 3" << std::endl;
-          return -1;
-  }
-    
-  int fileIndex = 0; // Index for file naming
-  int eventsPerFile = 100000; // Number of events per file
-    
-    
-  Pythia pythia;
+// Generates the nEvent events of a mode into <outputFilePath>/<filePrefix>0000.root;
+// with an analysis card only those selected by it (see EventSelector). False
+// when Pythia fails to initialize.
+bool generateMode(std::string outputFilePath, std::string runCardName, int nEvent, int mode, int seed,
+                  std::string filePrefix, std::string format, bool listEvents,
+                  std::string analysisCard, const AnalysisConfig& selection, FilterCounts& counts) {
+  SpinGenerator generator;
+  if (!generator.init(runCardName, mode, seed)) return false;
+  Pythia& pythia = generator.pythia;
   Event& event = pythia.event;
-  auto fhooks = std::make_shared<SimpleStringSpinner>();
-  fhooks->plugInto(pythia); 
-
-  // load steering file
-  pythia.readFile(runCardName);
-    
-    
-  // Seed
-  pythia.readString("Random:setSeed = on");
-  pythia.readString("Random:seed = " + std::to_string(seed));
-    
-  // Choose to assign polarisations.
-  int beamSpin, targetSpin;
-  bool beamPolarized   = false;
-  bool targetPolarized = false;
-  switch(mode) {
-    case 0: // LU, spin +
-      beamPolarized = true;
-      beamSpin      = 1;
-      targetSpin    = 0;
-      break;
-    case 1: // LU, spin -
-      beamPolarized = true;
-      beamSpin      = -1;
-      targetSpin    = 0;
-      break;
-    case 2: // UL, spin +
-      targetPolarized = true;
-      beamSpin        = 0;
-      targetSpin      = 1;
-      break;
-    case 3: // UL, spin -
-      targetPolarized = true;
-      beamSpin        = 0;
-      targetSpin      = -1;
-      break;
-  }
-    
-  
-  std::string polStr;
-  Vec4 SNucleon;
-  if(beamPolarized) {
-    switch(beamSpin) {
-      case 1:  polStr = "0.0,0.0,-1.0"; break; // minus sign, since quark momentum is reversed after hard scattering
-      case -1: polStr = "0.0,0.0,1.0";  break; 
-    }
-    std::vector<std::string> quarks = {"u", "d", "s", "ubar", "dbar", "sbar"};
-    for(auto quark : quarks)
-      pythia.readString("StringSpinner:" + quark + "Polarisation = " + polStr);
-  }
-  if(targetPolarized) {
-    SNucleon.p(0.0, 0.0, (double)targetSpin, 0.0);
-    switch(targetSpin) {
-      case 1:  polStr = "0.0,0.0,1.0";  break;
-      case -1: polStr = "0.0,0.0,-1.0"; break;
-    }
-    pythia.readString("StringSpinner:targetPolarisation = " + polStr);
-  }
-  
-    
-   
-  // Initialize.
-  pythia.init();
+  int beamSpin = generator.beamSpin;
+  int targetSpin = generator.targetSpin;
 
     
   // Header variables for LUND
@@ -194,38 +121,59 @@ int main(int argc, char* argv[]) {
   float _vz;
   
   std::string fileName = outputFilePath + "/" + filePrefix + "0000.root";
-  TFile * fOut = new TFile(fileName.c_str(),"RECREATE");
-  TTree *tree  = new TTree("tree","tree");
-  // Header variables for LUND
-  tree->Branch("nParticles", &nParticles);
-  tree->Branch("mass_target", &mass_target);
-  tree->Branch("atomic_number_target", &atomic_number_target);
-  tree->Branch("target_polarization", &target_polarization);
-  tree->Branch("beam_polarization", &beam_polarization);
-  tree->Branch("beam_type", &beam_type);
-  tree->Branch("beam_energy", &beam_energy);
-  tree->Branch("interacted_nucleon_id", &interacted_nucleon_id);
-  tree->Branch("process_id", &process_id);
-  tree->Branch("event_weight", &event_weight);
+  // The same columns for the TTree and the RNTuple
+  auto declareColumns = [&](auto* output) {
+    // Header variables for LUND
+    output->Branch("nParticles", &nParticles);
+    output->Branch("mass_target", &mass_target);
+    output->Branch("atomic_number_target", &atomic_number_target);
+    output->Branch("target_polarization", &target_polarization);
+    output->Branch("beam_polarization", &beam_polarization);
+    output->Branch("beam_type", &beam_type);
+    output->Branch("beam_energy", &beam_energy);
+    output->Branch("interacted_nucleon_id", &interacted_nucleon_id);
+    output->Branch("process_id", &process_id);
+    output->Branch("event_weight", &event_weight);
 
-  // Particle variables for LUND GEMC
-  tree->Branch("index", &index);
-  tree->Branch("lifetime", &lifetime);
-  tree->Branch("status", &status);
-  tree->Branch("particle_id", &particle_id);
-  tree->Branch("index_of_parent", &index_of_parent);
-  tree->Branch("index_of_first_daughter", &index_of_first_daughter);
-  tree->Branch("index_of_grandparent", &index_of_grandparent);
-  tree->Branch("px", &px);
-  tree->Branch("py", &py);
-  tree->Branch("pz", &pz);
-  tree->Branch("e", &e);
-  tree->Branch("m", &m);
-  tree->Branch("vx", &vx);
-  tree->Branch("vy", &vy);
-  tree->Branch("vz", &vz);
+    // Particle variables for LUND GEMC
+    output->Branch("index", &index);
+    output->Branch("lifetime", &lifetime);
+    output->Branch("status", &status);
+    output->Branch("particle_id", &particle_id);
+    output->Branch("index_of_parent", &index_of_parent);
+    output->Branch("index_of_first_daughter", &index_of_first_daughter);
+    output->Branch("index_of_grandparent", &index_of_grandparent);
+    output->Branch("px", &px);
+    output->Branch("py", &py);
+    output->Branch("pz", &pz);
+    output->Branch("e", &e);
+    output->Branch("m", &m);
+    output->Branch("vx", &vx);
+    output->Branch("vy", &vy);
+    output->Branch("vz", &vz);
+  };
+
+  TFile * fOut = 0;
+  TTree *tree  = 0;
+#ifdef SPINTHYIA_HAS_RNTUPLE
+  std::unique_ptr<NTupleOutput> ntuple;
+  if (format == "RNTuple") {
+    ntuple.reset(new NTupleOutput);
+    declareColumns(ntuple.get());
+    ntuple->open(fileName);
+  }
+#endif
+  if (format == "TTree") {
+    fOut = new TFile(fileName.c_str(),"RECREATE");
+    tree = new TTree("tree","tree");
+    declareColumns(tree);
+  }
   
   const double eps = 1e-9; // Threshold for considering a value as zero
+  EventAncestry ancestry;
+  LundEvent lund;
+  std::unique_ptr<EventSelector> selector;
+  if (!analysisCard.empty()) selector.reset(new EventSelector(selection));
   
   for (int iEvent = 0; iEvent < nEvent; ++iEvent) {
     
@@ -247,7 +195,13 @@ int main(int argc, char* argv[]) {
 
     if (!pythia.next()) continue;
 
-    if (iEvent < 20){event.list();}
+    if (iEvent < 20 && listEvents){event.list();}
+    if (selector) {
+      fillLundEvent(lund, pythia, ancestry, beamSpin, targetSpin);
+      if (!selector->select(lund)) continue;
+    } else {
+      ancestry.compute(event);
+    }
    
     TLorentzVector init_lepton = get_tlorentzvector(event,1);
     TLorentzVector init_target = get_tlorentzvector(event,2);
@@ -271,9 +225,10 @@ int main(int argc, char* argv[]) {
         _particle_id = event[i].id();
         if ( _particle_id == 90 ){ continue; } // skip PID==90 (system)
         _index_of_parent = event[i].mother1();
+        _index_of_grandparent = ancestry.grandparent(i);
         
-        // Use the recursive function to check for an ancestor diquark
-        if (hasDiquarkAncestor(event, i)) {
+        // Check for an ancestor diquark
+        if (ancestry.fromDiquark(i)) {
             _lifetime = -1.0; // If true, set lifetime to -1
         }else{
             _lifetime = 1.0;
@@ -294,6 +249,7 @@ int main(int argc, char* argv[]) {
         status.push_back(_status);
         particle_id.push_back(_particle_id);
         index_of_parent.push_back(_index_of_parent);
+        index_of_grandparent.push_back(_index_of_grandparent);
         index_of_first_daughter.push_back(_index_of_first_daughter);
         px.push_back(_px);
         py.push_back(_py);
@@ -306,12 +262,99 @@ int main(int argc, char* argv[]) {
         
     }
     
-    tree->Fill();
+#ifdef SPINTHYIA_HAS_RNTUPLE
+    if (ntuple) ntuple->Fill();
+#endif
+    if (tree) tree->Fill();
   }
   
-  fOut->cd();
-  tree->Write();
-  fOut->Close();
+#ifdef SPINTHYIA_HAS_RNTUPLE
+  if (ntuple) ntuple->Write();
+#endif
+  if (tree) {
+    fOut->cd();
+    tree->Write();
+    fOut->Close();
+  }
+  if (selector) counts.add(*selector);
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 6 || argc > 9) {
+    std::cout << "Usage: " << argv[0] << " <path/to/output> <path/to/runcard.cmnd> <nEvent> <mode[,mode...]> <seed> <optional: batch (-1: none)> <optional: TTree | RNTuple> <optional: analysis card selecting the events>" << std::endl;
+    return 1;
+  }
+  std::string outputFilePath = argv[1];
+  std::string runCardName    = argv[2];
+  int nEvent = std::atoi(argv[3]);
+  std::vector<int> modes = parseModes(argv[4]);
+  int seed   = std::atoi(argv[5]);
+  int batch  = -1;
+  std::string baseFilePrefixPrefix="";
+  if (argc >= 7){
+      batch = std::atoi(argv[6]);
+      if (batch >= 0) baseFilePrefixPrefix=Form("batch%d_",batch);
+  }
+  std::string format = argc >= 8 ? argv[7] : "TTree";
+  if (format != "TTree" && format != "RNTuple") {
+      std::cerr << "Invalid output format " << format << ". Must be TTree or RNTuple" << std::endl;
+      return -1;
+  }
+#ifndef SPINTHYIA_HAS_RNTUPLE
+  if (format == "RNTuple") {
+      std::cerr << "RNTuple output needs ROOT 6.36 or later" << std::endl;
+      return -1;
+  }
+#endif
+    
+  const std::string baseFilePrefix = baseFilePrefixPrefix+"stringspinner.pythia8.gemc.lund."; // File prefix
+  if (modes.empty()) {
+      std::cerr << "Invalid mode value. Must be 0,1,2, or 3, or a comma separated list of them" << std::endl;
+      return -1;
+  }
+
+  // Only the events with a candidate of the analysis card are written
+  std::string analysisCard = argc == 9 ? argv[8] : "";
+  AnalysisConfig selection;
+  if (!analysisCard.empty()) {
+    try {
+      selection = readAnalysisConfig(analysisCard);
+      EventSelector check(selection);
+    } catch (const std::exception& e) {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return -1;
+    }
+  }
+
+  // One process (see GeneratorProcess.h), Pythia and output file per mode; a
+  // process sends its numbers of generated and selected events
+  std::vector<FilterCounts> counts(modes.size());
+  std::vector<GeneratorProcess> processes(modes.size());
+  bool failed = false;
+  for (std::size_t job = 0; job < modes.size() && !failed; ++job) {
+    failed = !processes[job].start([&](int fd) {
+      // Listings of the first mode only, not to interleave them
+      if (!generateMode(outputFilePath, runCardName, nEvent, modes[job], generatorSeed(seed, job),
+                        baseFilePrefix + modeFileTag(modes[job]), format, job == 0, analysisCard, selection,
+                        counts[job])) return false;
+      std::uint64_t numbers[2] = {counts[job].generated, counts[job].accepted};
+      return writeAll(fd, numbers, sizeof(numbers));
+    });
+  }
+  for (std::size_t job = 0; job < modes.size(); ++job) {
+    std::uint64_t numbers[2];
+    if (!failed && readAll(processes[job].output(), numbers, sizeof(numbers))) {
+      counts[job].add(numbers[0], numbers[1]);
+    }
+    if (!processes[job].wait()) failed = true;
+  }
+  if (failed) return -1;
+  if (!analysisCard.empty()) {
+    for (std::size_t job = 0; job < modes.size(); ++job) {
+      if (!counts[job].write(outputFilePath, baseFilePrefix + modeFileTag(modes[job]), analysisCard)) return -1;
+    }
+  }
     
   return 0;
 }
\ No newline at end of file
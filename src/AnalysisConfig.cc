@@ -0,0 +1,274 @@
+#include "AnalysisConfig.h"
+#include "LundAnalysis.h"
+#include "Compression.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string trim(const std::string& s) {
+    const char* whitespace = " \t\r\n";
+    size_t first = s.find_first_not_of(whitespace);
+    if (first == std::string::npos) return "";
+    size_t last = s.find_last_not_of(whitespace);
+    return s.substr(first, last - first + 1);
+}
+
+HadroniumAnalysisType parseAnalysisType(const std::string& value) {
+    if (value == "SingleHadron") return HadroniumAnalysisType::SingleHadron;
+    if (value == "DiHadron") return HadroniumAnalysisType::DiHadron;
+    if (value == "TriHadron") return HadroniumAnalysisType::TriHadron;
+    throw std::runtime_error("Unknown analysis type: " + value);
+}
+
+AcceptanceType parseAcceptance(const std::string& value) {
+    if (value == "ALL") return AcceptanceType::ALL;
+    if (value == "CLAS12") return AcceptanceType::CLAS12;
+    throw std::runtime_error("Unknown acceptance type: " + value);
+}
+
+RelationshipType parseRelationship(const std::string& value) {
+    if (value == "SameParentId") return RelationshipType::SameParentId;
+    if (value == "ParentIdAsOtherGrandParentId") return RelationshipType::ParentIdAsOtherGrandParentId;
+    if (value == "GrandParentIdAsOtherParentId") return RelationshipType::GrandParentIdAsOtherParentId;
+    if (value == "SameGrandParentId") return RelationshipType::SameGrandParentId;
+    throw std::runtime_error("Unknown relationship type: " + value);
+}
+
+KinematicCut parseCut(const std::string& variable, const std::string& value) {
+    std::istringstream iss(value);
+    std::string type;
+    double v1, v2;
+    iss >> type;
+    if (type == "min" && iss >> v1) return KinematicCut(variable, KinematicCut::CutType::MIN, v1);
+    if (type == "max" && iss >> v1) return KinematicCut(variable, KinematicCut::CutType::MAX, v1);
+    if (type == "range" && iss >> v1 >> v2) return KinematicCut(variable, v1, v2);
+    throw std::runtime_error("Malformed cut on " + variable + ": " + value);
+}
+
+OutputFormat parseOutputFormat(const std::string& value) {
+    if (value == "ROOT") return OutputFormat::ROOT;
+    if (value == "columnar") return OutputFormat::Columnar;
+    if (value == "RNTuple") return OutputFormat::RNTuple;
+    if (value == "none") return OutputFormat::None;
+    throw std::runtime_error("Unknown output format: " + value);
+}
+
+OutputLayout parseOutputLayout(const std::string& value) {
+    if (value == "rows") return OutputLayout::Rows;
+    if (value == "events") return OutputLayout::Events;
+    throw std::runtime_error("Unknown output layout: " + value);
+}
+
+int parseCompression(const std::string& value) {
+    std::istringstream iss(value);
+    std::string algorithm;
+    int level = 1;
+    iss >> algorithm >> level;
+    if (algorithm == "none") return 0;
+    if (algorithm == "ZLIB") return ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kZLIB, level);
+    if (algorithm == "LZMA") return ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kLZMA, level);
+    if (algorithm == "LZ4") return ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kLZ4, level);
+    if (algorithm == "ZSTD") return ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kZSTD, level);
+    throw std::runtime_error("Unknown compression algorithm: " + value);
+}
+
+void parsePrecision(const std::string& value, OutputOptions& options) {
+    std::istringstream iss(value);
+    std::string column, type;
+    ColumnPrecision precision;
+    iss >> column >> type;
+    if (type == "float") {
+        precision.type = ColumnPrecision::Type::Float;
+    } else if (type == "double32") {
+        precision.type = ColumnPrecision::Type::Double32;
+        if (iss >> precision.min && !(iss >> precision.max >> precision.bits)) {
+            throw std::runtime_error("Malformed Double32 range of " + column + ": " + value);
+        }
+    } else {
+        throw std::runtime_error("Malformed precision: " + value);
+    }
+    options.precision[column] = precision;
+}
+
+} // namespace
+
+AnalysisConfig readAnalysisConfig(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        throw std::runtime_error("Unable to open analysis card: " + filename);
+    }
+
+    AnalysisConfig config;
+    bool storeGiven = false;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        // Everything after a '!' is a comment, as in the Pythia runcards
+        line = trim(line.substr(0, line.find('!')));
+        if (line.empty()) continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": expected 'key = value'");
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+
+        if (key == "Analysis:input") config.input = value;
+        else if (key == "Analysis:output") config.output = value;
+        else if (key == "Analysis:type") config.analysisType = parseAnalysisType(value);
+        else if (key == "Analysis:criteria") config.criteria = value;
+        else if (key == "Analysis:acceptance") config.acceptance = parseAcceptance(value);
+        else if (key == "Analysis:verbosity") config.verbosity = std::stoi(value);
+        else if (key == "Analysis:threads") config.threads = std::stoi(value);
+        else if (key == "Filter:particleCondition") {
+            std::istringstream iss(value);
+            ParticleCondition condition;
+            if (!(iss >> condition.requiredParentPid >> condition.requiredGrandParentPid)) {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": malformed particle condition");
+            }
+            config.rules.addParticleCondition(condition);
+        }
+        else if (key == "Filter:relationship") {
+            std::istringstream iss(value);
+            size_t index1, index2;
+            std::string type;
+            if (!(iss >> index1 >> index2)) {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": malformed relationship");
+            }
+            ParentIdRelationship relationship(index1, index2, {});
+            while (iss >> type) relationship.types.push_back(parseRelationship(type));
+            config.rules.addParentIdRelationship(relationship);
+        }
+        else if (key == "Analysis:cacheDirectory") config.cacheDirectory = value;
+        else if (key == "Analysis:candidateCache") config.candidateCache = value;
+        else if (key == "Progressive:checkpointInterval") config.checkpointInterval = std::stoi(value);
+        else if (key == "Progressive:targetError") config.targetError = std::stod(value);
+        else if (key == "FastSim:map") config.fastSimulationMap = value;
+        else if (key == "FastSim:seed") config.fastSimulationSeed = std::stoull(value);
+        else if (key == "Output:format") config.outputOptions.format = parseOutputFormat(value);
+        else if (key == "Output:layout") config.outputOptions.layout = parseOutputLayout(value);
+        else if (key == "Output:compression") config.outputOptions.compression = parseCompression(value);
+        else if (key == "Output:basketSize") config.outputOptions.basketSize = std::stoi(value);
+        else if (key == "Output:autoFlush") config.outputOptions.autoFlush = std::stoll(value);
+        else if (key == "Output:autoSave") config.outputOptions.autoSave = std::stoll(value);
+        else if (key == "Output:maxFileSize") config.outputOptions.maxFileSize = std::stoll(value);
+        else if (key == "Output:precision") parsePrecision(value, config.outputOptions);
+        else if (key == "Output:provenance") {
+            if (value != "true" && value != "false") {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": expected true or false");
+            }
+            config.provenance = value == "true";
+        }
+        else if (key == "Skim:output") config.skimOutput = value;
+        else if (key == "Skim:input") config.skimInput = value;
+        else if (key == "Bootstrap:replicas") config.bootstrapReplicas = std::stoi(value);
+        else if (key == "Bootstrap:seed") config.bootstrapSeed = std::stoull(value);
+        else if (key == "Bootstrap:store") {
+            if (value != "true" && value != "false") {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": expected true or false");
+            }
+            config.storeReplicaWeights = value == "true";
+            storeGiven = true;
+        }
+        else if (key == "Moments:output") config.momentsOutput = value;
+        else if (key == "Moments:axis") {
+            std::istringstream iss(value);
+            std::string column;
+            std::vector<double> edges;
+            double edge;
+            iss >> column;
+            while (iss >> edge) edges.push_back(edge);
+            if (!iss.eof()) {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": malformed bin edges");
+            }
+            config.moments.addAxis(column, edges);
+        }
+        else if (key == "Moments:moment") config.moments.addMoment(value);
+        else if (key == "Moments:weight") config.moments.setWeight(value);
+        else if (key == "Mixing:depth") config.mixing.setDepth(std::stoi(value));
+        else if (key == "Mixing:capacity") config.mixing.setCapacity(std::stoi(value));
+        else if (key == "Mixing:output") config.mixingOutput = value;
+        else if (key == "Mixing:axis") {
+            std::istringstream iss(value);
+            std::string variable;
+            std::vector<double> edges;
+            double edge;
+            iss >> variable;
+            while (iss >> edge) edges.push_back(edge);
+            if (!iss.eof()) {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": malformed bin edges");
+            }
+            config.mixing.addAxis(variable, edges);
+        }
+        else if (key.compare(0, 4, "Cut:") == 0) {
+            config.cuts.push_back(parseCut(key.substr(4), value));
+        }
+        else {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": unknown key '" + key + "'");
+        }
+    }
+
+    if (config.criteria.empty()) {
+        throw std::runtime_error("Analysis card " + filename + " does not set Analysis:criteria");
+    }
+    // The columnar format cannot hold the replicaWeights collection
+    if (config.bootstrapReplicas > 0 && config.outputOptions.format == OutputFormat::Columnar) {
+        if (storeGiven && config.storeReplicaWeights) {
+            throw std::runtime_error("Analysis card " + filename + ": Bootstrap:store = true needs a ROOT or RNTuple output, the columnar format cannot store the replicaWeights collection");
+        }
+        config.storeReplicaWeights = false;
+    }
+    return config;
+}
+
+void configureAnalysis(LundAnalysis& analysis, const AnalysisConfig& config) {
+    analysis.setCriteria(config.criteria);
+    analysis.setFilterRules(config.rules);
+    for (const auto& cut : config.cuts) {
+        analysis.addKinematicCut(cut);
+    }
+    if (config.acceptance == AcceptanceType::CLAS12) {
+        analysis.setCLAS12();
+    }
+    if (!config.cacheDirectory.empty()) {
+        analysis.setCacheDirectory(config.cacheDirectory);
+    }
+    if (!config.candidateCache.empty()) {
+        analysis.setCandidateCache(config.candidateCache);
+    }
+    if (!config.fastSimulationMap.empty()) {
+        analysis.setFastSimulation(config.fastSimulationMap, config.fastSimulationSeed);
+    }
+    analysis.setOutputOptions(config.outputOptions);
+    if (config.provenance && config.outputOptions.format == OutputFormat::Columnar) {
+        throw std::runtime_error("Output:provenance = true needs Output:format = ROOT or RNTuple, the columnar format cannot store the ids collection");
+    }
+    analysis.setProvenance(config.provenance);
+    if (!config.skimOutput.empty()) {
+        analysis.setSkimOutput(config.skimOutput);
+    }
+    if (!config.skimInput.empty()) {
+        analysis.setSkimInput(config.skimInput);
+    }
+    analysis.setThreads(config.threads);
+    if (config.bootstrapReplicas > 0) {
+        analysis.setBootstrap(config.bootstrapReplicas, config.bootstrapSeed, config.storeReplicaWeights);
+    }
+    if (!config.moments.empty()) {
+        std::string filename = config.momentsOutput;
+        if (filename.empty()) filename = fs::path(config.output).replace_extension(".moments.root").string();
+        analysis.setBinnedMoments(config.moments, filename);
+    }
+    if (!config.mixing.empty()) {
+        std::string filename = config.mixingOutput;
+        if (filename.empty()) filename = fs::path(config.output).replace_extension(".mixed.root").string();
+        analysis.setEventMixing(config.mixing, filename);
+    }
+    if (config.checkpointInterval > 0) {
+        analysis.setProgressive(config.checkpointInterval, config.targetError);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef ANALYSIS_CONFIG_H
+#define ANALYSIS_CONFIG_H
+
+#include "LundReader.h"
+#include "HadroniaFilter.h"
+#include "KinematicsStructs.h"
+#include "KinematicCut.h"
+#include "DISTree.h"
+#include "BinnedMoments.h"
+#include "EventMixing.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class LundAnalysis;
+
+// Declarative description of a LundAnalysis, read from a card file.
+// The card uses the same "Group:key = value ! comment" syntax as the
+// Pythia runcards in ./runcards. Recognized keys:
+//
+//   Analysis:input       = out/tutorial/gen/pythia8/*.dat
+//   Analysis:output      = analysis.root
+//   Analysis:type        = SingleHadron | DiHadron | TriHadron
+//   Analysis:criteria    = (211) + (-211)
+//   Analysis:acceptance  = ALL | CLAS12
+//   Analysis:verbosity   = 1
+//   Analysis:threads     = 4 (see LundAnalysis::setThreads)
+//   Filter:particleCondition = <parentPid> <grandParentPid>
+//   Filter:relationship      = <index1> <index2> <RelationshipType> [<RelationshipType> ...]
+//   Cut:<variable>           = min <value> | max <value> | range <min> <max>
+//   Analysis:cacheDirectory = .cache (see LundAnalysis::setCacheDirectory)
+//   Analysis:candidateCache = candidates.root (see LundAnalysis::setCandidateCache)
+//   Progressive:checkpointInterval = 100000 (see LundAnalysis::setProgressive)
+//   Progressive:targetError        = 0.005
+//   FastSim:map  = detector_maps/clas12_forward.map (see LundAnalysis::setFastSimulation)
+//   FastSim:seed = 0
+//   Output:format      = ROOT | columnar | RNTuple | none (see OutputFormat)
+//   Output:layout      = rows | events (see OutputLayout)
+//   Output:compression = ZSTD 5 | LZ4 4 | LZMA 9 | ZLIB 1 | none (see OutputOptions)
+//   Output:basketSize  = 32000
+//   Output:autoFlush   = -30000000  ! rows if > 0, bytes if < 0
+//   Output:autoSave    = -300000000
+//   Output:maxFileSize = 2000000000 ! bytes
+//   Output:precision   = <column> float | <column> double32 [<min> <max> <bits>]
+//   Output:provenance  = true | false (see LundAnalysis::setProvenance; not columnar)
+//   Skim:output = analysis.skim (see LundAnalysis::setSkimOutput)
+//   Skim:input  = analysis.skim (see LundAnalysis::setSkimInput)
+//   Moments:output = analysis.moments.root (default: Analysis:output with .moments.root)
+//   Moments:axis   = <column> <edge> <edge> [<edge> ...] (see BinnedMoments)
+//   Moments:moment = tPol*sin(phi_h+phi_S-pi)
+//   Moments:weight = <column>
+//   Bootstrap:replicas = 100 (see LundAnalysis::setBootstrap)
+//   Bootstrap:seed     = 0
+//   Bootstrap:store    = true | false (default: false for columnar outputs)
+//   Mixing:depth    = 10 (see LundAnalysis::setEventMixing)
+//   Mixing:capacity = 16
+//   Mixing:axis     = Q2 | W | multiplicity <edge> <edge> [<edge> ...] (see EventMixing)
+//   Mixing:output   = analysis.mixed.root (default: Analysis:output with .mixed.root)
+//
+// Filter, Cut, Output:precision, Moments:axis, Moments:moment and Mixing:axis
+// keys may be repeated; they are applied in the order given.
+struct AnalysisConfig {
+    std::string input;
+    std::string output;
+    std::string criteria;
+    HadroniumAnalysisType analysisType = HadroniumAnalysisType::SingleHadron;
+    AcceptanceType acceptance = AcceptanceType::ALL;
+    int verbosity = 0;
+    FilterRules rules;
+    std::vector<KinematicCut> cuts;
+    std::string cacheDirectory;
+    std::string candidateCache;
+    int checkpointInterval = 0;
+    double targetError = 0;
+    std::string fastSimulationMap;
+    std::uint64_t fastSimulationSeed = 0;
+    OutputOptions outputOptions;
+    int threads = 1;
+    BinnedMoments moments;
+    std::string momentsOutput;
+    int bootstrapReplicas = 0;
+    std::uint64_t bootstrapSeed = 0;
+    bool storeReplicaWeights = true;
+    EventMixing mixing;
+    std::string mixingOutput;
+    bool provenance = false;
+    std::string skimOutput;
+    std::string skimInput;
+};
+
+AnalysisConfig readAnalysisConfig(const std::string& filename);
+void configureAnalysis(LundAnalysis& analysis, const AnalysisConfig& config);
+
+#endif // ANALYSIS_CONFIG_H
@@ -0,0 +1,322 @@
+#include "AsymmetryFit.h"
+#include "ColumnarFile.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Rows summed at a time; the per-row values of a block stay in the cache
+const std::size_t Block = 1024;
+
+// Cholesky factorization L L^T of the symmetric matrix a (lower triangle,
+// K x K row major) in place; false if it is not positive definite
+bool cholesky(std::vector<double>& a, std::size_t K) {
+    for (std::size_t j = 0; j < K; ++j) {
+        double d = a[j * K + j];
+        for (std::size_t k = 0; k < j; ++k) d -= a[j * K + k] * a[j * K + k];
+        if (!(d > 0)) return false;
+        a[j * K + j] = std::sqrt(d);
+        for (std::size_t i = j + 1; i < K; ++i) {
+            double s = a[i * K + j];
+            for (std::size_t k = 0; k < j; ++k) s -= a[i * K + k] * a[j * K + k];
+            a[i * K + j] = s / a[j * K + j];
+        }
+    }
+    return true;
+}
+
+// Solves L L^T x = b
+std::vector<double> solve(const std::vector<double>& l, std::size_t K, std::vector<double> b) {
+    for (std::size_t i = 0; i < K; ++i) {
+        for (std::size_t k = 0; k < i; ++k) b[i] -= l[i * K + k] * b[k];
+        b[i] /= l[i * K + i];
+    }
+    for (std::size_t i = K; i-- > 0;) {
+        for (std::size_t k = i + 1; k < K; ++k) b[i] -= l[k * K + i] * b[k];
+        b[i] /= l[i * K + i];
+    }
+    return b;
+}
+
+} // namespace
+
+void AsymmetryFit::setPolarization(const std::string& column) {
+    polarization = column;
+}
+
+void AsymmetryFit::addModulation(const std::string& expression) {
+    if (!weights.empty()) {
+        throw std::runtime_error("The modulations must be added before the rows are loaded");
+    }
+    expressions.push_back(MomentExpression::parse(expression));
+    modulations.emplace_back();
+}
+
+void AsymmetryFit::setWeight(const std::string& column) {
+    weight = column;
+}
+
+void AsymmetryFit::addRange(const std::string& column, double min, double max) {
+    ranges.push_back(Range{column, min, max});
+}
+
+void AsymmetryFit::setThreads(int threads) {
+    this->threads = std::max(1, threads);
+}
+
+AsymmetryFit::Resolved AsymmetryFit::resolve() const {
+    Resolved resolved;
+    auto index = [&resolved](const std::string& column) {
+        auto found = std::find(resolved.columns.begin(), resolved.columns.end(), column);
+        if (found != resolved.columns.end()) return (std::size_t)(found - resolved.columns.begin());
+        resolved.columns.push_back(column);
+        return resolved.columns.size() - 1;
+    };
+    resolved.polarization = index(polarization);
+    resolved.weight = weight.empty() ? resolved.columns.size() : index(weight);
+    for (const auto& range : ranges) resolved.ranges.push_back(index(range.column));
+    for (const auto& expression : expressions) {
+        std::vector<std::size_t> factors;
+        for (const auto& factor : expression.factors) factors.push_back(index(factor));
+        std::vector<std::pair<double, std::size_t>> terms;
+        for (const auto& term : expression.terms) terms.push_back({term.first, index(term.second)});
+        resolved.factors.push_back(factors);
+        resolved.terms.push_back(terms);
+    }
+    return resolved;
+}
+
+void AsymmetryFit::addRow(const Resolved& resolved, const std::vector<double>& values) {
+    double P = values[resolved.polarization];
+    if (P == 0) return;
+    for (std::size_t r = 0; r < ranges.size(); ++r) {
+        double value = values[resolved.ranges[r]];
+        if (!(value >= ranges[r].min && value <= ranges[r].max)) return;
+    }
+    weights.push_back(weight.empty() ? 1.0 : values[resolved.weight]);
+    for (std::size_t k = 0; k < expressions.size(); ++k) {
+        const MomentExpression& expression = expressions[k];
+        double m = P;
+        for (std::size_t factor : resolved.factors[k]) m *= values[factor];
+        if (expression.function != MomentExpression::Function::None) {
+            double angle = expression.constant;
+            for (const auto& term : resolved.terms[k]) angle += term.first * values[term.second];
+            m *= expression.function == MomentExpression::Function::Sin ? std::sin(angle) : std::cos(angle);
+        }
+        modulations[k].push_back(m);
+    }
+}
+
+void AsymmetryFit::load(const std::string& filename) {
+    if (expressions.empty()) {
+        throw std::runtime_error("No modulation to fit");
+    }
+    Resolved resolved = resolve();
+    if (ColumnarFile::isColumnar(filename)) loadColumnar(filename, resolved);
+    else loadTree(filename, resolved);
+}
+
+void AsymmetryFit::loadTree(const std::string& filename, const Resolved& resolved) {
+    std::unique_ptr<TFile> in(TFile::Open(filename.c_str()));
+    if (!in || in->IsZombie()) {
+        throw std::runtime_error("Unable to open " + filename);
+    }
+    TTree* tree = (TTree*)(in->Get("tree"));
+    if (!tree) {
+        throw std::runtime_error(filename + " has no tree 'tree' (RNTuple outputs are not supported)");
+    }
+    // Only the needed branches are read, into buffers of their stored type
+    std::size_t n = resolved.columns.size();
+    std::vector<double> doubles(n);
+    std::vector<float> floats(n);
+    std::vector<int> ints(n);
+    std::vector<char> types(n);
+    tree->SetBranchStatus("*", false);
+    for (std::size_t c = 0; c < n; ++c) {
+        const char* name = resolved.columns[c].c_str();
+        TBranch* branch = tree->GetBranch(name);
+        TLeaf* leaf = branch ? branch->GetLeaf(name) : nullptr;
+        std::string type = leaf && leaf->GetLen() == 1 ? leaf->GetTypeName() : "";
+        tree->SetBranchStatus(name, true);
+        if (type == "Double_t" || type == "Double32_t") {
+            types[c] = 'D';
+            tree->SetBranchAddress(name, &doubles[c]);
+        } else if (type == "Float_t") {
+            types[c] = 'F';
+            tree->SetBranchAddress(name, &floats[c]);
+        } else if (type == "Int_t") {
+            types[c] = 'I';
+            tree->SetBranchAddress(name, &ints[c]);
+        } else {
+            throw std::runtime_error(filename + ": no single number column '" + resolved.columns[c] + "' (the fit needs the row layout)");
+        }
+    }
+    std::vector<double> values(n);
+    Long64_t nEntries = tree->GetEntries();
+    for (Long64_t entry = 0; entry < nEntries; ++entry) {
+        tree->GetEntry(entry);
+        for (std::size_t c = 0; c < n; ++c) {
+            values[c] = types[c] == 'D' ? doubles[c] : types[c] == 'F' ? floats[c] : ints[c];
+        }
+        addRow(resolved, values);
+    }
+}
+
+void AsymmetryFit::loadColumnar(const std::string& filename, const Resolved& resolved) {
+    ColumnarFile file(filename);
+    std::size_t n = resolved.columns.size();
+    std::vector<const ColumnarFile::Column*> columns;
+    for (const auto& name : resolved.columns) {
+        const ColumnarFile::Column* column = file.find(name);
+        if (!column) {
+            throw std::runtime_error(filename + ": no column '" + name + "'");
+        }
+        columns.push_back(column);
+    }
+    std::vector<double> values(n);
+    for (std::uint64_t row = 0; row < file.rows(); ++row) {
+        for (std::size_t c = 0; c < n; ++c) {
+            switch (columns[c]->type) {
+                case ColumnType::Double: values[c] = static_cast<const double*>(columns[c]->data)[row]; break;
+                case ColumnType::Float: values[c] = static_cast<const float*>(columns[c]->data)[row]; break;
+                case ColumnType::Int: values[c] = static_cast<const int*>(columns[c]->data)[row]; break;
+            }
+        }
+        addRow(resolved, values);
+    }
+}
+
+// Sums over the rows [begin, end), a block at a time: first u = 1 + P A.m
+// for the block, then each sum as a loop over the block's arrays
+void AsymmetryFit::accumulate(const std::vector<double>& A, std::size_t begin, std::size_t end, Sums& sums) const {
+    const std::size_t K = A.size();
+    double u[Block], r[Block], r2[Block];
+    for (std::size_t first = begin; first < end; first += Block) {
+        const std::size_t n = std::min(Block, end - first);
+        const double* w = weights.data() + first;
+        for (std::size_t i = 0; i < n; ++i) u[i] = 1.0;
+        for (std::size_t k = 0; k < K; ++k) {
+            const double* x = modulations[k].data() + first;
+            const double a = A[k];
+            for (std::size_t i = 0; i < n; ++i) u[i] += a * x[i];
+        }
+        double nll = 0;
+        bool valid = true;
+        for (std::size_t i = 0; i < n; ++i) {
+            valid &= u[i] > 0;
+            nll -= w[i] * std::log(u[i]);
+            r[i] = w[i] / u[i];
+            r2[i] = r[i] / u[i];
+        }
+        if (!valid) {
+            sums.valid = false;
+            return;
+        }
+        sums.nll += nll;
+        for (std::size_t k = 0; k < K; ++k) {
+            const double* xk = modulations[k].data() + first;
+            double g = 0;
+            for (std::size_t i = 0; i < n; ++i) g += r[i] * xk[i];
+            sums.gradient[k] -= g;
+            for (std::size_t l = 0; l <= k; ++l) {
+                const double* xl = modulations[l].data() + first;
+                double h = 0;
+                for (std::size_t i = 0; i < n; ++i) h += r2[i] * xk[i] * xl[i];
+                sums.hessian[k * K + l] += h;
+            }
+        }
+    }
+}
+
+// The rows are split into one range per thread; the partial sums are added
+// in range order, so the result only depends on the number of threads
+AsymmetryFit::Sums AsymmetryFit::evaluate(const std::vector<double>& A) const {
+    const std::size_t K = A.size();
+    const std::size_t n = rows();
+    std::size_t nThreads = std::max<std::size_t>(1, std::min<std::size_t>(threads, n / (16 * Block)));
+    std::vector<Sums> partial(nThreads);
+    for (auto& sums : partial) {
+        sums.gradient.assign(K, 0.0);
+        sums.hessian.assign(K * K, 0.0);
+    }
+    auto work = [&](std::size_t t) { accumulate(A, n * t / nThreads, n * (t + 1) / nThreads, partial[t]); };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < nThreads; ++t) pool.emplace_back(work, t);
+    work(0);
+    for (auto& thread : pool) thread.join();
+
+    Sums total = partial[0];
+    for (std::size_t t = 1; t < nThreads; ++t) {
+        total.valid &= partial[t].valid;
+        total.nll += partial[t].nll;
+        for (std::size_t i = 0; i < K; ++i) total.gradient[i] += partial[t].gradient[i];
+        for (std::size_t i = 0; i < K * K; ++i) total.hessian[i] += partial[t].hessian[i];
+    }
+    return total;
+}
+
+AsymmetryFitResult AsymmetryFit::fit() const {
+    const std::size_t K = expressions.size();
+    if (rows() == 0) {
+        throw std::runtime_error("No polarized rows to fit");
+    }
+    AsymmetryFitResult result;
+    result.rows = rows();
+    for (const auto& expression : expressions) result.modulations.push_back(expression.text);
+
+    std::vector<double> A(K, 0.0);
+    Sums current = evaluate(A);
+    std::vector<double> l;
+    for (result.iterations = 1; result.iterations <= 100; ++result.iterations) {
+        l = current.hessian;
+        if (!cholesky(l, K)) {
+            throw std::runtime_error("The Hessian of the likelihood is not positive definite; are the modulations independent?");
+        }
+        std::vector<double> step = current.gradient;
+        for (auto& g : step) g = -g;
+        step = solve(l, K, step);
+        // Newton decrement g^T H^-1 g, twice the expected decrease of the likelihood
+        double decrement = 0;
+        for (std::size_t k = 0; k < K; ++k) decrement -= current.gradient[k] * step[k];
+        if (decrement < 1e-12) {
+            result.converged = true;
+            break;
+        }
+        // Halve the step until 1 + P A.m stays positive and the likelihood decreases enough
+        std::vector<double> trial(K);
+        Sums next;
+        double t = 1;
+        for (; t > 1e-10; t *= 0.5) {
+            for (std::size_t k = 0; k < K; ++k) trial[k] = A[k] + t * step[k];
+            next = evaluate(trial);
+            if (next.valid && next.nll <= current.nll - 1e-4 * t * decrement) break;
+        }
+        if (t <= 1e-10) break;
+        A = trial;
+        current = next;
+    }
+
+    // Covariance from the inverse Hessian at the minimum
+    l = current.hessian;
+    if (!cholesky(l, K)) {
+        throw std::runtime_error("The Hessian of the likelihood is not positive definite at the minimum");
+    }
+    result.covariance.assign(K, std::vector<double>(K));
+    for (std::size_t k = 0; k < K; ++k) {
+        std::vector<double> unit(K, 0.0);
+        unit[k] = 1;
+        std::vector<double> column = solve(l, K, unit);
+        for (std::size_t i = 0; i < K; ++i) result.covariance[i][k] = column[i];
+    }
+    result.values = A;
+    for (std::size_t k = 0; k < K; ++k) result.errors.push_back(std::sqrt(result.covariance[k][k]));
+    result.nll = current.nll;
+    return result;
+}
@@ -0,0 +1,96 @@
+#ifndef ASYMMETRY_FIT_H
+#define ASYMMETRY_FIT_H
+
+#include "BinnedMoments.h"
+#include <string>
+#include <vector>
+
+struct AsymmetryFitResult {
+    std::vector<std::string> modulations;
+    std::vector<double> values;
+    std::vector<double> errors;
+    std::vector<std::vector<double>> covariance;
+    double nll = 0;
+    int iterations = 0;
+    bool converged = false;
+    std::size_t rows = 0;
+};
+
+// Unbinned maximum likelihood fit of the polarization dependent azimuthal
+// modulations of DISTree outputs. Each row with polarization P != 0 (the
+// beam or target helicity) contributes
+//
+//   -w log(1 + P * sum_k A_k m_k)
+//
+// to the negative log likelihood, where m_k are the modulations, e.g.
+// sin(phi_h+phi_S-pi) or depolB*sin(phi_RT). The modulations integrate to
+// zero over the angles, so the normalization and the extended yield terms of
+// both helicity states do not depend on the A_k and drop out.
+//
+// The columns are read once; P * m_k is stored as one array per modulation
+// and the likelihood, its gradient and its Hessian are summed over blocks of
+// rows by several threads. The minimum is found with Newton steps and a
+// backtracking line search; the errors are taken from the inverse Hessian,
+// which assumes unit weights.
+class AsymmetryFit {
+public:
+    // Column with the polarization of the row: bPol (default) or tPol
+    void setPolarization(const std::string& column);
+    // Modulation in the syntax of MomentExpression
+    void addModulation(const std::string& expression);
+    void setWeight(const std::string& column);
+    // Only rows with min <= column <= max are fitted
+    void addRange(const std::string& column, double min, double max);
+    void setThreads(int threads);
+
+    // Reads the rows of a DISTree output with the row layout, in the ROOT
+    // format or in the columnar format, told apart by the content of the
+    // file. May be called for several files; the modulations, weight and
+    // ranges must be set before.
+    void load(const std::string& filename);
+    std::size_t rows() const { return weights.size(); }
+
+    AsymmetryFitResult fit() const;
+
+private:
+    struct Range {
+        std::string column;
+        double min;
+        double max;
+    };
+    // Negative log likelihood with its gradient and Hessian (K x K, row major)
+    struct Sums {
+        double nll = 0;
+        std::vector<double> gradient;
+        std::vector<double> hessian;
+        bool valid = true;
+    };
+    // Column indices of the expressions in the rows passed to addRow
+    struct Resolved {
+        std::vector<std::string> columns;
+        std::size_t polarization;
+        std::size_t weight;
+        std::vector<std::size_t> ranges;
+        std::vector<std::vector<std::size_t>> factors;
+        std::vector<std::vector<std::pair<double, std::size_t>>> terms;
+    };
+
+    std::string polarization = "bPol";
+    std::string weight;
+    std::vector<MomentExpression> expressions;
+    std::vector<Range> ranges;
+    int threads = 1;
+
+    // P * m_k of every row, one array per modulation
+    std::vector<std::vector<double>> modulations;
+    std::vector<double> weights;
+
+    Resolved resolve() const;
+    void addRow(const Resolved& resolved, const std::vector<double>& values);
+    void loadTree(const std::string& filename, const Resolved& resolved);
+    void loadColumnar(const std::string& filename, const Resolved& resolved);
+    Sums evaluate(const std::vector<double>& A) const;
+    void accumulate(const std::vector<double>& A, std::size_t begin, std::size_t end, Sums& sums) const;
+};
+
+#endif // ASYMMETRY_FIT_H
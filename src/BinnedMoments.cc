@@ -0,0 +1,298 @@
+#include "BinnedMoments.h"
+#include "ProgressMonitor.h"
+#include "TFile.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TNamed.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+BinAxis::BinAxis(const std::string& variable, const std::vector<double>& edges) : variable(variable), edges(edges) {
+    if (edges.size() < 2 || !std::is_sorted(edges.begin(), edges.end()) ||
+        std::adjacent_find(edges.begin(), edges.end()) != edges.end()) {
+        throw std::runtime_error("The bin edges of " + variable + " must be at least two increasing values");
+    }
+    lo = edges.front();
+    hi = edges.back();
+    // Four cells per bin on average; with uniform edges every cell is inside one bin
+    std::size_t cells = 4 * (edges.size() - 1);
+    scale = cells / (hi - lo);
+    lookup.resize(cells + 1);
+    int bin = 0;
+    for (std::size_t cell = 0; cell <= cells; ++cell) {
+        double start = lo + cell / scale;
+        while (bin + 2 < (int)edges.size() && start >= edges[bin + 1]) bin++;
+        lookup[cell] = bin;
+    }
+}
+
+namespace {
+
+bool isName(char c) {
+    return std::isalnum((unsigned char)c) || c == '_';
+}
+
+void parseArgument(MomentExpression& expression, const std::string& argument) {
+    std::size_t i = 0;
+    while (i < argument.size()) {
+        double sign = 1;
+        if (argument[i] == '+' || argument[i] == '-') {
+            sign = argument[i] == '-' ? -1 : 1;
+            i++;
+        } else if (i > 0) {
+            throw std::runtime_error("Expected + or - in moment " + expression.text);
+        }
+        std::size_t start = i;
+        while (i < argument.size() && (std::isdigit((unsigned char)argument[i]) || argument[i] == '.')) i++;
+        bool hasNumber = i > start;
+        double coefficient = hasNumber ? std::stod(argument.substr(start, i - start)) : 1;
+        if (hasNumber && i < argument.size() && argument[i] == '*') i++;
+        start = i;
+        while (i < argument.size() && isName(argument[i])) i++;
+        std::string name = argument.substr(start, i - start);
+        if (name == "pi") expression.constant += sign * coefficient * M_PI;
+        else if (!name.empty()) expression.terms.push_back({sign * coefficient, name});
+        else if (hasNumber) expression.constant += sign * coefficient;
+        else throw std::runtime_error("Malformed moment " + expression.text);
+    }
+    if (expression.terms.empty()) throw std::runtime_error("Moment " + expression.text + " has no angle");
+}
+
+} // namespace
+
+MomentExpression MomentExpression::parse(const std::string& text) {
+    MomentExpression expression;
+    expression.text = text;
+    std::string compact;
+    bool space = false;
+    for (char c : text) {
+        if (std::isspace((unsigned char)c)) {
+            space = true;
+            continue;
+        }
+        // "phi_h phi_S" is not "phi_hphi_S"
+        if (space && !compact.empty() && isName(compact.back()) && isName(c)) {
+            throw std::runtime_error("Malformed moment " + text);
+        }
+        space = false;
+        compact += c;
+    }
+    // Factors separated by '*' outside the parentheses
+    std::vector<std::string> factors(1);
+    int depth = 0;
+    for (char c : compact) {
+        if (c == '(') depth++;
+        if (c == ')') depth--;
+        if (c == '*' && depth == 0) factors.emplace_back();
+        else factors.back() += c;
+    }
+    for (const auto& factor : factors) {
+        bool sin = factor.compare(0, 4, "sin(") == 0;
+        bool cos = factor.compare(0, 4, "cos(") == 0;
+        if (sin || cos) {
+            if (expression.function != Function::None || factor.back() != ')') {
+                throw std::runtime_error("Malformed moment " + text);
+            }
+            expression.function = sin ? Function::Sin : Function::Cos;
+            parseArgument(expression, factor.substr(4, factor.size() - 5));
+        } else if (!factor.empty() && std::all_of(factor.begin(), factor.end(), isName)) {
+            expression.factors.push_back(factor);
+        } else {
+            throw std::runtime_error("Malformed moment " + text);
+        }
+    }
+    return expression;
+}
+
+void BinnedMoments::addAxis(const std::string& variable, const std::vector<double>& edges) {
+    axes.emplace_back(variable, edges);
+}
+
+void BinnedMoments::addMoment(const std::string& expression) {
+    moments.push_back(MomentExpression::parse(expression));
+}
+
+void BinnedMoments::setWeight(const std::string& column) {
+    weight = column;
+}
+
+void BinnedMoments::setReplicas(int replicas) {
+    this->replicas = replicas;
+}
+
+std::size_t BinnedMoments::bins() const {
+    std::size_t n = 1;
+    for (const auto& axis : axes) n *= axis.bins();
+    return n;
+}
+
+const std::vector<std::string>& BinnedMoments::depolarizations() {
+    static const std::vector<std::string> names = {"depolA", "depolB", "depolC", "depolV", "depolW"};
+    return names;
+}
+
+BinnedMoments::Shard BinnedMoments::shard() const {
+    return Shard(*this);
+}
+
+BinnedMoments::Shard::Shard(const BinnedMoments& definition)
+    : definition(&definition), sums(definition.bins() * definition.stride(), 0.0) {}
+
+void BinnedMoments::Shard::merge(const Shard& other) {
+    for (std::size_t i = 0; i < sums.size(); ++i) sums[i] += other.sums[i];
+}
+
+void BinnedMoments::Shard::attach(DISTree& tree) {
+    auto find = [&tree](const std::string& name) {
+        const BranchVariable* found = tree.findVariable(name);
+        if (!found) throw std::runtime_error("Binned moments use the unknown column '" + name + "'");
+        return *found;
+    };
+    struct ResolvedMoment {
+        std::vector<BranchVariable> factors;
+        MomentExpression::Function function;
+        std::vector<std::pair<double, BranchVariable>> terms;
+        double constant;
+    };
+    const BinnedMoments& d = *definition;
+    std::vector<BranchVariable> axes;
+    std::vector<std::size_t> strides;
+    std::size_t stride = d.stride();
+    for (const auto& axis : d.axes) {
+        axes.push_back(find(axis.variable));
+        strides.push_back(stride);
+        stride *= axis.bins();
+    }
+    std::vector<ResolvedMoment> moments;
+    for (const auto& moment : d.moments) {
+        ResolvedMoment resolved{{}, moment.function, {}, moment.constant};
+        for (const auto& factor : moment.factors) resolved.factors.push_back(find(factor));
+        for (const auto& term : moment.terms) resolved.terms.push_back({term.first, find(term.second)});
+        moments.push_back(resolved);
+    }
+    std::vector<BranchVariable> depolarizations;
+    for (const auto& name : BinnedMoments::depolarizations()) depolarizations.push_back(find(name));
+    bool weighted = !d.weight.empty();
+    BranchVariable weight = weighted ? find(d.weight) : BranchVariable();
+
+    const std::vector<int>* replicaWeights = &tree.replicaWeights();
+    std::size_t K = d.replicas;
+
+    tree.addRowObserver([this, axes, strides, moments, depolarizations, weighted, weight, replicaWeights, K]() {
+        std::size_t offset = 0;
+        for (std::size_t k = 0; k < axes.size(); ++k) {
+            int bin = definition->axes[k].index(axes[k].value());
+            if (bin < 0) return;
+            offset += bin * strides[k];
+        }
+        double w = weighted ? weight.value() : 1.0;
+        double* s = &sums[offset];
+        s[0] += w;
+        s[1] += w * w;
+        s += 2;
+        double* r = s + 2 * moments.size() + depolarizations.size();
+        const int* rw = replicaWeights->data();
+        bool replicated = K > 0 && replicaWeights->size() == K;
+        if (replicated) {
+            for (std::size_t k = 0; k < K; ++k) r[k] += w * rw[k];
+            r += K;
+        }
+        for (const auto& moment : moments) {
+            double m = 1;
+            for (const auto& factor : moment.factors) m *= factor.value();
+            if (moment.function != MomentExpression::Function::None) {
+                double angle = moment.constant;
+                for (const auto& term : moment.terms) angle += term.first * term.second.value();
+                m *= moment.function == MomentExpression::Function::Sin ? std::sin(angle) : std::cos(angle);
+            }
+            s[0] += w * m;
+            s[1] += w * m * w * m;
+            s += 2;
+            if (replicated) {
+                for (std::size_t k = 0; k < K; ++k) r[k] += w * m * rw[k];
+                r += K;
+            }
+        }
+        for (const auto& depol : depolarizations) *s++ += w * depol.value();
+    });
+}
+
+void BinnedMoments::write(const std::string& filename, const Shard& shard) const {
+    TFile out(filename.c_str(), "RECREATE");
+    if (out.IsZombie()) {
+        throw std::runtime_error("Unable to create " + filename);
+    }
+    std::size_t n = bins();
+    std::size_t s = stride();
+    auto histogram = [&](const std::string& name, const std::string& title, std::size_t sum, bool squares) {
+        TH1D h(name.c_str(), title.c_str(), n, 0, n);
+        for (std::size_t bin = 0; bin < n; ++bin) {
+            h.SetBinContent(bin + 1, shard.sums[bin * s + sum]);
+            h.SetBinError(bin + 1, squares ? std::sqrt(shard.sums[bin * s + sum + 1]) : 0.0);
+        }
+        out.WriteTObject(&h);
+    };
+    histogram("yield", "sum of weights", 0, true);
+    for (std::size_t k = 0; k < moments.size(); ++k) {
+        histogram("moment" + std::to_string(k), moments[k].text, 2 + 2 * k, true);
+    }
+    for (std::size_t k = 0; k < depolarizations().size(); ++k) {
+        histogram(depolarizations()[k], "sum of weight * " + depolarizations()[k], 2 + 2 * moments.size() + k, false);
+    }
+    if (replicas > 0) {
+        std::size_t K = replicas;
+        std::size_t first = replicaOffset();
+        auto replicaHistogram = [&](const std::string& name, const std::string& title, std::size_t sum) {
+            TH2D h(name.c_str(), title.c_str(), n, 0, n, K, 0, K);
+            for (std::size_t bin = 0; bin < n; ++bin) {
+                for (std::size_t r = 0; r < K; ++r) h.SetBinContent(bin + 1, r + 1, shard.sums[bin * s + sum + r]);
+            }
+            out.WriteTObject(&h);
+        };
+        replicaHistogram("yield_replicas", "sum of weights per replica", first);
+        for (std::size_t k = 0; k < moments.size(); ++k) {
+            std::size_t moment = first + (k + 1) * K;
+            replicaHistogram("moment" + std::to_string(k) + "_replicas", moments[k].text, moment);
+        }
+        completeMeans(out);
+    }
+    std::ostringstream description;
+    for (const auto& axis : axes) {
+        TH1D h(("axis_" + axis.variable).c_str(), axis.variable.c_str(), axis.bins(), axis.edges.data());
+        out.WriteTObject(&h);
+        description << axis.variable << " ";
+    }
+    TNamed axisOrder("axes", description.str().c_str());
+    out.WriteTObject(&axisOrder);
+    out.Close();
+}
+
+void BinnedMoments::completeMeans(TFile& file) {
+    std::unique_ptr<TH1D> yield((TH1D*)(file.Get("yield")));
+    std::unique_ptr<TH2D> yieldReplicas((TH2D*)(file.Get("yield_replicas")));
+    if (!yield || !yieldReplicas) return;
+    int n = yield->GetNbinsX();
+    int K = yieldReplicas->GetNbinsY();
+    for (int k = 0;; ++k) {
+        std::string name = "moment" + std::to_string(k);
+        std::unique_ptr<TH1D> moment((TH1D*)(file.Get(name.c_str())));
+        std::unique_ptr<TH2D> momentReplicas((TH2D*)(file.Get((name + "_replicas").c_str())));
+        if (!moment || !momentReplicas) break;
+        TH1D mean(("mean" + std::to_string(k)).c_str(), moment->GetTitle(), n, 0, n);
+        for (int bin = 1; bin <= n; ++bin) {
+            if (yield->GetBinContent(bin) == 0) continue;
+            RunningStatistic spread;
+            for (int r = 1; r <= K; ++r) {
+                double w = yieldReplicas->GetBinContent(bin, r);
+                if (w != 0) spread.add(momentReplicas->GetBinContent(bin, r) / w);
+            }
+            mean.SetBinContent(bin, moment->GetBinContent(bin) / yield->GetBinContent(bin));
+            mean.SetBinError(bin, std::sqrt(spread.variance()));
+        }
+        file.WriteTObject(&mean, nullptr, "Overwrite");
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef BINNED_MOMENTS_H
+#define BINNED_MOMENTS_H
+
+#include "DISTree.h"
+#include <string>
+#include <vector>
+
+// Bins of one output column. The bin of a value is found in constant time:
+// a lookup table over [edges.front(), edges.back()) gives the bin at the
+// start of each cell, from which at most the edges inside the cell are
+// stepped over. Uniform edges never step.
+class BinAxis {
+public:
+    BinAxis(const std::string& variable, const std::vector<double>& edges);
+    // Bin of the value, or -1 outside the edges
+    int index(double value) const {
+        if (!(value >= lo && value < hi)) return -1;
+        int bin = lookup[(std::size_t)((value - lo) * scale)];
+        while (value >= edges[bin + 1]) bin++;
+        while (value < edges[bin]) bin--; // rounding of the cell index
+        return bin;
+    }
+    int bins() const { return (int)edges.size() - 1; }
+
+    std::string variable;
+    std::vector<double> edges;
+
+private:
+    double lo, hi, scale;
+    std::vector<int> lookup;
+};
+
+// A product of columns and of an optional sin or cos of a linear combination
+// of columns, e.g. "tPol*sin(phi_h+phi_S-pi)", "bPol*sin(phi_RT)", "cos(2phi_h)"
+struct MomentExpression {
+    std::string text;
+    std::vector<std::string> factors;
+    enum class Function { None, Sin, Cos } function = Function::None;
+    std::vector<std::pair<double, std::string>> terms; // coefficient, column
+    double constant = 0;
+
+    static MomentExpression parse(const std::string& text);
+};
+
+// Binned yields and azimuthal moments, accumulated from the rows of DISTrees
+// instead of storing the rows. Per bin of the product of the axes it keeps
+// the sum of the weights w and of w^2, for each moment m the sums of w*m and
+// of (w*m)^2, and the sums of w*depolA ... w*depolW, so that <m> and its
+// uncertainty, and the mean depolarization factors, follow from the sums.
+//
+// With bootstrap replicas (see BootstrapWeights), the same sums of w and w*m
+// are also kept with w multiplied by each replica weight of the row's event,
+// read from DISTree::replicaWeights().
+//
+// Rows are accumulated into Shards, one per DISTree, which are merged by
+// adding their sums once the trees are complete; merging the shards in a
+// fixed order gives the same sums whatever thread filled them.
+class BinnedMoments {
+public:
+    void addAxis(const std::string& variable, const std::vector<double>& edges);
+    void addMoment(const std::string& expression);
+    // Column holding the row weight; by default every row has weight 1
+    void setWeight(const std::string& column);
+    // Number of bootstrap replicas
+    void setReplicas(int replicas);
+    bool empty() const { return axes.empty() && moments.empty(); }
+    std::size_t bins() const;
+
+    class Shard {
+    public:
+        // Accumulates every row filled by the tree
+        void attach(DISTree& tree);
+        void merge(const Shard& other);
+
+    private:
+        friend class BinnedMoments;
+        explicit Shard(const BinnedMoments& definition);
+        const BinnedMoments* definition;
+        std::vector<double> sums; // bins() * stride()
+    };
+    Shard shard() const;
+
+    // Writes the sums as histograms over the flattened bin index (first axis
+    // fastest): "yield" (content sum w, error sqrt(sum w^2)), "moment<k>"
+    // (sum w*m, sqrt(sum (w*m)^2)) titled with the expression, "depolA" ...
+    // "depolW" (sum w*depol), and each axis as an empty "axis_<variable>"
+    // histogram with its edges. With replicas, "yield_replicas" and
+    // "moment<k>_replicas" hold the replica sums (flattened bin x replica) and
+    // "mean<k>" holds <m> = sum w*m / sum w with the standard deviation of the
+    // replicas' <m> as error. All but "mean<k>" add with hadd.
+    void write(const std::string& filename, const Shard& sums) const;
+    // Computes "mean<k>" from the other histograms of a file written by
+    // write(), e.g. once several such files were added (see OutputMerger)
+    static void completeMeans(TFile& file);
+
+private:
+    std::vector<BinAxis> axes;
+    std::vector<MomentExpression> moments;
+    std::string weight;
+    int replicas = 0;
+
+    static const std::vector<std::string>& depolarizations();
+    // Sums of a bin: w, w^2, (w*m, (w*m)^2) per moment, w*depol per factor,
+    // then w*r per replica and (w*r*m per replica) per moment
+    std::size_t stride() const { return replicaOffset() + replicas * (1 + moments.size()); }
+    std::size_t replicaOffset() const { return 2 + 2 * moments.size() + depolarizations().size(); }
+};
+
+#endif // BINNED_MOMENTS_H
@@ -0,0 +1,24 @@
+#include "Bootstrap.h"
+#include "CounterRandom.h"
+#include <cmath>
+
+BootstrapWeights::BootstrapWeights(int replicas, std::uint64_t seed) : nReplicas(replicas), seed(seed) {}
+
+void BootstrapWeights::generate(std::uint64_t eventKey, std::vector<int>& weights) const {
+    weights.resize(nReplicas);
+    // Different from the streams of FastSimulation with the same seed
+    RandomStream random{splitmix64(~seed ^ splitmix64(eventKey))};
+    const double p0 = std::exp(-1.0);
+    for (auto& w : weights) {
+        // Inversion of the Poisson(1) distribution function
+        double u = random.uniform();
+        int k = 0;
+        double p = p0, cdf = p0;
+        while (u > cdf && k < 20) {
+            k++;
+            p /= k;
+            cdf += p;
+        }
+        w = k;
+    }
+}
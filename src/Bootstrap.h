@@ -0,0 +1,24 @@
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+#include <cstdint>
+#include <vector>
+
+// Poisson(1) bootstrap replica weights of events. Weighting every event of
+// a sample by an independent Poisson(1) number resamples it with
+// replacement, so K sets of weights give K bootstrap replicas from a single
+// pass. The weights of an event depend only on the seed and the event key
+// (see FastSimulation::eventKey), never on the processing order or thread.
+class BootstrapWeights {
+public:
+    explicit BootstrapWeights(int replicas = 0, std::uint64_t seed = 0);
+    int replicas() const { return nReplicas; }
+    // Fills weights with the replicas' weights of the event
+    void generate(std::uint64_t eventKey, std::vector<int>& weights) const;
+
+private:
+    int nReplicas;
+    std::uint64_t seed;
+};
+
+#endif // BOOTSTRAP_H
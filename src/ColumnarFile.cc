@@ -0,0 +1,265 @@
+#include "ColumnarFile.h"
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'S', 'P', 'T', 'H', 'C', 'O', 'L', '1'};
+const std::uint64_t kAlignment = 64;
+
+std::uint64_t align(std::uint64_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+void writeBytes(std::FILE* out, const void* data, std::size_t size, const std::string& filename) {
+    if (size > 0 && std::fwrite(data, 1, size, out) != size) {
+        throw std::runtime_error("Unable to write " + filename);
+    }
+}
+
+// Writes the header and schema of a file with the given columns, then calls
+// writeColumn(c, out) for the values of column c; written under a temporary
+// name, so that the file is replaced at once
+void writeColumnar(const std::string& filename, const std::vector<std::pair<std::string, ColumnType>>& columns,
+                   std::uint64_t nRows, const std::function<void(std::size_t, std::FILE*)>& writeColumn) {
+    std::string temporary = filename + ".tmp";
+    std::FILE* out = std::fopen(temporary.c_str(), "wb");
+    if (!out) {
+        throw std::runtime_error("Unable to create " + temporary);
+    }
+
+    ColumnarHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = ColumnarVersion;
+    header.nColumns = columns.size();
+    header.nRows = nRows;
+    std::vector<ColumnarEntry> entries(columns.size());
+    std::uint64_t offset = align(sizeof(ColumnarHeader) + columns.size() * sizeof(ColumnarEntry));
+    for (std::size_t c = 0; c < columns.size(); ++c) {
+        std::strncpy(entries[c].name, columns[c].first.c_str(), sizeof(entries[c].name) - 1);
+        entries[c].type = columns[c].second;
+        entries[c].offset = offset;
+        offset = align(offset + nRows * columnTypeSize(columns[c].second));
+    }
+
+    static const char padding[kAlignment] = {};
+    std::uint64_t position = sizeof(ColumnarHeader) + entries.size() * sizeof(ColumnarEntry);
+    writeBytes(out, &header, sizeof(header), temporary);
+    writeBytes(out, entries.data(), entries.size() * sizeof(ColumnarEntry), temporary);
+    for (std::size_t c = 0; c < columns.size(); ++c) {
+        writeBytes(out, padding, entries[c].offset - position, temporary);
+        writeColumn(c, out);
+        position = entries[c].offset + nRows * columnTypeSize(columns[c].second);
+    }
+    writeBytes(out, padding, align(position) - position, temporary);
+
+    if (std::fclose(out) != 0 || std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        throw std::runtime_error("Unable to write " + filename);
+    }
+}
+
+} // namespace
+
+std::size_t columnTypeSize(ColumnType type) {
+    switch (type) {
+        case ColumnType::Double: return sizeof(double);
+        case ColumnType::Float: return sizeof(float);
+        case ColumnType::Int: return sizeof(int);
+    }
+    return 0;
+}
+
+ColumnarWriter::ColumnarWriter(const std::string& filename, const OutputOptions& options)
+    : filename(filename), options(options) {
+    chunkFile = std::fopen((filename + ".chunks").c_str(), "w+b");
+    if (!chunkFile) {
+        throw std::runtime_error("Unable to create " + filename + ".chunks");
+    }
+}
+
+ColumnarWriter::~ColumnarWriter() {
+    if (chunkFile) {
+        std::fclose(chunkFile);
+        std::remove((filename + ".chunks").c_str());
+    }
+}
+
+void ColumnarWriter::addColumn(const std::string& name, double* value) {
+    bool reduced = options.precision.count(name) > 0;
+    addColumn(name, reduced ? ColumnType::Float : ColumnType::Double, value, nullptr);
+}
+
+void ColumnarWriter::addColumn(const std::string& name, int* value) {
+    addColumn(name, ColumnType::Int, nullptr, value);
+}
+
+void ColumnarWriter::addColumn(const std::string& name, std::vector<double>*) {
+    throw std::runtime_error("The columnar format has no collection columns, cannot store " + name + " (per-event layout, replica weights or provenance ids)");
+}
+
+void ColumnarWriter::addColumn(const std::string& name, std::vector<int>*) {
+    throw std::runtime_error("The columnar format has no collection columns, cannot store " + name + " (per-event layout, replica weights or provenance ids)");
+}
+
+void ColumnarWriter::addColumn(const std::string& name, ColumnType type, const double* d, const int* i) {
+    if (nRows > 0) {
+        throw std::runtime_error(filename + ": column '" + name + "' declared after the first row");
+    }
+    if (name.size() >= sizeof(ColumnarEntry::name)) {
+        throw std::runtime_error(filename + ": column name '" + name + "' is too long");
+    }
+    columns.push_back(Column{name, type, d, i, std::vector<char>(ChunkRows * columnTypeSize(type))});
+}
+
+void ColumnarWriter::fill() {
+    for (auto& column : columns) {
+        char* slot = column.buffer.data() + bufferedRows * columnTypeSize(column.type);
+        switch (column.type) {
+            case ColumnType::Double: std::memcpy(slot, column.d, sizeof(double)); break;
+            case ColumnType::Float: {
+                float value = (float)*column.d;
+                std::memcpy(slot, &value, sizeof(float));
+                break;
+            }
+            case ColumnType::Int: std::memcpy(slot, column.i, sizeof(int)); break;
+        }
+    }
+    nRows++;
+    if (++bufferedRows == ChunkRows) flushChunk();
+}
+
+void ColumnarWriter::flushChunk() {
+    if (bufferedRows == 0) return;
+    chunks.push_back(Chunk{chunkFileSize, bufferedRows});
+    for (const auto& column : columns) {
+        std::size_t size = bufferedRows * columnTypeSize(column.type);
+        writeBytes(chunkFile, column.buffer.data(), size, filename + ".chunks");
+        chunkFileSize += size;
+    }
+    bufferedRows = 0;
+}
+
+void ColumnarWriter::checkpoint() {
+    flushChunk();
+    std::fflush(chunkFile);
+
+    std::vector<std::pair<std::string, ColumnType>> layout;
+    for (const auto& column : columns) layout.emplace_back(column.name, column.type);
+    std::vector<char> slice;
+    writeColumnar(filename, layout, nRows, [&](std::size_t c, std::FILE* out) {
+        // Offset of column c within each chunk
+        std::uint64_t before = 0;
+        for (std::size_t k = 0; k < c; ++k) before += columnTypeSize(columns[k].type);
+        for (const auto& chunk : chunks) {
+            slice.resize(chunk.rows * columnTypeSize(columns[c].type));
+            if (fseeko(chunkFile, chunk.offset + before * chunk.rows, SEEK_SET) != 0 ||
+                std::fread(slice.data(), 1, slice.size(), chunkFile) != slice.size()) {
+                throw std::runtime_error("Unable to read " + filename + ".chunks");
+            }
+            writeBytes(out, slice.data(), slice.size(), filename);
+        }
+    });
+    // Later chunks are appended
+    fseeko(chunkFile, 0, SEEK_END);
+}
+
+void ColumnarWriter::write() {
+    if (written) return;
+    checkpoint();
+    std::fclose(chunkFile);
+    chunkFile = nullptr;
+    std::remove((filename + ".chunks").c_str());
+    written = true;
+}
+
+void ColumnarWriter::concatenate(const std::vector<std::string>& inputs, const std::string& output) {
+    std::vector<std::unique_ptr<ColumnarFile>> files;
+    std::uint64_t nRows = 0;
+    for (const auto& input : inputs) {
+        files.emplace_back(new ColumnarFile(input));
+        nRows += files.back()->rows();
+    }
+    std::vector<std::pair<std::string, ColumnType>> layout;
+    if (!files.empty()) {
+        for (const auto& column : files[0]->columns()) layout.emplace_back(column.name, column.type);
+    }
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        const auto& columns = files[f]->columns();
+        bool same = columns.size() == layout.size();
+        for (std::size_t c = 0; same && c < columns.size(); ++c) {
+            same = columns[c].name == layout[c].first && columns[c].type == layout[c].second;
+        }
+        if (!same) {
+            throw std::runtime_error(inputs[f] + " does not have the columns of " + inputs[0]);
+        }
+    }
+    writeColumnar(output, layout, nRows, [&](std::size_t c, std::FILE* out) {
+        for (const auto& file : files) {
+            writeBytes(out, file->columns()[c].data, file->rows() * columnTypeSize(layout[c].second), output);
+        }
+    });
+}
+
+ColumnarFile::ColumnarFile(const std::string& filename) : filename(filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open columnar file: " + filename);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (std::size_t)status.st_size < sizeof(ColumnarHeader)) {
+        close(fd);
+        throw std::runtime_error(filename + " is not a columnar file");
+    }
+    mapSize = status.st_size;
+    map = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        map = nullptr;
+        throw std::runtime_error("Unable to map " + filename);
+    }
+
+    const char* bytes = static_cast<const char*>(map);
+    ColumnarHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != ColumnarVersion ||
+        sizeof(ColumnarHeader) + (std::uint64_t)header.nColumns * sizeof(ColumnarEntry) > mapSize) {
+        munmap(map, mapSize);
+        throw std::runtime_error(filename + " is not a columnar file of version " + std::to_string(ColumnarVersion));
+    }
+    nRows = header.nRows;
+    for (std::uint32_t c = 0; c < header.nColumns; ++c) {
+        ColumnarEntry entry;
+        std::memcpy(&entry, bytes + sizeof(ColumnarHeader) + c * sizeof(ColumnarEntry), sizeof(entry));
+        std::size_t size = columnTypeSize(entry.type);
+        if (size == 0 || entry.offset % kAlignment != 0 || entry.offset > mapSize || nRows > (mapSize - entry.offset) / size) {
+            munmap(map, mapSize);
+            throw std::runtime_error(filename + " is truncated or corrupt");
+        }
+        schema.push_back(Column{std::string(entry.name, strnlen(entry.name, sizeof(entry.name))), entry.type, bytes + entry.offset});
+    }
+}
+
+ColumnarFile::~ColumnarFile() {
+    if (map) munmap(map, mapSize);
+}
+
+const ColumnarFile::Column* ColumnarFile::find(const std::string& name) const {
+    for (const auto& column : schema) {
+        if (column.name == name) return &column;
+    }
+    return nullptr;
+}
+
+bool ColumnarFile::isColumnar(const std::string& filename) {
+    std::FILE* in = std::fopen(filename.c_str(), "rb");
+    if (!in) return false;
+    char magic[sizeof(kMagic)];
+    bool found = std::fread(magic, 1, sizeof(magic), in) == sizeof(magic) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    std::fclose(in);
+    return found;
+}
@@ -0,0 +1,174 @@
+#ifndef COLUMNAR_FILE_H
+#define COLUMNAR_FILE_H
+
+#include "OutputBackend.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Columnar output format: every column is one uncompressed array of nRows
+// values starting at a multiple of 64 bytes, so a reader can map the file
+// and use the arrays in place.
+//
+//   offset 0    ColumnarHeader
+//   offset 32   nColumns ColumnarEntry, one per column in declaration order
+//   ...         the column arrays
+//
+// Values are stored in the byte order of the machine that wrote the file
+// (little endian on all supported platforms).
+
+enum class ColumnType : std::uint32_t {
+    Double = 0,
+    Float = 1,
+    Int = 2
+};
+
+std::size_t columnTypeSize(ColumnType type);
+
+struct ColumnarHeader {
+    char magic[8];           // "SPTHCOL1"
+    std::uint32_t version;   // ColumnarVersion
+    std::uint32_t nColumns;
+    std::uint64_t nRows;
+    std::uint64_t reserved;
+};
+
+struct ColumnarEntry {
+    char name[48];           // null terminated
+    ColumnType type;
+    std::uint32_t reserved;
+    std::uint64_t offset;    // of the column array, from the start of the file
+};
+
+const std::uint32_t ColumnarVersion = 1;
+
+// Contiguous read-only view of the values of a column (as std::span)
+template<class T>
+class ColumnView {
+public:
+    ColumnView() {}
+    ColumnView(const T* first, std::size_t n) : first(first), n(n) {}
+    const T* data() const { return first; }
+    std::size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    const T* begin() const { return first; }
+    const T* end() const { return first + n; }
+    const T& operator[](std::size_t i) const { return first[i]; }
+
+private:
+    const T* first = nullptr;
+    std::size_t n = 0;
+};
+
+// Writes the columnar format as a DISTree output. Rows are buffered and
+// flushed in chunks to <filename>.chunks; checkpoint() and write() lay the
+// chunks out column by column into the file. Columns with a reduced
+// precision are stored as float. There are no collection columns: every
+// column has one value per row.
+class ColumnarWriter : public OutputBackend {
+public:
+    explicit ColumnarWriter(const std::string& filename, const OutputOptions& options = OutputOptions());
+    ColumnarWriter(const ColumnarWriter&) = delete;
+    ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+    ~ColumnarWriter();
+
+    void addColumn(const std::string& name, double* value) override;
+    void addColumn(const std::string& name, int* value) override;
+    void addColumn(const std::string& name, std::vector<double>* values) override;
+    void addColumn(const std::string& name, std::vector<int>* values) override;
+    // Column stored with the given type, read from d (Double and Float) or i (Int)
+    void addColumn(const std::string& name, ColumnType type, const double* d, const int* i);
+    void fill() override;
+    void checkpoint() override;
+    void write() override;
+
+    // Concatenates files with the same columns into output, without
+    // going through the rows
+    static void concatenate(const std::vector<std::string>& inputs, const std::string& output);
+
+private:
+    struct Column {
+        std::string name;
+        ColumnType type;
+        const double* d;
+        const int* i;
+        std::vector<char> buffer;
+    };
+    // Rows of a chunk, at offset in the chunk file, column after column
+    struct Chunk {
+        std::uint64_t offset;
+        std::uint64_t rows;
+    };
+    static const std::size_t ChunkRows = 65536;
+
+    std::string filename;
+    OutputOptions options;
+    std::vector<Column> columns;
+    std::vector<Chunk> chunks;
+    std::FILE* chunkFile = nullptr;
+    std::uint64_t chunkFileSize = 0;
+    std::size_t bufferedRows = 0;
+    std::uint64_t nRows = 0;
+    bool written = false;
+
+    void flushChunk();
+};
+
+// A columnar file mapped into memory. Column views stay valid as long as
+// the file object exists.
+class ColumnarFile {
+public:
+    struct Column {
+        std::string name;
+        ColumnType type;
+        const void* data;
+    };
+
+    explicit ColumnarFile(const std::string& filename);
+    ColumnarFile(const ColumnarFile&) = delete;
+    ColumnarFile& operator=(const ColumnarFile&) = delete;
+    ~ColumnarFile();
+
+    std::uint64_t rows() const { return nRows; }
+    const std::vector<Column>& columns() const { return schema; }
+    // Column with the given name, or nullptr
+    const Column* find(const std::string& name) const;
+
+    // True if the file starts with the magic of the columnar format, whatever
+    // its name, e.g. a columnar output named .root by create_project.rb
+    static bool isColumnar(const std::string& filename);
+
+    // Values of a column; throws if the column does not exist or is not of type T
+    template<class T>
+    ColumnView<T> column(const std::string& name) const;
+
+private:
+    std::string filename;
+    void* map = nullptr;
+    std::size_t mapSize = 0;
+    std::uint64_t nRows = 0;
+    std::vector<Column> schema;
+
+    template<class T> static ColumnType typeOf();
+};
+
+template<> inline ColumnType ColumnarFile::typeOf<double>() { return ColumnType::Double; }
+template<> inline ColumnType ColumnarFile::typeOf<float>() { return ColumnType::Float; }
+template<> inline ColumnType ColumnarFile::typeOf<int>() { return ColumnType::Int; }
+
+template<class T>
+ColumnView<T> ColumnarFile::column(const std::string& name) const {
+    const Column* found = find(name);
+    if (!found) {
+        throw std::runtime_error(filename + ": no column '" + name + "'");
+    }
+    if (found->type != typeOf<T>()) {
+        throw std::runtime_error(filename + ": column '" + name + "' has another type");
+    }
+    return ColumnView<T>(static_cast<const T*>(found->data), nRows);
+}
+
+#endif // COLUMNAR_FILE_H
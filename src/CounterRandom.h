@@ -0,0 +1,36 @@
+#ifndef COUNTER_RANDOM_H
+#define COUNTER_RANDOM_H
+
+#include <cmath>
+#include <cstdint>
+
+// Counter-based random numbers: the numbers of a stream are hashes of the
+// stream key and a counter, so they depend only on the key, never on the
+// processing order or the thread.
+
+inline std::uint64_t splitmix64(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Counter-based stream: the n-th number is a hash of the stream key and n
+struct RandomStream {
+    std::uint64_t key;
+    std::uint64_t counter = 0;
+
+    // Uniform in (0, 1]
+    double uniform() {
+        return ((splitmix64(key ^ splitmix64(counter++)) >> 11) + 1) * 0x1.0p-53;
+    }
+    // Two independent standard normal numbers (Box-Muller)
+    void gaus(double& g1, double& g2) {
+        double r = std::sqrt(-2 * std::log(uniform()));
+        double angle = 2 * 3.14159265358979323846 * uniform();
+        g1 = r * std::cos(angle);
+        g2 = r * std::sin(angle);
+    }
+};
+
+#endif // COUNTER_RANDOM_H
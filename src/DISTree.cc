@@ -1,157 +1,423 @@
 #include "DISTree.h"
+#include "TNamed.h"
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 using namespace std;
 
-DISTree::DISTree(const std::string& filename, HadroniumAnalysisType analysisType) {
-    this->init(filename, analysisType);
+// Declares one output column per visited field and records it as a cut
+// variable. Collection columns are stored from a CandidateCollection.
+struct DISTree::BranchMaker {
+    DISTree& self;
+    bool collection = false;
+
+    void operator()(const char* name, double& value) const {
+        if (collection) {
+            self.collections.push_back(CandidateCollection{&value, nullptr, {}, {}});
+            self.output->addColumn(name, &self.collections.back().dValues);
+        } else {
+            self.output->addColumn(name, &value);
+        }
+        self.variables.push_back(BranchVariable{name, &value, nullptr});
+    }
+    void operator()(const char* name, int& value) const {
+        if (collection) {
+            self.collections.push_back(CandidateCollection{nullptr, &value, {}, {}});
+            self.output->addColumn(name, &self.collections.back().iValues);
+        } else {
+            self.output->addColumn(name, &value);
+        }
+        self.variables.push_back(BranchVariable{name, nullptr, &value});
+    }
+};
+
+DISTree::DISTree(const std::string& filename, HadroniumAnalysisType analysisType, const OutputOptions& options) {
+    this->init(filename, analysisType, options);
 }
 
 
-void DISTree::init(const std::string& filename, HadroniumAnalysisType analysisType){
-    file = new TFile(filename.data(), "RECREATE");
-    tree = new TTree("tree", "Kinematics Data Tree");
+void DISTree::init(const std::string& filename, HadroniumAnalysisType analysisType, const OutputOptions& options){
+    output = OutputBackend::create(filename, options);
+    variables.clear();
+    collections.clear();
+    bootstrapWeights.clear();
+    // The observers of an earlier output may refer to objects that are gone
+    rowObservers.clear();
+    provenance = false;
+    perEvent = options.layout == OutputLayout::Events;
     // Branches for EventKinematics are always created
-    tree->Branch("x", &this->eventKinematics->x, "x/D");
-    tree->Branch("y", &this->eventKinematics->y, "y/D");
-    tree->Branch("Q2", &this->eventKinematics->Q2, "Q2/D");
-    tree->Branch("W", &this->eventKinematics->W, "W/D");
-    tree->Branch("phi_S", &this->eventKinematics->phi_S, "phi_S/D");
-    tree->Branch("epsilon", &this->eventKinematics->epsilon, "epsilon/D");
-    tree->Branch("gamma", &this->eventKinematics->gamma, "gamma/D");
-    tree->Branch("depolA", &this->eventKinematics->depolA, "depolA/D");
-    tree->Branch("depolB", &this->eventKinematics->depolB, "depolB/D");
-    tree->Branch("depolC", &this->eventKinematics->depolC, "depolC/D");
-    tree->Branch("depolV", &this->eventKinematics->depolV, "depolV/D");
-    tree->Branch("depolW", &this->eventKinematics->depolW, "depolW/D");
-    tree->Branch("bPol", &this->eventKinematics->beam_polarization, "bPol/I");
-    tree->Branch("tPol", &this->eventKinematics->target_polarization, "tPol/I");
-    // Branches for SingleHadronKinematics
-    if (analysisType == HadroniumAnalysisType::SingleHadron) {
-        doSingleHadron = true;
-        tree->Branch("pt", &this->singleHadronKinematics->pt, "pt/D");
-        tree->Branch("z", &this->singleHadronKinematics->z, "z/D");
-        tree->Branch("phi", &this->singleHadronKinematics->phi, "phi/D");
-        tree->Branch("Mh", &this->singleHadronKinematics->Mh, "Mh/D");
-        tree->Branch("xF", &this->singleHadronKinematics->xF, "xF/D");
-        tree->Branch("Mx", &this->singleHadronKinematics->Mx, "Mx/D");
-        tree->Branch("parentPid", &this->singleHadronKinematics->parentPid, "parentPid/I");
-        tree->Branch("grandParentPid", &this->singleHadronKinematics->grandParentPid, "grandParentPid/I");
-        tree->Branch("status", &this->singleHadronKinematics->status, "status/I");
-    }
-
-    // Branches for DiHadronKinematics
-    if (analysisType == HadroniumAnalysisType::DiHadron) {
-        doDiHadron = true;
-        tree->Branch("pt1", &this->diHadronKinematics->pt1, "pt1/D");
-        tree->Branch("pt2", &this->diHadronKinematics->pt2, "pt2/D");
-        tree->Branch("pt", &this->diHadronKinematics->pt, "pt/D");
-        tree->Branch("z1", &this->diHadronKinematics->z1, "z1/D");
-        tree->Branch("z2", &this->diHadronKinematics->z2, "z2/D");
-        tree->Branch("z", &this->diHadronKinematics->z, "z/D");
-        tree->Branch("phi_h", &this->diHadronKinematics->phi_h, "phi_h/D");
-        tree->Branch("phi_RT", &this->diHadronKinematics->phi_RT, "phi_RT/D");
-        tree->Branch("phi_Rperp", &this->diHadronKinematics->phi_Rperp, "phi_Rperp/D");
-        tree->Branch("th", &this->diHadronKinematics->th, "th/D");
-        tree->Branch("Mh", &this->diHadronKinematics->Mh, "Mh/D");
-        tree->Branch("xF1", &this->diHadronKinematics->xF1, "xF1/D");
-        tree->Branch("xF2", &this->diHadronKinematics->xF2, "xF2/D");
-        tree->Branch("xF", &this->diHadronKinematics->xF, "xF/D");
-        tree->Branch("Mx", &this->diHadronKinematics->Mx, "Mx/D");
-        tree->Branch("parentPid1", &this->diHadronKinematics->parentPid1, "parentPid1/I");
-        tree->Branch("grandParentPid1", &this->diHadronKinematics->grandParentPid1, "grandParentPid1/I");
-        tree->Branch("status1", &this->diHadronKinematics->status1, "status1/I");
-        tree->Branch("parentPid2", &this->diHadronKinematics->parentPid2, "parentPid2/I");
-        tree->Branch("grandParentPid2", &this->diHadronKinematics->grandParentPid2, "grandParentPid2/I");
-        tree->Branch("status2", &this->diHadronKinematics->status2, "status2/I");
-    }
-}
-
-void DISTree::Fill(LundEvent& event, std::vector<std::vector<Hadronium>> hadronia) {
-    
+    EventKinematics::visit(eventKinematics, BranchMaker{*this});
+    nEventVariables = variables.size();
+    if (perEvent) output->addColumn("nCandidates", &nCandidates);
+    // Branches for the candidate kinematics of the analysis arity
+    switch (candidateArity(analysisType)) {
+        case 1: initHadronBranches<1>(); break;
+        case 2: initHadronBranches<2>(); break;
+        case 3: initHadronBranches<3>(); break;
+    }
+    for (const auto& column : options.precision) {
+        const BranchVariable* found = findVariable(column.first);
+        if (!found || !found->d) {
+            cerr << "WARNING: Precision given for '" << column.first << "', which is not a double column" << endl;
+        }
+    }
+}
+
+template<std::size_t N>
+void DISTree::initHadronBranches() {
+    HadronKinematics<N>::visit(std::get<N-1>(hadronKinematics), BranchMaker{*this, perEvent});
+    fillHadrons = &DISTree::FillHadrons<N>;
+    arity = N;
+}
+
+void DISTree::Fill(LundEvent& event, const std::vector<std::vector<Hadronium>>& hadronia) {
+    if (nResolvedCuts != kinematicCuts.size()) resolveCuts();
+
     // Create kinematics object for the event
     KinematicsCalculator kin(event);
-    
+
     // Get the event kinematics
-    *eventKinematics = kin.CalculateEventKinematics();
-    
-    if (doSingleHadron){
-        // Get the single hadron kinematics for all event hadronia
-        std::vector<SingleHadronKinematics> single_hadron_kins = kin.CalculateSingleHadronKinematics(hadronia);
-        
-        for (auto& single_hadron_kin : single_hadron_kins){
-            *singleHadronKinematics = single_hadron_kin;
-            if (checkCuts()==true) tree->Fill();
+    eventKinematics = kin.CalculateEventKinematics();
+
+    // No candidate of an event failing the event cuts can pass, unless all
+    // candidates are recorded
+    if (!candidateTree && !passesAll(eventCuts)) return;
+
+    // Get the candidate kinematics for all event hadronia
+    (this->*fillHadrons)(kin, hadronia);
+    if (perEvent) finishEvent();
+    if (candidateTree) candidateEvent++;
+}
+
+template<std::size_t N>
+void DISTree::FillHadrons(const KinematicsCalculator& kin, const std::vector<std::vector<Hadronium>>& hadronia) {
+    HadronKinematics<N>& kinematics = std::get<N-1>(hadronKinematics);
+    const std::vector<HadronVariable<N>>& candidateVariables = hadronVariables<N>();
+    std::vector<HadronCandidate<N>>& candidates = std::get<N-1>(eventCandidates);
+    std::vector<HadronKinematics<N>>& results = std::get<N-1>(eventResults);
+    candidates.clear();
+    eventHadronia.clear();
+    HadronCandidate<N> candidate;
+    for (const auto& hadronium : hadronia) {
+        if (!make_candidate(hadronium, candidate)) continue;
+
+        // Check the candidate cuts one variable at a time, so that a rejected
+        // candidate only costs the variables computed up to its first failed
+        // cut. Recorded candidates are all kept.
+        bool passed = true;
+        if (!candidateTree) {
+            for (auto& cut : candidateCuts) {
+                cut.evaluated++;
+                if (!cut.cut.passes(candidateVariables[cut.variable].evaluate(kin, candidate))) {
+                    cut.rejected++;
+                    passed = false;
+                    break;
+                }
+            }
+            if (!candidateCuts.empty() && ++nCandidatesChecked % 1024 == 0) orderCandidateCuts();
         }
+        if (!passed) continue;
+        candidates.push_back(candidate);
+        eventHadronia.push_back(&hadronium);
     }
-    else if (doDiHadron){
-        // Get the dihadron kinematics for all event hadronia
-        std::vector<DiHadronKinematics> dihadron_kins = kin.CalculateDiHadronKinematics(hadronia);
-        for (auto& dihadron_kin : dihadron_kins){
-            *diHadronKinematics = dihadron_kin;
-            if (checkCuts()==true) tree->Fill();
+    if (candidates.empty()) return;
+
+    computeKinematics(kin, candidates, results);
+    for (std::size_t c = 0; c < candidates.size(); ++c) {
+        kinematics = results[c];
+        if (candidateTree) {
+            setCandidateIds(*eventHadronia[c]);
+            candidateTree->Fill();
+            if (checkCuts()==false) continue;
+            fillRow();
+            continue;
         }
+        // The candidate cuts again, on the stored values, as the batched
+        // kernel may round differently from the single variables
+        if (!passesAll(rowCuts)) continue;
+        bool passed = true;
+        for (const auto& cut : candidateCuts) passed = passed && cut.cut.passes(cut.cut.variable.value());
+        if (!passed) continue;
+        if (provenance) setCandidateIds(*eventHadronia[c]);
+        fillRow();
     }
-    else{
-        if (checkCuts()==true) tree->Fill();
+}
+
+// Fewest candidates of an event for the batched kernel; below, its set-up
+// costs more than it saves. It is about 1.1x faster for 8 single hadrons,
+// 1.6x for 4 dihadrons and 1.9x for 8 dihadrons.
+static const std::size_t minSingleBatch = 8;
+static const std::size_t minDiBatch = 4;
+
+void DISTree::computeKinematics(const KinematicsCalculator& kin, const std::vector<HadronCandidate<1>>& candidates, std::vector<SingleHadronKinematics>& results) {
+    if (candidates.size() < minSingleBatch) {
+        results.clear();
+        for (const auto& candidate : candidates) results.push_back(kin.CalculateHadronKinematics(candidate));
+        return;
+    }
+    singleBatch.clear();
+    std::size_t event = singleBatch.addEvent(kin);
+    for (const auto& candidate : candidates) singleBatch.addCandidate(event, candidate);
+    singleBatch.compute();
+    results.resize(candidates.size());
+    for (std::size_t c = 0; c < candidates.size(); ++c) results[c] = singleBatch.get(c);
+}
+
+void DISTree::computeKinematics(const KinematicsCalculator& kin, const std::vector<HadronCandidate<2>>& candidates, std::vector<DiHadronKinematics>& results) {
+    if (candidates.size() < minDiBatch) {
+        results.clear();
+        for (const auto& candidate : candidates) results.push_back(kin.CalculateHadronKinematics(candidate));
+        return;
     }
+    diBatch.clear();
+    std::size_t event = diBatch.addEvent(kin);
+    for (const auto& candidate : candidates) diBatch.addCandidate(event, candidate);
+    diBatch.compute();
+    results.resize(candidates.size());
+    for (std::size_t c = 0; c < candidates.size(); ++c) results[c] = diBatch.get(c);
 }
 
+// No batched kernel for trihadrons
+void DISTree::computeKinematics(const KinematicsCalculator& kin, const std::vector<HadronCandidate<3>>& candidates, std::vector<TriHadronKinematics>& results) {
+    results.clear();
+    for (const auto& candidate : candidates) results.push_back(kin.CalculateHadronKinematics(candidate));
+}
 
-bool DISTree::checkCuts() const {
+void DISTree::setCandidateIds(const std::vector<Hadronium>& hadronium) {
+    candidateIds.clear();
+    for (const auto& hadron : hadronium) {
+        candidateIds.insert(candidateIds.end(), hadron.ids.begin(), hadron.ids.end());
+    }
+}
+
+void DISTree::fillRow() {
+    if (perEvent) {
+        for (auto& c : collections) {
+            if (c.d) c.dValues.push_back(*c.d);
+            else c.iValues.push_back(*c.i);
+        }
+        if (provenance) {
+            eventIds.insert(eventIds.end(), candidateIds.begin(), candidateIds.end());
+            eventIdCounts.push_back(candidateIds.size());
+        }
+        nCandidates++;
+    } else {
+        output->fill();
+    }
+    for (const auto& observer : rowObservers) observer();
+}
+
+// Per-event layout: stores the event if any of its candidates passed. The
+// event columns still hold the event's values.
+void DISTree::finishEvent() {
+    if (nCandidates > 0) output->fill();
+    nCandidates = 0;
+    for (auto& c : collections) {
+        c.dValues.clear();
+        c.iValues.clear();
+    }
+    eventIds.clear();
+    eventIdCounts.clear();
+}
+
+void DISTree::recordProvenance() {
+    provenance = true;
+    output->addColumn("fileId", &fileId);
+    output->addColumn("eventIndex", &eventIndex);
+    if (perEvent) {
+        output->addColumn("ids", &eventIds);
+        output->addColumn("nIds", &eventIdCounts);
+    } else {
+        output->addColumn("ids", &candidateIds);
+    }
+}
+
+void DISTree::setSource(int fileId, int eventIndex) {
+    this->fileId = fileId;
+    this->eventIndex = eventIndex;
+}
+
+void DISTree::setReplicas(int replicas, bool store) {
+    bootstrapWeights.assign(replicas, 1);
+    if (store) output->addColumn("replicaWeights", &bootstrapWeights);
+}
+
+void DISTree::recordCandidates(const std::string& filename, const std::string& fingerprint) {
+    candidateFile = new TFile(filename.data(), "RECREATE");
+    TNamed tag("fingerprint", fingerprint.c_str());
+    candidateFile->WriteTObject(&tag);
+    candidateTree = new TTree("candidates", "Reconstructed and filtered candidates");
+    for (const auto& v : variables) {
+        if (v.d) candidateTree->Branch(v.name.c_str(), v.d, (v.name + "/D").c_str());
+        else candidateTree->Branch(v.name.c_str(), v.i, (v.name + "/I").c_str());
+    }
+    // Indices of the candidate's particles, hadron by hadron in criteria order
+    candidateTree->Branch("ids", &candidateIds);
+    // Number of the candidate's event in this file
+    candidateTree->Branch("event", &candidateEvent, "event/L");
+    // Input file and event of the candidate (see setSource)
+    candidateTree->Branch("fileId", &fileId, "fileId/I");
+    candidateTree->Branch("eventIndex", &eventIndex, "eventIndex/I");
+    if (!bootstrapWeights.empty()) candidateTree->Branch("replicaWeights", &bootstrapWeights);
+}
+
+Long64_t DISTree::FillFromCandidates(TTree* candidates) {
+    if (nResolvedCuts != kinematicCuts.size()) resolveCuts();
+
+    for (const auto& v : variables) {
+        if (v.d) candidates->SetBranchAddress(v.name.c_str(), v.d);
+        else candidates->SetBranchAddress(v.name.c_str(), v.i);
+    }
+    std::vector<int>* weights = &bootstrapWeights;
+    if (!bootstrapWeights.empty()) candidates->SetBranchAddress("replicaWeights", &weights);
+    candidates->SetBranchAddress("fileId", &fileId);
+    candidates->SetBranchAddress("eventIndex", &eventIndex);
+    std::vector<int>* ids = &candidateIds;
+    if (provenance) candidates->SetBranchAddress("ids", &ids);
+    else candidates->SetBranchStatus("ids", false);
+
+    std::vector<TBranch*> cutBranches;
+    for (const auto& cut : resolvedCuts) {
+        TBranch* branch = candidates->GetBranch(cut.variable.name.c_str());
+        if (branch) cutBranches.push_back(branch);
+    }
+
+    Long64_t event = 0;
+    Long64_t previousEvent = -1;
+    TBranch* eventBranch = nullptr;
+    if (perEvent) {
+        eventBranch = candidates->GetBranch("event");
+        if (!eventBranch) throw std::runtime_error("The candidate cache has no event column for the per-event layout");
+        candidates->SetBranchAddress("event", &event);
+    }
+
+    Long64_t nFilled = 0;
+    Long64_t nEntries = candidates->GetEntries();
+    for (Long64_t entry = 0; entry < nEntries; ++entry) {
+        if (eventBranch) {
+            eventBranch->GetEntry(entry);
+            if (event != previousEvent) finishEvent();
+            previousEvent = event;
+        }
+        for (auto* branch : cutBranches) branch->GetEntry(entry);
+        if (checkCuts()==false) continue;
+        candidates->GetEntry(entry);
+        fillRow();
+        nFilled++;
+    }
+    if (perEvent) finishEvent();
+    candidates->ResetBranchAddresses();
+    return nFilled;
+}
+
+void DISTree::resolveCuts() {
+    static int zero = 0;
+    resolvedCuts.clear();
     for (const auto& cut : kinematicCuts) {
-        double value = 0.0;
-
-        // EventKinematics
-        if (cut.variableName == "Q2") value = eventKinematics->Q2;
-        else if (cut.variableName == "x") value = eventKinematics->x;
-        else if (cut.variableName == "y") value = eventKinematics->y;
-        else if (cut.variableName == "W") value = eventKinematics->W;
-
-        // SingleHadronKinematics
-        else if (cut.variableName == "pt" && doSingleHadron) value = singleHadronKinematics->pt;
-        else if (cut.variableName == "z" && doSingleHadron) value = singleHadronKinematics->z;
-        else if (cut.variableName == "phi" && doSingleHadron) value = singleHadronKinematics->phi;
-        else if (cut.variableName == "Mh" && doSingleHadron) value = singleHadronKinematics->Mh;
-        else if (cut.variableName == "xF" && doSingleHadron) value = singleHadronKinematics->xF;
-        else if (cut.variableName == "Mx" && doSingleHadron) value = singleHadronKinematics->Mx;
-
-        // DiHadronKinematics
-        else if (cut.variableName == "pt1" && doDiHadron) value = diHadronKinematics->pt1;
-        else if (cut.variableName == "pt2" && doDiHadron) value = diHadronKinematics->pt2;
-        else if (cut.variableName == "pt" && doDiHadron) value = diHadronKinematics->pt;
-        else if (cut.variableName == "z1" && doDiHadron) value = diHadronKinematics->z1;
-        else if (cut.variableName == "z2" && doDiHadron) value = diHadronKinematics->z2;
-        else if (cut.variableName == "z" && doDiHadron) value = diHadronKinematics->z;
-        else if (cut.variableName == "phi_h" && doDiHadron) value = diHadronKinematics->phi_h;
-        else if (cut.variableName == "phi_RT" && doDiHadron) value = diHadronKinematics->phi_RT;
-        else if (cut.variableName == "phi_Rperp" && doDiHadron) value = diHadronKinematics->phi_Rperp;
-        else if (cut.variableName == "th" && doDiHadron) value = diHadronKinematics->th;
-        else if (cut.variableName == "xF1" && doDiHadron) value = diHadronKinematics->xF1;
-        else if (cut.variableName == "xF2" && doDiHadron) value = diHadronKinematics->xF2;
-        else if (cut.variableName == "xF" && doDiHadron) value = diHadronKinematics->xF;
-        else if (cut.variableName == "Mx" && doDiHadron) value = diHadronKinematics->Mx;
-        
-        switch (cut.type) {
-            case KinematicCut::CutType::MIN:
-                if (value < cut.minValue) return false;
-                break;
-            case KinematicCut::CutType::MAX:
-                if (value > cut.maxValue) return false;
-                break;
-            case KinematicCut::CutType::RANGE:
-                if (value < cut.minValue || value > cut.maxValue) return false;
-                break;
+        BranchVariable variable{cut.variableName, nullptr, &zero};
+        const BranchVariable* found = findVariable(cut.variableName);
+        if (found) {
+            variable = *found;
+        } else {
+            cerr << "WARNING: Kinematic cut on unknown variable '" << cut.variableName << "' is applied to 0" << endl;
+        }
+        resolvedCuts.push_back(ResolvedCut{variable, cut.type, cut.minValue, cut.maxValue});
+    }
+    nResolvedCuts = kinematicCuts.size();
+
+    eventCuts.clear();
+    candidateCuts.clear();
+    rowCuts.clear();
+    switch (arity) {
+        case 1: resolveCandidateCuts<1>(); break;
+        case 2: resolveCandidateCuts<2>(); break;
+        case 3: resolveCandidateCuts<3>(); break;
+    }
+    nCandidatesChecked = 0;
+    orderCandidateCuts();
+}
+
+template<std::size_t N>
+void DISTree::resolveCandidateCuts() {
+    const std::vector<HadronVariable<N>>& candidateVariables = hadronVariables<N>();
+    for (const auto& cut : resolvedCuts) {
+        const BranchVariable* found = findVariable(cut.variable.name);
+        if (found && (size_t)(found - variables.data()) < nEventVariables) {
+            eventCuts.push_back(cut);
+            continue;
         }
+        std::size_t index = 0;
+        while (index < candidateVariables.size() && cut.variable.name != candidateVariables[index].name) index++;
+        if (found && index < candidateVariables.size()) {
+            candidateCuts.push_back(CandidateCut{cut, index, candidateVariables[index].cost});
+        } else {
+            rowCuts.push_back(cut);
+        }
+    }
+}
+
+// Cheap and selective cuts first: sorted by cost over the observed rejection
+// rate (starting from 1/2), which minimizes the expected cost of rejecting a
+// candidate for independent cuts. The order does not change the result.
+void DISTree::orderCandidateCuts() {
+    auto rank = [](const CandidateCut& cut) {
+        double rejection = (cut.rejected + 1.0) / (cut.evaluated + 2.0);
+        return (cut.cost + 0.5) / rejection;
+    };
+    std::stable_sort(candidateCuts.begin(), candidateCuts.end(),
+                     [&](const CandidateCut& a, const CandidateCut& b) { return rank(a) < rank(b); });
+}
+
+bool DISTree::ResolvedCut::passes(double value) const {
+    switch (type) {
+        case KinematicCut::CutType::MIN:
+            if (value < minValue) return false;
+            break;
+        case KinematicCut::CutType::MAX:
+            if (value > maxValue) return false;
+            break;
+        case KinematicCut::CutType::RANGE:
+            if (value < minValue || value > maxValue) return false;
+            break;
     }
     return true;
 }
 
+bool DISTree::passesAll(const std::vector<ResolvedCut>& cuts) {
+    for (const auto& cut : cuts) {
+        if (!cut.passes(cut.variable.value())) return false;
+    }
+    return true;
+}
+
+bool DISTree::checkCuts() const {
+    return passesAll(resolvedCuts);
+}
+
+const BranchVariable* DISTree::findVariable(const std::string& name) const {
+    for (const auto& v : variables) {
+        if (v.name == name) return &v;
+    }
+    return nullptr;
+}
+
+void DISTree::addRowObserver(std::function<void()> observer) {
+    rowObservers.push_back(observer);
+}
+
+void DISTree::Checkpoint() {
+    output->checkpoint();
+}
+
 void DISTree::Write() {
-    file->WriteTObject(tree);
-    file->Close();
+    output->write();
+    if (candidateFile) {
+        candidateFile->WriteTObject(candidateTree);
+        candidateFile->Close();
+    }
 }
 
 DISTree::~DISTree() {
-    delete file; // Ensure proper cleanup
-}
\ No newline at end of file
+    delete candidateFile;
+}
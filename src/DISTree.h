@@ -5,39 +5,167 @@
 #include "TTree.h"
 #include "LundReader.h"
 #include "Kinematics.h"
+#include "KinematicsBatch.h"
 #include "KinematicsStructs.h"
 #include "KinematicCut.h"
+#include "OutputBackend.h"
+#include <deque>
+#include <functional>
 #include <memory>
+#include <string>
+#include <tuple>
 #include <vector>
 
+// A named output column, pointing at the buffer the tree branch reads from
+struct BranchVariable {
+    std::string name;
+    double* d = nullptr;
+    int* i = nullptr;
+    double value() const { return d ? *d : *i; }
+};
+
 class DISTree {
 public:
     DISTree(){};
-    DISTree(const std::string& filename, HadroniumAnalysisType analysisType);
+    DISTree(const std::string& filename, HadroniumAnalysisType analysisType, const OutputOptions& options = OutputOptions());
+    DISTree(const DISTree&) = delete;
+    DISTree& operator=(const DISTree&) = delete;
     ~DISTree();
 
-    void init(const std::string& filename, HadroniumAnalysisType analysisType);
+    void init(const std::string& filename, HadroniumAnalysisType analysisType, const OutputOptions& options = OutputOptions());
     void SetEventKinematics(const EventKinematics& ek);
     void SetSingleHadronKinematics(const std::vector<SingleHadronKinematics>& shk);
     void SetDiHadronKinematics(const std::vector<DiHadronKinematics>& dhk);
 
-    void Fill(LundEvent& event, std::vector<std::vector<Hadronium>> hadronia);
+    void Fill(LundEvent& event, const std::vector<std::vector<Hadronium>>& hadronia);
     bool checkCuts() const;
     void Write();
+    // Saves the rows filled so far, so the file is readable if the job stops
+    void Checkpoint();
+
+    // Column of the tree with the given name, or nullptr. Cuts and observers
+    // always see the full precision value, whatever precision it is stored with
+    const BranchVariable* findVariable(const std::string& name) const;
+    // Called after every filled row, while the branch buffers hold its values.
+    // With the per-event layout, called for every passing candidate. init()
+    // removes the observers.
+    void addRowObserver(std::function<void()> observer);
+
+    // Bootstrap replica weights of the current event (see BootstrapWeights),
+    // set by the caller before Fill. With store they are written as the
+    // collection column "replicaWeights"; they are always kept in the
+    // candidate cache.
+    void setReplicas(int replicas, bool store);
+    std::vector<int>& replicaWeights() { return bootstrapWeights; }
+
+    // Adds the provenance columns: the event-level columns fileId and
+    // eventIndex, set by setSource before Fill, and the collection column ids
+    // with the candidate's particle indices, hadron by hadron in criteria
+    // order. With the per-event layout ids holds the indices of all passing
+    // candidates one after the other, and the candidate column nIds their
+    // number per candidate.
+    void recordProvenance();
+    // Input file (an index into the run's file table) and event number in
+    // that file of the next Fill
+    void setSource(int fileId, int eventIndex);
+    int sourceFile() const { return fileId; }
+    int sourceEvent() const { return eventIndex; }
+
+    // Also writes every candidate, before the kinematic cuts, with its particle
+    // indices and source to a candidate cache file, tagged with the given fingerprint
+    void recordCandidates(const std::string& filename, const std::string& fingerprint);
+    // Fills the rows of a candidate cache that pass the kinematic cuts,
+    // reading only the cut columns of the rejected candidates. The per-event
+    // layout groups the candidates by their "event" column.
+    Long64_t FillFromCandidates(TTree* candidates);
 
     std::vector<KinematicCut> kinematicCuts;
-    
+
 private:
-    TFile* file;
-    TTree* tree;
+    struct ResolvedCut {
+        BranchVariable variable;
+        KinematicCut::CutType type;
+        double minValue;
+        double maxValue;
+        bool passes(double value) const;
+    };
+    // A cut on a candidate column that is computed on its own before the
+    // candidate's other columns (see hadronVariables)
+    struct CandidateCut {
+        ResolvedCut cut;
+        std::size_t variable; // index in hadronVariables<N>()
+        int cost;
+        long evaluated = 0;
+        long rejected = 0;
+    };
+
+    struct BranchMaker;
+    // Candidate column of the per-event layout: the values of the event's
+    // passing candidates, appended from the column buffer d or i
+    struct CandidateCollection {
+        const double* d;
+        const int* i;
+        std::vector<double> dValues;
+        std::vector<int> iValues;
+    };
+
+    std::unique_ptr<OutputBackend> output;
+    TFile* candidateFile = nullptr;
+    TTree* candidateTree = nullptr;
+    std::vector<int> candidateIds;
+    Long64_t candidateEvent = 0;
+
+    bool perEvent = false;
+    std::deque<CandidateCollection> collections;
+    int nCandidates = 0;
+    std::vector<int> bootstrapWeights;
+    bool provenance = false;
+    int fileId = -1;
+    int eventIndex = -1;
+    std::vector<int> eventIds;      // per-event layout: ids of the passing candidates
+    std::vector<int> eventIdCounts; // per-event layout: number of ids per candidate
+
+    EventKinematics eventKinematics;
+    // Candidate kinematics indexed by arity - 1
+    std::tuple<SingleHadronKinematics, DiHadronKinematics, TriHadronKinematics> hadronKinematics;
+
+    // Columns of the tree, in branch order, and the cuts resolved against them
+    std::vector<BranchVariable> variables;
+    std::vector<ResolvedCut> resolvedCuts;
+    size_t nResolvedCuts = 0;
+    size_t nEventVariables = 0;
+    std::size_t arity = 0;
+    // resolvedCuts split by when they are checked: once per event, per
+    // candidate before its kinematics, or on the complete row
+    std::vector<ResolvedCut> eventCuts;
+    std::vector<CandidateCut> candidateCuts;
+    std::vector<ResolvedCut> rowCuts;
+    long nCandidatesChecked = 0;
+    // Candidates of the current event left after the candidate cuts, whose
+    // kinematics are computed together, with KinematicsBatch for single
+    // hadrons and dihadrons when there are enough of them
+    std::vector<const std::vector<Hadronium>*> eventHadronia;
+    std::tuple<std::vector<HadronCandidate<1>>, std::vector<HadronCandidate<2>>, std::vector<HadronCandidate<3>>> eventCandidates;
+    std::tuple<std::vector<SingleHadronKinematics>, std::vector<DiHadronKinematics>, std::vector<TriHadronKinematics>> eventResults;
+    KinematicsBatch<1> singleBatch;
+    KinematicsBatch<2> diBatch;
+    std::vector<std::function<void()>> rowObservers;
 
-    EventKinematics* eventKinematics = new EventKinematics;
-    SingleHadronKinematics* singleHadronKinematics = new SingleHadronKinematics;
-    DiHadronKinematics* diHadronKinematics = new DiHadronKinematics;
+    // Candidate loop for the analysis arity, selected once in init()
+    void (DISTree::*fillHadrons)(const KinematicsCalculator&, const std::vector<std::vector<Hadronium>>&) = nullptr;
 
-    
-    bool doSingleHadron = false;
-    bool doDiHadron = false;
+    template<std::size_t N> void initHadronBranches();
+    template<std::size_t N> void FillHadrons(const KinematicsCalculator& kin, const std::vector<std::vector<Hadronium>>& hadronia);
+    void computeKinematics(const KinematicsCalculator& kin, const std::vector<HadronCandidate<1>>& candidates, std::vector<SingleHadronKinematics>& results);
+    void computeKinematics(const KinematicsCalculator& kin, const std::vector<HadronCandidate<2>>& candidates, std::vector<DiHadronKinematics>& results);
+    void computeKinematics(const KinematicsCalculator& kin, const std::vector<HadronCandidate<3>>& candidates, std::vector<TriHadronKinematics>& results);
+    void resolveCuts();
+    template<std::size_t N> void resolveCandidateCuts();
+    void orderCandidateCuts();
+    static bool passesAll(const std::vector<ResolvedCut>& cuts);
+    void setCandidateIds(const std::vector<Hadronium>& hadronium);
+    void fillRow();
+    void finishEvent();
 };
 
-#endif // DISTREE_H
\ No newline at end of file
+#endif // DISTREE_H
@@ -0,0 +1,109 @@
+#include "EventMixing.h"
+#include "Kinematics.h"
+#include <algorithm>
+#include <stdexcept>
+
+void EventMixing::setDepth(int depth) {
+    if (depth < 0) throw std::runtime_error("The event mixing depth must not be negative");
+    this->depth = depth;
+}
+
+void EventMixing::setCapacity(int capacity) {
+    if (capacity < 1) throw std::runtime_error("The event mixing capacity must be positive");
+    this->capacity = capacity;
+}
+
+void EventMixing::addAxis(const std::string& variable, const std::vector<double>& edges) {
+    if (variable == "Q2") variables.push_back(Variable::Q2);
+    else if (variable == "W") variables.push_back(Variable::W);
+    else if (variable == "multiplicity") variables.push_back(Variable::Multiplicity);
+    else throw std::runtime_error("Events are mixed in classes of Q2, W or multiplicity, not " + variable);
+    axes.emplace_back(variable, edges);
+}
+
+void EventMixing::setCriteria(const std::string& criteria) {
+    std::vector<std::string> groups = criteria_groups(criteria);
+    if (groups.size() != 2) {
+        throw std::runtime_error("Event mixing needs criteria with two groups, not '" + criteria + "'");
+    }
+    firstGroup = groups[0];
+    secondGroup = groups[1];
+}
+
+int EventMixing::classes() const {
+    int n = 1;
+    for (const auto& axis : axes) n *= axis.bins();
+    return n;
+}
+
+std::size_t EventMixing::poolBytes() const {
+    std::size_t slots = (std::size_t)classes() * depth;
+    return slots * capacity * sizeof(CandidateHadron) + slots * sizeof(int) + 2 * classes() * sizeof(int);
+}
+
+void EventMixing::reset() {
+    std::size_t slots = (std::size_t)classes() * depth;
+    hadrons.assign(slots * capacity, CandidateHadron{});
+    slotSizes.assign(slots, 0);
+    nextSlot.assign(classes(), 0);
+    usedSlots.assign(classes(), 0);
+}
+
+// Flattened bin of the event over the axes, first axis fastest, or -1
+int EventMixing::classIndex(const LundEvent& event, const std::vector<Hadronium>& particles) const {
+    EventKinematics kinematics;
+    for (auto variable : variables) {
+        if (variable != Variable::Multiplicity) {
+            kinematics = KinematicsCalculator(event).CalculateEventKinematics();
+            break;
+        }
+    }
+    int index = 0, stride = 1;
+    for (std::size_t a = 0; a < axes.size(); ++a) {
+        double value = 0;
+        switch (variables[a]) {
+            case Variable::Q2: value = kinematics.Q2; break;
+            case Variable::W: value = kinematics.W; break;
+            case Variable::Multiplicity: value = particles.size(); break;
+        }
+        int bin = axes[a].index(value);
+        if (bin < 0) return -1;
+        index += bin * stride;
+        stride *= axes[a].bins();
+    }
+    return index;
+}
+
+const std::vector<std::vector<Hadronium>>& EventMixing::mix(const LundEvent& event, const std::vector<Hadronium>& particles) {
+    mixed.clear();
+    int c = classIndex(event, particles);
+    if (c < 0 || depth == 0) return mixed;
+
+    // Current first-group hadrons with the pooled second-group hadrons, oldest event first
+    std::vector<Hadronium> first = reconstruct_from_group(particles, firstGroup);
+    int oldest = (nextSlot[c] - usedSlots[c] + depth) % depth;
+    for (const auto& h : first) {
+        for (int s = 0; s < usedSlots[c]; ++s) {
+            std::size_t slot = (std::size_t)c * depth + (oldest + s) % depth;
+            const CandidateHadron* pooled = &hadrons[slot * capacity];
+            for (int k = 0; k < slotSizes[slot]; ++k) {
+                const CandidateHadron& p = pooled[k];
+                mixed.push_back({h, Hadronium(0, p.status, p.px, p.py, p.pz, p.e, {-1}, -1, p.parentPid, -1, p.grandParentPid)});
+            }
+        }
+    }
+
+    // The event's second-group hadrons replace the oldest event of the pool
+    std::vector<Hadronium> second = reconstruct_from_group(particles, secondGroup);
+    if (second.empty()) return mixed;
+    std::size_t slot = (std::size_t)c * depth + nextSlot[c];
+    int n = std::min<int>(second.size(), capacity);
+    for (int k = 0; k < n; ++k) {
+        const Hadronium& h = second[k];
+        hadrons[slot * capacity + k] = CandidateHadron{h.px, h.py, h.pz, h.e, h.parentPid, h.grandParentPid, h.status};
+    }
+    slotSizes[slot] = n;
+    nextSlot[c] = (nextSlot[c] + 1) % depth;
+    if (usedSlots[c] < depth) usedSlots[c]++;
+    return mixed;
+}
@@ -0,0 +1,58 @@
+#ifndef EVENT_MIXING_H
+#define EVENT_MIXING_H
+
+#include "BinnedMoments.h"
+#include "HadroniumParser.h"
+#include <string>
+#include <vector>
+
+// Event mixing for the combinatorial background of two-group criteria such
+// as "(211) + (-211)" or "(211) + (22 22)". Events are sorted into classes
+// by bins of Q2, W and the multiplicity (number of accepted final state
+// particles). Each class has a pool holding the second-group hadrons of its
+// last depth events in a ring buffer; the storage of all pools is allocated
+// once by reset(), at most capacity hadrons are kept per event.
+//
+// mix() pairs the first-group hadrons of an event with the pooled hadrons of
+// the earlier events of its class, then adds the event's own second-group
+// hadrons to the pool. The mixed candidates carry no particle indices
+// (ids of -1), their ancestry is that of each hadron in its own event.
+class EventMixing {
+public:
+    void setDepth(int depth);
+    void setCapacity(int capacity);
+    // Classes of events, by bins of Q2, W or multiplicity
+    void addAxis(const std::string& variable, const std::vector<double>& edges);
+    // The criteria of the analysis, which must have two groups
+    void setCriteria(const std::string& criteria);
+    bool empty() const { return depth == 0; }
+    int classes() const;
+    // Bytes of pool storage allocated by reset()
+    std::size_t poolBytes() const;
+
+    // Allocates empty pools
+    void reset();
+    // Mixed candidates of the event, valid until the next call. Events outside
+    // the class bins are neither mixed nor pooled.
+    const std::vector<std::vector<Hadronium>>& mix(const LundEvent& event, const std::vector<Hadronium>& particles);
+
+private:
+    enum class Variable { Q2, W, Multiplicity };
+    int depth = 0;
+    int capacity = 16;
+    std::vector<BinAxis> axes;
+    std::vector<Variable> variables;
+    std::string firstGroup, secondGroup;
+
+    // Slot s of class c holds slotSizes[c*depth+s] hadrons starting at
+    // hadrons[(c*depth+s)*capacity]
+    std::vector<CandidateHadron> hadrons;
+    std::vector<int> slotSizes;
+    std::vector<int> nextSlot;   // per class, the slot the next event overwrites
+    std::vector<int> usedSlots;  // per class, slots holding an event
+    std::vector<std::vector<Hadronium>> mixed;
+
+    int classIndex(const LundEvent& event, const std::vector<Hadronium>& particles) const;
+};
+
+#endif // EVENT_MIXING_H
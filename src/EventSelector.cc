@@ -0,0 +1,51 @@
+#include "EventSelector.h"
+#include "HadroniumParser.h"
+#include <stdexcept>
+
+EventSelector::EventSelector(const std::string& criteria, HadroniumAnalysisType analysisType) : criteria(criteria) {
+    size_t arity = candidateArity(analysisType);
+    if (arity > 1 && count_criteria_groups(criteria) != static_cast<int>(arity)) {
+        throw std::runtime_error("Criteria '" + criteria + "' must contain exactly " + std::to_string(arity) + " groups for this analysis type");
+    }
+    OutputOptions options;
+    options.format = OutputFormat::None;
+    tree.init("", analysisType, options);
+    tree.addRowObserver([this]() { passed = true; });
+}
+
+// The analysis smears every event with random numbers keyed by its file and
+// position in it, which are not known before the events are written, so no
+// selection can follow the smeared kinematics
+EventSelector::EventSelector(const AnalysisConfig& config) : EventSelector(config.criteria, config.analysisType) {
+    if (!config.fastSimulationMap.empty()) {
+        throw std::runtime_error("Analysis cards with a fast simulation (FastSim:map) cannot select the generated events: the smearing moves events across the cuts, so the selected samples would be biased");
+    }
+    rules = config.rules;
+    acc = config.acceptance;
+    tree.kinematicCuts = config.cuts;
+}
+
+void EventSelector::setFilterRules(const FilterRules& rules) {
+    this->rules = rules;
+}
+
+void EventSelector::addKinematicCut(const KinematicCut& cut) {
+    tree.kinematicCuts.push_back(cut);
+}
+
+void EventSelector::setAcceptance(AcceptanceType acc) {
+    this->acc = acc;
+}
+
+bool EventSelector::select(LundEvent& event) {
+    nGenerated++;
+    std::vector<std::vector<Hadronium>> hadronia = reconstruct_hadronia(convertLundEventToHadronia(event, acc), criteria);
+    if (!rules.isEmpty()) {
+        hadronia = filterHadronia(hadronia, rules);
+    }
+    if (hadronia.empty()) return false;
+    passed = false;
+    tree.Fill(event, hadronia);
+    if (passed) nAccepted++;
+    return passed;
+}
@@ -0,0 +1,49 @@
+#ifndef EVENT_SELECTOR_H
+#define EVENT_SELECTOR_H
+
+#include "AnalysisConfig.h"
+#include "DISTree.h"
+#include "HadroniaFilter.h"
+#include "KinematicCut.h"
+#include "LundReader.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Selects the events that would give LundAnalysis at least one output row:
+// the hadronia of the criteria, among the accepted particles, that pass the
+// filter rules and the kinematic cuts. The cuts are evaluated by a DISTree
+// without output, so they act exactly as in the analysis. Used by the
+// generators to write only the events of an analysis. Cards with a fast
+// simulation are refused, as its smearing moves events across the cuts;
+// mixing and the other settings of an analysis card are not applied.
+// One selector per thread.
+class EventSelector {
+public:
+    EventSelector(const std::string& criteria, HadroniumAnalysisType analysisType);
+    // Criteria, type, acceptance, filter rules and cuts of an analysis card;
+    // throws for cards with a fast simulation
+    explicit EventSelector(const AnalysisConfig& config);
+    EventSelector(const EventSelector&) = delete;
+    EventSelector& operator=(const EventSelector&) = delete;
+
+    void setFilterRules(const FilterRules& rules);
+    void addKinematicCut(const KinematicCut& cut);
+    void setAcceptance(AcceptanceType acc);
+
+    bool select(LundEvent& event);
+    // Events given to select and those selected
+    std::uint64_t generated() const { return nGenerated; }
+    std::uint64_t accepted() const { return nAccepted; }
+
+private:
+    std::string criteria;
+    FilterRules rules;
+    AcceptanceType acc = AcceptanceType::ALL;
+    DISTree tree;
+    bool passed = false;
+    std::uint64_t nGenerated = 0;
+    std::uint64_t nAccepted = 0;
+};
+
+#endif // EVENT_SELECTOR_H
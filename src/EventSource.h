@@ -0,0 +1,21 @@
+#ifndef EVENT_SOURCE_H
+#define EVENT_SOURCE_H
+
+#include "LundReader.h"
+#include <string>
+
+// Events for LundAnalysis::run(EventSource&) that do not come from input
+// files, e.g. those of generators started by the program (see
+// pythia_programs/PythiaEventSource.h). next() is called by all analysis
+// threads at once and must be thread-safe.
+class EventSource {
+public:
+    virtual ~EventSource() {}
+    // Fills the next event and its number, unique within the source (used as
+    // eventIndex and for the random numbers of the event); false at the end
+    virtual bool next(LundEvent& event, long& index) = 0;
+    // Stands for the input file in the file table and the event keys
+    virtual std::string name() const = 0;
+};
+
+#endif // EVENT_SOURCE_H
@@ -0,0 +1,178 @@
+#include "FastSimulation.h"
+#include "CounterRandom.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const double kDegree = 3.14159265358979323846 / 180;
+
+std::string trim(const std::string& s) {
+    const char* whitespace = " \t\r\n";
+    size_t first = s.find_first_not_of(whitespace);
+    if (first == std::string::npos) return "";
+    size_t last = s.find_last_not_of(whitespace);
+    return s.substr(first, last - first + 1);
+}
+
+// "v1 v2*n ..." with v*n repeating v n times
+void appendValues(std::vector<double>& values, const std::string& text) {
+    std::istringstream iss(text);
+    std::string token;
+    while (iss >> token) {
+        size_t star = token.find('*');
+        double value = std::stod(token.substr(0, star));
+        int count = star == std::string::npos ? 1 : std::stoi(token.substr(star + 1));
+        values.insert(values.end(), count, value);
+    }
+}
+
+} // namespace
+
+int FastSimulation::Axis::bin(double value) const {
+    if (!(value >= min && value < max)) return -1;
+    int i = (int)((value - min) * scale);
+    return i < n ? i : n - 1;
+}
+
+FastSimulation::FastSimulation(const std::string& filename, std::uint64_t seed) : seed(seed) {
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        throw std::runtime_error("Unable to open fast simulation map: " + filename);
+    }
+
+    // Tables are collected per block and checked once the block is complete
+    std::vector<double> acceptance, efficiency;
+    auto finishBlock = [&]() {
+        if (responses.empty()) return;
+        Response& r = responses.back();
+        std::size_t nBins = (std::size_t)r.p.n * r.theta.n * r.phi.n;
+        if (acceptance.empty()) acceptance.assign(nBins, 1.0);
+        if (efficiency.empty()) efficiency.assign(nBins, 1.0);
+        if (acceptance.size() != nBins || efficiency.size() != nBins) {
+            throw std::runtime_error(filename + ": acceptance and efficiency need " + std::to_string(nBins) + " values per species");
+        }
+        r.probability.resize(nBins);
+        for (std::size_t i = 0; i < nBins; ++i) r.probability[i] = acceptance[i] * efficiency[i];
+        acceptance.clear();
+        efficiency.clear();
+    };
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('!')));
+        if (line.empty()) continue;
+
+        std::string where = filename + ":" + std::to_string(lineNumber) + ": ";
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error(where + "expected 'key = value'");
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::istringstream value(trim(line.substr(eq + 1)));
+
+        if (key == "Particle:pid") {
+            finishBlock();
+            responses.emplace_back();
+            int pid;
+            while (value >> pid) responseOfPid[pid] = responses.size() - 1;
+            continue;
+        }
+        if (responses.empty()) {
+            throw std::runtime_error(where + "'" + key + "' before the first Particle:pid");
+        }
+        Response& r = responses.back();
+        if (key == "Bins:p" || key == "Bins:theta" || key == "Bins:phi") {
+            Axis axis;
+            if (!(value >> axis.n >> axis.min >> axis.max) || axis.n < 1 || axis.max <= axis.min) {
+                throw std::runtime_error(where + "malformed binning");
+            }
+            axis.scale = axis.n / (axis.max - axis.min);
+            if (key == "Bins:p") r.p = axis;
+            else if (key == "Bins:theta") r.theta = axis;
+            else r.phi = axis;
+        }
+        else if (key == "Acceptance") appendValues(acceptance, value.str());
+        else if (key == "Efficiency") appendValues(efficiency, value.str());
+        else if (key == "Resolution:p") {
+            if (!(value >> r.sigmaA)) throw std::runtime_error(where + "malformed resolution");
+            value >> r.sigmaB;
+        }
+        else if (key == "Resolution:theta") {
+            if (!(value >> r.sigmaTheta)) throw std::runtime_error(where + "malformed resolution");
+            r.sigmaTheta *= kDegree;
+        }
+        else if (key == "Resolution:phi") {
+            if (!(value >> r.sigmaPhi)) throw std::runtime_error(where + "malformed resolution");
+            r.sigmaPhi *= kDegree;
+        }
+        else {
+            throw std::runtime_error(where + "unknown key '" + key + "'");
+        }
+    }
+    finishBlock();
+}
+
+bool FastSimulation::apply(LundEvent& event, std::uint64_t eventKey) const {
+    std::uint64_t streamBase = splitmix64(seed ^ splitmix64(eventKey));
+    bool leptonFound = false;
+    for (std::size_t i = 0; i < event.particles.size(); ++i) {
+        LundParticle& particle = event.particles[i];
+        if (particle.status != 1) continue;
+        bool isLepton = particle.particle_id == 11 && !leptonFound;
+        if (isLepton) leptonFound = true;
+
+        auto found = responseOfPid.find(particle.particle_id);
+        if (found == responseOfPid.end()) continue;
+        const Response& r = responses[found->second];
+        RandomStream random{splitmix64(streamBase + i)};
+
+        double pt = std::sqrt(particle.px * particle.px + particle.py * particle.py);
+        double p = std::sqrt(pt * pt + particle.pz * particle.pz);
+        double theta = std::atan2(pt, particle.pz);
+        // The azimuth itself is only needed to look up a binned phi map
+        int iphi = r.phi.n == 1 ? 0 : r.phi.bin(std::atan2(particle.py, particle.px) / kDegree);
+
+        int ip = r.p.bin(p), itheta = r.theta.bin(theta / kDegree);
+        double probability = 0;
+        if (ip >= 0 && itheta >= 0 && iphi >= 0) {
+            probability = r.probability[((std::size_t)ip * r.theta.n + itheta) * r.phi.n + iphi];
+        }
+        if (random.uniform() > probability) {
+            particle.status = LostStatus;
+            if (isLepton) return false;
+            continue;
+        }
+
+        double gp, gtheta, gphi, unused;
+        random.gaus(gp, gtheta);
+        random.gaus(gphi, unused);
+        double sigmaP = std::sqrt(r.sigmaA * r.sigmaA + r.sigmaB * p * r.sigmaB * p);
+        p *= 1 + sigmaP * gp;
+        theta += r.sigmaTheta * gtheta;
+        // Rotate the azimuth by dphi with the addition formulas
+        double cosPhi = pt > 0 ? particle.px / pt : 1, sinPhi = pt > 0 ? particle.py / pt : 0;
+        double dphi = r.sigmaPhi * gphi;
+        double cosDphi = std::cos(dphi), sinDphi = std::sin(dphi);
+        double sinTheta = std::sin(theta);
+        particle.px = p * sinTheta * (cosPhi * cosDphi - sinPhi * sinDphi);
+        particle.py = p * sinTheta * (sinPhi * cosDphi + cosPhi * sinDphi);
+        particle.pz = p * std::cos(theta);
+        particle.e = std::sqrt(p * p + particle.m * particle.m);
+    }
+    return true;
+}
+
+std::uint64_t FastSimulation::eventKey(const std::string& filename, std::uint64_t index) {
+    // FNV-1a of the base name, so the key does not depend on the directory
+    std::string name = filename.substr(filename.find_last_of('/') + 1);
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return splitmix64(hash) ^ index;
+}
@@ -0,0 +1,62 @@
+#ifndef FAST_SIMULATION_H
+#define FAST_SIMULATION_H
+
+#include "LundReader.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Parametric detector response: binned acceptance and efficiency maps and
+// Gaussian resolutions per particle species, read from a map file. The file
+// uses the card syntax ("key = value ! comment"); every Particle:pid line
+// starts the response of the listed species:
+//
+//   Particle:pid     = 211 -211
+//   Bins:p           = 44 0 11      ! uniform bins: count, min, max (GeV)
+//   Bins:theta       = 30 5 35      ! degrees
+//   Bins:phi         = 1 -180 180   ! degrees
+//   Acceptance       = 0*5 1*39     ! one value per bin, phi fastest, p slowest
+//   Efficiency       = 0.95*44      ! value*count repeats a value
+//   Resolution:p     = 0.006 0.001  ! sigma_p/p = a (+) b*p (added in quadrature)
+//   Resolution:theta = 0.06         ! degrees
+//   Resolution:phi   = 0.2          ! degrees
+//
+// Acceptance and Efficiency default to 1 and may be split over several lines.
+// Particles outside the bins are lost. Species without a response are left
+// untouched.
+class FastSimulation {
+public:
+    // Status given to final state particles lost by the detector
+    static const int LostStatus = -1;
+
+    explicit FastSimulation(const std::string& filename, std::uint64_t seed = 0);
+
+    // Applies acceptance, efficiency and smearing to the final state particles
+    // of the event. Returns false if the scattered lepton (the first final
+    // state electron) is lost. The random numbers depend only on the seed,
+    // the event key and the particle index, never on the processing order.
+    bool apply(LundEvent& event, std::uint64_t eventKey) const;
+
+    // Event key of the index-th event of a file, from the file's name
+    static std::uint64_t eventKey(const std::string& filename, std::uint64_t index);
+
+private:
+    struct Axis {
+        int n = 1;
+        double min = 0, max = 0, scale = 0; // scale = n / (max - min)
+        int bin(double value) const; // -1 outside
+    };
+    struct Response {
+        Axis p, theta, phi;
+        std::vector<double> probability; // acceptance x efficiency per bin
+        double sigmaA = 0, sigmaB = 0;   // relative momentum resolution terms
+        double sigmaTheta = 0, sigmaPhi = 0; // radians
+    };
+
+    std::vector<Response> responses;
+    std::unordered_map<int, std::size_t> responseOfPid;
+    std::uint64_t seed;
+};
+
+#endif // FAST_SIMULATION_H
@@ -0,0 +1,96 @@
+#ifndef FOUR_VECTOR_H
+#define FOUR_VECTOR_H
+
+#include <cmath>
+
+// Lightweight, trivially copyable replacements for TVector3 and TLorentzVector.
+// The arithmetic follows the ROOT implementations operation by operation, so
+// results agree with them to rounding.
+
+struct ThreeVector {
+    double x = 0.0, y = 0.0, z = 0.0;
+
+    ThreeVector() = default;
+    ThreeVector(double x, double y, double z) : x(x), y(y), z(z) {}
+
+    ThreeVector operator+(const ThreeVector& o) const { return ThreeVector(x + o.x, y + o.y, z + o.z); }
+    ThreeVector operator-(const ThreeVector& o) const { return ThreeVector(x - o.x, y - o.y, z - o.z); }
+    ThreeVector operator-() const { return ThreeVector(-x, -y, -z); }
+    ThreeVector operator*(double a) const { return ThreeVector(a * x, a * y, a * z); }
+    double dot(const ThreeVector& o) const { return x * o.x + y * o.y + z * o.z; }
+    ThreeVector cross(const ThreeVector& o) const {
+        return ThreeVector(y * o.z - o.y * z, z * o.x - o.z * x, x * o.y - o.x * y);
+    }
+    double mag2() const { return x * x + y * y + z * z; }
+    double mag() const { return std::sqrt(mag2()); }
+    double perp() const { return std::sqrt(x * x + y * y); }
+    double phi() const { return x == 0.0 && y == 0.0 ? 0.0 : std::atan2(y, x); }
+    double angle(const ThreeVector& o) const {
+        double ptot2 = mag2() * o.mag2();
+        if (ptot2 <= 0) return 0.0;
+        double arg = dot(o) / std::sqrt(ptot2);
+        if (arg > 1.0) arg = 1.0;
+        if (arg < -1.0) arg = -1.0;
+        return std::acos(arg);
+    }
+};
+
+inline ThreeVector operator*(double a, const ThreeVector& v) { return v * a; }
+
+// A boost by the velocity b, with its gamma factors computed once
+struct Boost {
+    ThreeVector b;
+    double gamma = 1.0;
+    double gamma2 = 0.0; // (gamma - 1) / b^2
+
+    Boost() = default;
+    explicit Boost(const ThreeVector& b) : b(b) {
+        double b2 = b.mag2();
+        gamma = 1.0 / std::sqrt(1.0 - b2);
+        gamma2 = b2 > 0 ? (gamma - 1.0) / b2 : 0.0;
+    }
+    Boost inverse() const {
+        Boost inv = *this;
+        inv.b = -b;
+        return inv;
+    }
+};
+
+struct FourVector {
+    double px = 0.0, py = 0.0, pz = 0.0, e = 0.0;
+
+    FourVector() = default;
+    FourVector(double px, double py, double pz, double e) : px(px), py(py), pz(pz), e(e) {}
+
+    FourVector operator+(const FourVector& o) const { return FourVector(px + o.px, py + o.py, pz + o.pz, e + o.e); }
+    FourVector operator-(const FourVector& o) const { return FourVector(px - o.px, py - o.py, pz - o.pz, e - o.e); }
+    FourVector operator*(double a) const { return FourVector(a * px, a * py, a * pz, a * e); }
+    // Minkowski product
+    double operator*(const FourVector& o) const { return e * o.e - pz * o.pz - py * o.py - px * o.px; }
+
+    ThreeVector vect() const { return ThreeVector(px, py, pz); }
+    double m2() const { return e * e - vect().mag2(); }
+    // Negative for space-like vectors, as TLorentzVector::M()
+    double m() const {
+        double mm = m2();
+        return mm < 0.0 ? -std::sqrt(-mm) : std::sqrt(mm);
+    }
+    double perp() const { return vect().perp(); }
+    double phi() const { return vect().phi(); }
+    ThreeVector boostVector() const { return ThreeVector(px / e, py / e, pz / e); }
+
+    // Boosts this vector by the velocity b, as TLorentzVector::Boost
+    FourVector boosted(const ThreeVector& b) const { return boosted(Boost(b)); }
+    FourVector boosted(const Boost& boost) const {
+        const ThreeVector& b = boost.b;
+        double bp = b.x * px + b.y * py + b.z * pz;
+        return FourVector(px + boost.gamma2 * bp * b.x + boost.gamma * b.x * e,
+                          py + boost.gamma2 * bp * b.y + boost.gamma * b.y * e,
+                          pz + boost.gamma2 * bp * b.z + boost.gamma * b.z * e,
+                          boost.gamma * (e + bp));
+    }
+};
+
+inline FourVector operator*(double a, const FourVector& v) { return v * a; }
+
+#endif // FOUR_VECTOR_H
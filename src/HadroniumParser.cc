@@ -135,15 +135,12 @@ std::vector<std::vector<Hadronium>> filter_duplicate_combinations(const std::vec
 }
 
 std::vector<std::vector<Hadronium>> reconstruct_hadronia(LundEvent& event, const std::string& criteria, AcceptanceType acc) {
-    auto hadronia = convertLundEventToHadronia(event, acc);
-    std::regex pattern("\\(([^()]+)\\)");
-    std::vector<std::vector<Hadronium>> reconstructed;
-    auto begin = std::sregex_iterator(criteria.begin(), criteria.end(), pattern);
-    auto end = std::sregex_iterator();
+    return reconstruct_hadronia(convertLundEventToHadronia(event, acc), criteria);
+}
 
-    for (std::sregex_iterator i = begin; i != end; ++i) {
-        std::smatch match = *i;
-        std::string group = match.str(1);
+std::vector<std::vector<Hadronium>> reconstruct_hadronia(const std::vector<Hadronium>& hadronia, const std::string& criteria) {
+    std::vector<std::vector<Hadronium>> reconstructed;
+    for (const auto& group : criteria_groups(criteria)) {
         auto group_particles = reconstruct_from_group(hadronia, group);
         if (group_particles.size()==0){
             return std::vector<std::vector<Hadronium>>(); // return empty vector if not enough particles are found
@@ -165,6 +162,21 @@ std::vector<std::vector<Hadronium>> reconstruct_hadronia(LundEvent& event, const
     return filter_duplicate_combinations(reconstructed);
 }
 
+// Contents of the parenthesized groups of the criteria, e.g. "211" and "22 22"
+// for "(211) + (22 22)"
+std::vector<std::string> criteria_groups(const std::string& criteria) {
+    std::regex pattern("\\(([^()]+)\\)");
+    std::vector<std::string> groups;
+    for (std::sregex_iterator i(criteria.begin(), criteria.end(), pattern), end; i != end; ++i) {
+        groups.push_back((*i).str(1));
+    }
+    return groups;
+}
+
+// Number of parenthesized groups, i.e. hadrons per candidate, in the criteria
+int count_criteria_groups(const std::string& criteria) {
+    return criteria_groups(criteria).size();
+}
 
 std::vector<Hadronium> convertLundEventToHadronia(LundEvent& event, AcceptanceType acc) {
     std::vector<Hadronium> hadronia;
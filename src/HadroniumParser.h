@@ -10,6 +10,7 @@
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <array>
 #include "LundReader.h"
 
 class Hadronium {
@@ -25,6 +26,23 @@ public:
     Hadronium(int pid, int status, double px, double py, double pz, double e, std::vector<int> ids = {}, int parentId = -1, int parentPid = -1, int grandParentId = -1, int grandParentPid = -1);
 };
 
+// Momentum and ancestry of one hadron of an analysis candidate
+struct CandidateHadron {
+    double px, py, pz, e;
+    int parentPid;
+    int grandParentPid;
+    int status;
+};
+
+// Fixed-size candidate of N hadrons. For N == 1 all groups of the hadronium
+// are merged into a single hadron, as combine_particles does; otherwise the
+// hadronium must contain exactly N groups.
+template<std::size_t N>
+using HadronCandidate = std::array<CandidateHadron, N>;
+
+template<std::size_t N>
+bool make_candidate(const std::vector<Hadronium>& hadronium, HadronCandidate<N>& candidate);
+
 Hadronium combine_particles(const std::vector<Hadronium>& particles);
 std::vector<Hadronium> find_particles(const std::vector<Hadronium>& event, int pid);
 
@@ -36,8 +54,49 @@ std::vector<std::vector<Hadronium>> combine_lists(const std::vector<std::vector<
 bool has_shared_ids(const std::vector<Hadronium>& combination);
 std::vector<std::vector<Hadronium>> filter_duplicate_combinations(const std::vector<std::vector<Hadronium>>& combinations);
 std::vector<std::vector<Hadronium>> reconstruct_hadronia(LundEvent& event, const std::string& criteria, AcceptanceType acc);
+// Same, from the accepted particles given by convertLundEventToHadronia
+std::vector<std::vector<Hadronium>> reconstruct_hadronia(const std::vector<Hadronium>& hadronia, const std::string& criteria);
+std::vector<std::string> criteria_groups(const std::string& criteria);
+int count_criteria_groups(const std::string& criteria);
 std::vector<Hadronium> convertLundEventToHadronia(LundEvent& event, AcceptanceType acc);
 void printHadronia(const std::vector<std::vector<Hadronium>>& hadroniums);
 
+template<std::size_t N>
+bool make_candidate(const std::vector<Hadronium>& hadronium, HadronCandidate<N>& candidate) {
+    if (hadronium.size() != N) return false;
+    for (std::size_t i = 0; i < N; ++i) {
+        const Hadronium& h = hadronium[i];
+        candidate[i] = CandidateHadron{h.px, h.py, h.pz, h.e, h.parentPid, h.grandParentPid, h.status};
+    }
+    return true;
+}
+
+template<>
+inline bool make_candidate<1>(const std::vector<Hadronium>& hadronium, HadronCandidate<1>& candidate) {
+    if (hadronium.empty()) return false;
+    // Same merging rules as combine_particles, without building the id list
+    const Hadronium& first = hadronium.front();
+    CandidateHadron merged{0, 0, 0, 0, first.parentPid, first.grandParentPid, first.status};
+    bool sameParent = true, sameGrandParent = true;
+    for (const auto& h : hadronium) {
+        merged.px += h.px;
+        merged.py += h.py;
+        merged.pz += h.pz;
+        merged.e  += h.e;
+        sameParent = sameParent && h.parentId == first.parentId;
+        sameGrandParent = sameGrandParent && h.grandParentId == first.grandParentId;
+        merged.status = std::min(merged.status, h.status);
+        merged.parentPid = std::min(merged.parentPid, h.parentPid);
+        merged.grandParentPid = std::min(merged.grandParentPid, h.grandParentPid);
+    }
+    if (!sameParent) {
+        merged.status = -1;
+        merged.parentPid = -1;
+    }
+    if (!sameGrandParent) merged.grandParentPid = -1;
+    candidate[0] = merged;
+    return true;
+}
+
 #endif // HADRONIUM_PARSER_H
 
@@ -7,7 +7,7 @@ KinematicsCalculator::KinematicsCalculator(const LundEvent& event)
     // Final Electron is the first pid==11 particle that is final state
     for (const auto& particle : event.particles) {
         if (particle.particle_id == 11 && particle.status == 1) {
-            finalElectron = TLorentzVector(particle.px, particle.py, particle.pz, particle.e);
+            finalElectron = FourVector(particle.px, particle.py, particle.pz, particle.e);
             break;
         }
     }
@@ -15,19 +15,26 @@ KinematicsCalculator::KinematicsCalculator(const LundEvent& event)
     q = initialElectron - finalElectron; // Assuming operator- is defined for Particle
     target_polarization = event.target_polarization;
     beam_polarization = event.beam_polarization;
+
+    frame.qVect = q.vect();
+    frame.qMag2 = frame.qVect.mag2();
+    frame.qcrossL = frame.qVect.cross(initialElectron.vect());
+    frame.qcrossLMag = frame.qcrossL.mag();
+    frame.Pq = initialProton * q;
+    frame.W = sqrt(initialProton.m2() + 2.0 * frame.Pq + q*q);
+    frame.toCM = Boost((q + initialProton).boostVector()).inverse();
+    frame.missing = initialElectron + initialProton - finalElectron;
 }
 
 EventKinematics KinematicsCalculator::CalculateEventKinematics() const {
-    TLorentzVector q = initialElectron - finalElectron;
-    double Q2 = -q*q;
-    double y = (q * initialProton) / (initialElectron * initialProton);
-    double x = Q2 / (2.0 * (q * initialProton));
-    double W = sqrt(initialProton.M2() + 2.0 * initialProton*q - Q2);
-    TLorentzVector targetSpin(0,target_polarization,0,0);
-    TVector3 GNS = (q + initialProton).BoostVector();
-    targetSpin.Boost(-GNS);
-    double gamma = 2*initialProton.M()*x/sqrt(Q2);
-    double phi_S = targetSpin.Phi();
+    double Q2 = -(q*q);
+    double y = frame.Pq / (initialElectron * initialProton);
+    double x = Q2 / (2.0 * frame.Pq);
+    double W = frame.W;
+    FourVector targetSpin(0,target_polarization,0,0);
+    targetSpin = targetSpin.boosted(frame.toCM);
+    double gamma = 2*initialProton.m()*x/sqrt(Q2);
+    double phi_S = targetSpin.phi();
     double epsilon = (1-y-gamma*gamma*y*y/4)/(1-y+y*y/2+gamma*gamma*y*y/4);
     double depolA = y*y/(2*(1-epsilon));
     double depolB = depolA * epsilon;
@@ -37,26 +44,108 @@ EventKinematics KinematicsCalculator::CalculateEventKinematics() const {
     return EventKinematics{x, Q2, y, W, phi_S, epsilon, gamma, depolA, depolB, depolC, depolV, depolW, target_polarization, beam_polarization};
 }
 
+SingleHadronKinematics KinematicsCalculator::CalculateHadronKinematics(const HadronCandidate<1>& candidate) const {
+    const CandidateHadron& hadron = candidate[0];
+    FourVector p(hadron.px, hadron.py, hadron.pz, hadron.e);
+    FourVector pCM = p.boosted(frame.toCM);
+
+    return SingleHadronKinematics{
+        pCM.perp(), // Transverse momentum
+        this->z(p), // z (fractional energy)
+        this->phi_h(p), // Azimuthal angle
+        p.m(), // Invariant mass
+        2 * pCM.pz / frame.W, // xF (Feynman x)
+        this->Mx(p), // Mx (Missing mass)
+        hadron.parentPid,
+        hadron.grandParentPid,
+        hadron.status
+    };
+}
+
+DiHadronKinematics KinematicsCalculator::CalculateHadronKinematics(const HadronCandidate<2>& candidate) const {
+    FourVector p1(candidate[0].px, candidate[0].py, candidate[0].pz, candidate[0].e);
+    FourVector p2(candidate[1].px, candidate[1].py, candidate[1].pz, candidate[1].e);
+    FourVector p = p1+p2;
+    FourVector p1CM = p1.boosted(frame.toCM);
+    FourVector p2CM = p2.boosted(frame.toCM);
+    FourVector pCM = p.boosted(frame.toCM);
+    double z1 = this->z(p1);
+    double z2 = this->z(p2);
+
+    return DiHadronKinematics{
+        p1CM.perp(),
+        p2CM.perp(),
+        pCM.perp(),
+        z1,
+        z2,
+        this->z(p),
+        this->phi_h(p),
+        this->phi_RT(p1,p2),
+        this->phi_Rperp(p1,p2,z1,z2),
+        this->com_th(p1,p2),
+        p.m(),
+        2 * p1CM.pz / frame.W,
+        2 * p2CM.pz / frame.W,
+        2 * pCM.pz / frame.W,
+        this->Mx(p),
+        candidate[0].parentPid,
+        candidate[0].grandParentPid,
+        candidate[0].status,
+        candidate[1].parentPid,
+        candidate[1].grandParentPid,
+        candidate[1].status
+    };
+}
+
+TriHadronKinematics KinematicsCalculator::CalculateHadronKinematics(const HadronCandidate<3>& candidate) const {
+    FourVector p1(candidate[0].px, candidate[0].py, candidate[0].pz, candidate[0].e);
+    FourVector p2(candidate[1].px, candidate[1].py, candidate[1].pz, candidate[1].e);
+    FourVector p3(candidate[2].px, candidate[2].py, candidate[2].pz, candidate[2].e);
+    FourVector p = p1+p2+p3;
+    FourVector p1CM = p1.boosted(frame.toCM);
+    FourVector p2CM = p2.boosted(frame.toCM);
+    FourVector p3CM = p3.boosted(frame.toCM);
+    FourVector pCM = p.boosted(frame.toCM);
+
+    return TriHadronKinematics{
+        p1CM.perp(),
+        p2CM.perp(),
+        p3CM.perp(),
+        pCM.perp(),
+        this->z(p1),
+        this->z(p2),
+        this->z(p3),
+        this->z(p),
+        this->phi_h(p),
+        p.m(),
+        (p1+p2).m(),
+        (p1+p3).m(),
+        (p2+p3).m(),
+        2 * p1CM.pz / frame.W,
+        2 * p2CM.pz / frame.W,
+        2 * p3CM.pz / frame.W,
+        2 * pCM.pz / frame.W,
+        this->Mx(p),
+        candidate[0].parentPid,
+        candidate[0].grandParentPid,
+        candidate[0].status,
+        candidate[1].parentPid,
+        candidate[1].grandParentPid,
+        candidate[1].status,
+        candidate[2].parentPid,
+        candidate[2].grandParentPid,
+        candidate[2].status
+    };
+}
+
 std::vector<SingleHadronKinematics> KinematicsCalculator::CalculateSingleHadronKinematics(const std::vector<std::vector<Hadronium>>& hadronia) const {
     std::vector<SingleHadronKinematics> allHadronKinematics;
+    HadronCandidate<1> candidate;
 
     for (const auto& hadronium : hadronia) {
-        Hadronium hadron = combine_particles(hadronium); // Assuming this function is implemented elsewhere
-        TLorentzVector p(hadron.px, hadron.py, hadron.pz, hadron.e);
-        
-        SingleHadronKinematics kinematics{
-            this->Pt_COM(p), // Transverse momentum
-            this->z(p), // z (fractional energy)
-            this->phi_h(p), // Azimuthal angle
-            p.M(), // Invariant mass
-            this->xF(p), // xF (Feynman x)
-            this->Mx(p), // Mx (Missing mass)
-            hadron.parentPid,
-            hadron.grandParentPid,
-            hadron.status
-        };
-        
-        allHadronKinematics.push_back(kinematics);
+        if (make_candidate(hadronium, candidate)) {
+            allHadronKinematics.push_back(CalculateHadronKinematics(candidate));
+        }
     }
 
     return allHadronKinematics;
@@ -65,156 +154,182 @@ std::vector<SingleHadronKinematics> KinematicsCalculator::CalculateSingleHadronK
 
 std::vector<DiHadronKinematics> KinematicsCalculator::CalculateDiHadronKinematics(const std::vector<std::vector<Hadronium>>& hadronia) const {
     std::vector<DiHadronKinematics> allDiHadronKinematics;
+    HadronCandidate<2> candidate;
 
     for (const auto& hadronium : hadronia) {
-        
-        TLorentzVector p1(hadronium.at(0).px, hadronium.at(0).py, hadronium.at(0).pz, hadronium.at(0).e);
-        TLorentzVector p2(hadronium.at(1).px, hadronium.at(1).py, hadronium.at(1).pz, hadronium.at(1).e);
-        TLorentzVector p = p1+p2;
-        DiHadronKinematics kinematics{
-            this->Pt_COM(p1),
-            this->Pt_COM(p2),
-            this->Pt_COM(p),
-            this->z(p1),
-            this->z(p2),
-            this->z(p),
-            this->phi_h(p),
-            this->phi_RT(p1,p2),
-            this->phi_Rperp(p1,p2),
-            this->com_th(p1,p2),
-            p.M(),
-            this->xF(p1),
-            this->xF(p2),
-            this->xF(p),
-            this->Mx(p),
-            hadronium.at(0).parentPid,
-            hadronium.at(0).grandParentPid,
-            hadronium.at(0).status,
-            hadronium.at(1).parentPid,
-            hadronium.at(1).grandParentPid,
-            hadronium.at(1).status
-        };
-        
-        allDiHadronKinematics.push_back(kinematics);
+        if (make_candidate(hadronium, candidate)) {
+            allDiHadronKinematics.push_back(CalculateHadronKinematics(candidate));
+        }
     }
 
     return allDiHadronKinematics;
 }
 
 
-double KinematicsCalculator::phi_h(TLorentzVector p1, TLorentzVector p2) const {
-    TLorentzVector ph = p1 + p2;
-    TVector3 Ph(ph.Px(), ph.Py(), ph.Pz());
-    TVector3 qVect(q.Px(), q.Py(), q.Pz());
-    TVector3 initialElectronVect(initialElectron.Px(), initialElectron.Py(), initialElectron.Pz());
-
-    TVector3 qcrossL = qVect.Cross(initialElectronVect);
-    TVector3 qcrossPh = qVect.Cross(Ph);
+// Signed azimuthal angle of v around q, measured from the lepton plane
+double KinematicsCalculator::azimuth(const ThreeVector& v) const {
+    ThreeVector qcrossV = frame.qVect.cross(v);
 
-    double factor1 = (qcrossL * Ph) / abs(qcrossL * Ph);
-    double factor2 = (qcrossL * qcrossPh) / qcrossL.Mag() / qcrossPh.Mag();
+    double factor1 = frame.qcrossL.dot(v) / std::abs(frame.qcrossL.dot(v));
+    double factor2 = frame.qcrossL.dot(qcrossV) / frame.qcrossLMag / qcrossV.mag();
 
     return factor1 * acos(factor2);
 }
 
+double KinematicsCalculator::phi_h(const FourVector& p1, const FourVector& p2) const {
+    return azimuth((p1 + p2).vect());
+}
+
 
-double KinematicsCalculator::z(TLorentzVector part) const {
-    return (initialProton * part) / (initialProton * q);
+double KinematicsCalculator::z(const FourVector& part) const {
+    return (initialProton * part) / frame.Pq;
 }
 
-double KinematicsCalculator::Mx(TLorentzVector part) const {
-    return (initialElectron + initialProton - finalElectron - part).M();
+double KinematicsCalculator::Mx(const FourVector& part) const {
+    return (frame.missing - part).m();
 }
 
 
 // Method to calculate phi_h for a single hadron
-double KinematicsCalculator::phi_h(TLorentzVector p) const {
-    TVector3 Ph(p.Px(), p.Py(), p.Pz());
-    TVector3 qVect(q.Px(), q.Py(), q.Pz());
-    TVector3 initialElectronVect(initialElectron.Px(), initialElectron.Py(), initialElectron.Pz());
-
-    TVector3 qcrossL = qVect.Cross(initialElectronVect);
-    TVector3 qcrossPh = qVect.Cross(Ph);
-
-    double factor1 = (qcrossL * Ph) / abs(qcrossL * Ph);
-    double factor2 = (qcrossL * qcrossPh) / qcrossL.Mag() / qcrossPh.Mag();
-
-    return factor1 * acos(factor2);
+double KinematicsCalculator::phi_h(const FourVector& p) const {
+    return azimuth(p.vect());
 }
 
-double KinematicsCalculator::xF(TLorentzVector p) const {
-    
-    double W = sqrt(initialProton.M2() + 2.0 * initialProton*q + q*q);
-        
-    TLorentzVector com = q + initialProton;
-    TVector3 comBoost = com.BoostVector();
-    
-    TLorentzVector pp = p;
-    pp.Boost(-comBoost);
-
-    return 2 * pp.Pz() / W;
+double KinematicsCalculator::xF(const FourVector& p) const {
+    return 2 * p.boosted(frame.toCM).pz / frame.W;
 }
 
-double KinematicsCalculator::Pt_COM(TLorentzVector p) const {
-    TLorentzVector com = q + initialProton;
-    TVector3 comBoost = com.BoostVector();
-    
-    TLorentzVector pp = p;
-    pp.Boost(-comBoost);
-
-    return pp.Perp();
+double KinematicsCalculator::Pt_COM(const FourVector& p) const {
+    return p.boosted(frame.toCM).perp();
 }
 
 // Method to calculate phi_RT
-double KinematicsCalculator::phi_RT(TLorentzVector p1, TLorentzVector p2) const {
-    TLorentzVector r = 0.5 * (p1 - p2);
-    TVector3 R(r.Px(), r.Py(), r.Pz());
+double KinematicsCalculator::phi_RT(const FourVector& p1, const FourVector& p2) const {
+    FourVector r = 0.5 * (p1 - p2);
+    ThreeVector R = r.vect();
 
-    TVector3 Rperp;
-    Rperp = R - (R.Dot(q.Vect()) / q.Vect().Mag2()) * q.Vect();
+    ThreeVector Rperp = R - (R.dot(frame.qVect) / frame.qMag2) * frame.qVect;
 
-    TVector3 qVect(q.Px(), q.Py(), q.Pz());
-    TVector3 initialElectronVect(initialElectron.Px(), initialElectron.Py(), initialElectron.Pz());
-
-    TVector3 qcrossL = qVect.Cross(initialElectronVect);
-    TVector3 qcrossRperp = qVect.Cross(Rperp);
+    return azimuth(Rperp);
+}
 
-    double factor1 = (qcrossL * Rperp) / abs(qcrossL * Rperp);
-    double factor2 = (qcrossL * qcrossRperp) / qcrossL.Mag() / qcrossRperp.Mag();
 
-    return factor1 * acos(factor2);
+// Method to calculate phi_Rperp
+double KinematicsCalculator::phi_Rperp(const FourVector& p1, const FourVector& p2) const {
+    return phi_Rperp(p1, p2, z(p1), z(p2));
 }
 
+double KinematicsCalculator::phi_Rperp(const FourVector& p1, const FourVector& p2, double z1, double z2) const {
+    const ThreeVector& qVect = frame.qVect;
+    ThreeVector P1perp = p1.vect() - (p1.vect().dot(qVect) / frame.qMag2) * qVect;
+    ThreeVector P2perp = p2.vect() - (p2.vect().dot(qVect) / frame.qMag2) * qVect;
+    ThreeVector Rperp = (z2 * P1perp - z1 * P2perp) * (1 / (z1 + z2));
 
-// Method to calculate phi_Rperp
-double KinematicsCalculator::phi_Rperp(TLorentzVector p1, TLorentzVector p2) const {
-    TLorentzVector r = 0.5 * (p1 - p2);
-    TVector3 R(r.Px(), r.Py(), r.Pz());
+    return azimuth(Rperp);
+}
 
-    TVector3 Rperp;
-    double z1 = z(p1);
-    double z2 = z(p2);
-    TVector3 P1perp = p1.Vect() - (p1.Vect().Dot(q.Vect()) / q.Vect().Mag2()) * q.Vect();
-    TVector3 P2perp = p2.Vect() - (p2.Vect().Dot(q.Vect()) / q.Vect().Mag2()) * q.Vect();
-    Rperp = (z2 * P1perp - z1 * P2perp) * (1 / (z1 + z2));
+// Method to calculate dihadron theta in the center of mass frame
+double KinematicsCalculator::com_th(const FourVector& P1, const FourVector& P2) const {
+    FourVector Ptotal = P1 + P2;
+    ThreeVector comBoost = Ptotal.boostVector();
 
-    TVector3 qVect(q.Px(), q.Py(), q.Pz());
-    TVector3 initialElectronVect(initialElectron.Px(), initialElectron.Py(), initialElectron.Pz());
+    return P1.boosted(-comBoost).vect().angle(comBoost);
+}
 
-    TVector3 qcrossL = qVect.Cross(initialElectronVect);
-    TVector3 qcrossRperp = qVect.Cross(Rperp);
+namespace {
 
-    double factor1 = (qcrossL * Rperp) / abs(qcrossL * Rperp);
-    double factor2 = (qcrossL * qcrossRperp) / qcrossL.Mag() / qcrossRperp.Mag();
+FourVector fourVector(const CandidateHadron& h) {
+    return FourVector(h.px, h.py, h.pz, h.e);
+}
 
-    return factor1 * acos(factor2);
+template<std::size_t N>
+FourVector total(const HadronCandidate<N>& c) {
+    FourVector p = fourVector(c[0]);
+    for (std::size_t i = 1; i < N; ++i) p = p + fourVector(c[i]);
+    return p;
 }
 
-// Method to calculate dihadron theta in the center of mass frame
-double KinematicsCalculator::com_th(TLorentzVector P1, TLorentzVector P2) const {
-    TLorentzVector Ptotal = P1 + P2;
-    TVector3 comBoost = Ptotal.BoostVector();
+} // namespace
+
+// Costs count a boost or an invariant mass as about 2, an azimuthal angle
+// (two cross products and an acos) as about 5
+template<>
+const std::vector<HadronVariable<1>>& hadronVariables<1>() {
+    typedef HadronCandidate<1> C;
+    static const std::vector<HadronVariable<1>> variables = {
+        {"pt", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(fourVector(c[0])); }, 2},
+        {"z", [](const KinematicsCalculator& k, const C& c) { return k.z(fourVector(c[0])); }, 1},
+        {"phi", [](const KinematicsCalculator& k, const C& c) { return k.phi_h(fourVector(c[0])); }, 5},
+        {"Mh", [](const KinematicsCalculator&, const C& c) { return fourVector(c[0]).m(); }, 1},
+        {"xF", [](const KinematicsCalculator& k, const C& c) { return k.xF(fourVector(c[0])); }, 2},
+        {"Mx", [](const KinematicsCalculator& k, const C& c) { return k.Mx(fourVector(c[0])); }, 1},
+        {"parentPid", [](const KinematicsCalculator&, const C& c) { return (double)c[0].parentPid; }, 0},
+        {"grandParentPid", [](const KinematicsCalculator&, const C& c) { return (double)c[0].grandParentPid; }, 0},
+        {"status", [](const KinematicsCalculator&, const C& c) { return (double)c[0].status; }, 0},
+    };
+    return variables;
+}
+
+template<>
+const std::vector<HadronVariable<2>>& hadronVariables<2>() {
+    typedef HadronCandidate<2> C;
+    static const std::vector<HadronVariable<2>> variables = {
+        {"pt1", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(fourVector(c[0])); }, 2},
+        {"pt2", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(fourVector(c[1])); }, 2},
+        {"pt", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(total(c)); }, 2},
+        {"z1", [](const KinematicsCalculator& k, const C& c) { return k.z(fourVector(c[0])); }, 1},
+        {"z2", [](const KinematicsCalculator& k, const C& c) { return k.z(fourVector(c[1])); }, 1},
+        {"z", [](const KinematicsCalculator& k, const C& c) { return k.z(total(c)); }, 1},
+        {"phi_h", [](const KinematicsCalculator& k, const C& c) { return k.phi_h(total(c)); }, 5},
+        {"phi_RT", [](const KinematicsCalculator& k, const C& c) { return k.phi_RT(fourVector(c[0]), fourVector(c[1])); }, 6},
+        {"phi_Rperp", [](const KinematicsCalculator& k, const C& c) { return k.phi_Rperp(fourVector(c[0]), fourVector(c[1])); }, 7},
+        {"th", [](const KinematicsCalculator& k, const C& c) { return k.com_th(fourVector(c[0]), fourVector(c[1])); }, 5},
+        {"Mh", [](const KinematicsCalculator&, const C& c) { return total(c).m(); }, 1},
+        {"xF1", [](const KinematicsCalculator& k, const C& c) { return k.xF(fourVector(c[0])); }, 2},
+        {"xF2", [](const KinematicsCalculator& k, const C& c) { return k.xF(fourVector(c[1])); }, 2},
+        {"xF", [](const KinematicsCalculator& k, const C& c) { return k.xF(total(c)); }, 2},
+        {"Mx", [](const KinematicsCalculator& k, const C& c) { return k.Mx(total(c)); }, 1},
+        {"parentPid1", [](const KinematicsCalculator&, const C& c) { return (double)c[0].parentPid; }, 0},
+        {"grandParentPid1", [](const KinematicsCalculator&, const C& c) { return (double)c[0].grandParentPid; }, 0},
+        {"status1", [](const KinematicsCalculator&, const C& c) { return (double)c[0].status; }, 0},
+        {"parentPid2", [](const KinematicsCalculator&, const C& c) { return (double)c[1].parentPid; }, 0},
+        {"grandParentPid2", [](const KinematicsCalculator&, const C& c) { return (double)c[1].grandParentPid; }, 0},
+        {"status2", [](const KinematicsCalculator&, const C& c) { return (double)c[1].status; }, 0},
+    };
+    return variables;
+}
 
-    P1.Boost(-comBoost);
-    return P1.Vect().Angle(comBoost);
+template<>
+const std::vector<HadronVariable<3>>& hadronVariables<3>() {
+    typedef HadronCandidate<3> C;
+    static const std::vector<HadronVariable<3>> variables = {
+        {"pt1", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(fourVector(c[0])); }, 2},
+        {"pt2", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(fourVector(c[1])); }, 2},
+        {"pt3", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(fourVector(c[2])); }, 2},
+        {"pt", [](const KinematicsCalculator& k, const C& c) { return k.Pt_COM(total(c)); }, 2},
+        {"z1", [](const KinematicsCalculator& k, const C& c) { return k.z(fourVector(c[0])); }, 1},
+        {"z2", [](const KinematicsCalculator& k, const C& c) { return k.z(fourVector(c[1])); }, 1},
+        {"z3", [](const KinematicsCalculator& k, const C& c) { return k.z(fourVector(c[2])); }, 1},
+        {"z", [](const KinematicsCalculator& k, const C& c) { return k.z(total(c)); }, 1},
+        {"phi_h", [](const KinematicsCalculator& k, const C& c) { return k.phi_h(total(c)); }, 5},
+        {"Mh", [](const KinematicsCalculator&, const C& c) { return total(c).m(); }, 1},
+        {"M12", [](const KinematicsCalculator&, const C& c) { return (fourVector(c[0]) + fourVector(c[1])).m(); }, 1},
+        {"M13", [](const KinematicsCalculator&, const C& c) { return (fourVector(c[0]) + fourVector(c[2])).m(); }, 1},
+        {"M23", [](const KinematicsCalculator&, const C& c) { return (fourVector(c[1]) + fourVector(c[2])).m(); }, 1},
+        {"xF1", [](const KinematicsCalculator& k, const C& c) { return k.xF(fourVector(c[0])); }, 2},
+        {"xF2", [](const KinematicsCalculator& k, const C& c) { return k.xF(fourVector(c[1])); }, 2},
+        {"xF3", [](const KinematicsCalculator& k, const C& c) { return k.xF(fourVector(c[2])); }, 2},
+        {"xF", [](const KinematicsCalculator& k, const C& c) { return k.xF(total(c)); }, 2},
+        {"Mx", [](const KinematicsCalculator& k, const C& c) { return k.Mx(total(c)); }, 1},
+        {"parentPid1", [](const KinematicsCalculator&, const C& c) { return (double)c[0].parentPid; }, 0},
+        {"grandParentPid1", [](const KinematicsCalculator&, const C& c) { return (double)c[0].grandParentPid; }, 0},
+        {"status1", [](const KinematicsCalculator&, const C& c) { return (double)c[0].status; }, 0},
+        {"parentPid2", [](const KinematicsCalculator&, const C& c) { return (double)c[1].parentPid; }, 0},
+        {"grandParentPid2", [](const KinematicsCalculator&, const C& c) { return (double)c[1].grandParentPid; }, 0},
+        {"status2", [](const KinematicsCalculator&, const C& c) { return (double)c[1].status; }, 0},
+        {"parentPid3", [](const KinematicsCalculator&, const C& c) { return (double)c[2].parentPid; }, 0},
+        {"grandParentPid3", [](const KinematicsCalculator&, const C& c) { return (double)c[2].grandParentPid; }, 0},
+        {"status3", [](const KinematicsCalculator&, const C& c) { return (double)c[2].status; }, 0},
+    };
+    return variables;
 }
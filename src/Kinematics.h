@@ -1,34 +1,68 @@
 #ifndef KINEMATICS_H
 #define KINEMATICS_H
 
-#include "TLorentzVector.h"
+#include "FourVector.h"
 #include "LundReader.h"
 #include "HadroniumParser.h"
 #include "KinematicsStructs.h"
+#include <cstddef>
 #include <vector>
 
+// Quantities of an event shared by all of its hadrons, computed once
+struct EventFrame {
+    ThreeVector qVect;
+    double qMag2 = 0.0;      // |q|^2
+    ThreeVector qcrossL;     // q x l, normal to the lepton plane
+    double qcrossLMag = 0.0;
+    double Pq = 0.0;         // P.q
+    double W = 0.0;
+    Boost toCM;              // lab to photon-nucleon center of mass (GNS) frame
+    FourVector missing;      // l + P - l', for the missing mass
+};
+
 class KinematicsCalculator {
 private:
-    TLorentzVector initialElectron;
-    TLorentzVector initialProton;
-    TLorentzVector finalElectron;
-    TLorentzVector q; // Virtual photon
+    FourVector initialElectron;
+    FourVector initialProton;
+    FourVector finalElectron;
+    FourVector q; // Virtual photon
+    EventFrame frame;
     int target_polarization, beam_polarization;
+    double azimuth(const ThreeVector& v) const;
+    double phi_Rperp(const FourVector& p1, const FourVector& p2, double z1, double z2) const;
+    template<std::size_t N> friend class KinematicsBatch;
 public:
     KinematicsCalculator(const LundEvent& event);
+    const EventFrame& Frame() const { return frame; }
 
     EventKinematics CalculateEventKinematics() const;
+    SingleHadronKinematics CalculateHadronKinematics(const HadronCandidate<1>& candidate) const;
+    DiHadronKinematics CalculateHadronKinematics(const HadronCandidate<2>& candidate) const;
+    TriHadronKinematics CalculateHadronKinematics(const HadronCandidate<3>& candidate) const;
     std::vector<SingleHadronKinematics> CalculateSingleHadronKinematics(const std::vector<std::vector<Hadronium>>& hadronia) const;
     std::vector<DiHadronKinematics> CalculateDiHadronKinematics(const std::vector<std::vector<Hadronium>>& hadronia) const;
-    double phi_h(TLorentzVector p1, TLorentzVector p2) const;
-    double phi_h(TLorentzVector p) const;
-    double xF(TLorentzVector p) const;
-    double Pt_COM(TLorentzVector dihadron) const;
-    double phi_RT(TLorentzVector p1, TLorentzVector p2) const;
-    double phi_Rperp(TLorentzVector p1, TLorentzVector p2) const;
-    double com_th(TLorentzVector P1, TLorentzVector P2) const;
-    double z(TLorentzVector part) const;
-    double Mx(TLorentzVector part) const;
+    double phi_h(const FourVector& p1, const FourVector& p2) const;
+    double phi_h(const FourVector& p) const;
+    double xF(const FourVector& p) const;
+    double Pt_COM(const FourVector& dihadron) const;
+    double phi_RT(const FourVector& p1, const FourVector& p2) const;
+    double phi_Rperp(const FourVector& p1, const FourVector& p2) const;
+    double com_th(const FourVector& P1, const FourVector& P2) const;
+    double z(const FourVector& part) const;
+    double Mx(const FourVector& part) const;
 };
 
+// A single column of HadronKinematics<N>, computed on its own so that the
+// kinematic cuts can reject a candidate before its other columns are computed.
+// The value is identical to the one CalculateHadronKinematics stores.
+template<std::size_t N>
+struct HadronVariable {
+    const char* name;
+    double (*evaluate)(const KinematicsCalculator& kin, const HadronCandidate<N>& candidate);
+    int cost; // rough relative cost of the evaluation
+};
+
+// The columns of HadronKinematics<N> that can be computed on their own
+template<std::size_t N> const std::vector<HadronVariable<N>>& hadronVariables();
+
 #endif // KINEMATICS_H
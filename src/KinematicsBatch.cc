@@ -0,0 +1,159 @@
+#include "KinematicsBatch.h"
+#include <cmath>
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define KINEMATICS_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+// Scalar lanes, used on any CPU and for the candidates left over by the AVX2 loop
+namespace scalar {
+
+struct V {
+    static constexpr std::size_t size = 1;
+    double v;
+    static V load(const double* p) { return V{*p}; }
+    static V gather(const double* base, const int* idx) { return V{base[*idx]}; }
+    static V broadcast(double x) { return V{x}; }
+    void store(double* p) const { *p = v; }
+};
+
+inline V operator+(V a, V b) { return V{a.v + b.v}; }
+inline V operator-(V a, V b) { return V{a.v - b.v}; }
+inline V operator*(V a, V b) { return V{a.v * b.v}; }
+inline V operator/(V a, V b) { return V{a.v / b.v}; }
+inline V operator-(V a) { return V{-a.v}; }
+inline V vsqrt(V a) { return V{std::sqrt(a.v)}; }
+inline V vabs(V a) { return V{std::abs(a.v)}; }
+inline bool vless(V a, V b) { return a.v < b.v; }
+inline bool vgreater(V a, V b) { return a.v > b.v; }
+inline V vselect(bool mask, V a, V b) { return mask ? a : b; }
+
+#include "KinematicsBatchKernel.h"
+
+} // namespace scalar
+
+#ifdef KINEMATICS_BATCH_AVX2
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+// Four lanes per AVX2 register. Only entered when the CPU supports AVX2, so
+// the library itself still runs everywhere.
+namespace avx2 {
+
+struct V {
+    static constexpr std::size_t size = 4;
+    __m256d v;
+    static V load(const double* p) { return V{_mm256_loadu_pd(p)}; }
+    static V gather(const double* base, const int* idx) {
+        __m128i index = _mm_loadu_si128((const __m128i*)idx);
+        __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        return V{_mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, index, all, 8)};
+    }
+    static V broadcast(double x) { return V{_mm256_set1_pd(x)}; }
+    void store(double* p) const { _mm256_storeu_pd(p, v); }
+};
+
+inline V operator+(V a, V b) { return V{_mm256_add_pd(a.v, b.v)}; }
+inline V operator-(V a, V b) { return V{_mm256_sub_pd(a.v, b.v)}; }
+inline V operator*(V a, V b) { return V{_mm256_mul_pd(a.v, b.v)}; }
+inline V operator/(V a, V b) { return V{_mm256_div_pd(a.v, b.v)}; }
+inline V operator-(V a) { return V{_mm256_xor_pd(a.v, _mm256_set1_pd(-0.0))}; }
+inline V vsqrt(V a) { return V{_mm256_sqrt_pd(a.v)}; }
+inline V vabs(V a) { return V{_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }
+inline __m256d vless(V a, V b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+inline __m256d vgreater(V a, V b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+inline V vselect(__m256d mask, V a, V b) { return V{_mm256_blendv_pd(b.v, a.v, mask)}; }
+
+#include "KinematicsBatchKernel.h"
+
+} // namespace avx2
+
+#pragma GCC pop_options
+#endif // KINEMATICS_BATCH_AVX2
+
+template<std::size_t N>
+void KinematicsBatch<N>::clear() {
+    for (auto& column : events) column.clear();
+    eventIndex.clear();
+    for (auto& column : hadrons) column.clear();
+    for (auto& column : ancestry) column.clear();
+    for (auto& column : out) column.clear();
+}
+
+template<std::size_t N>
+std::size_t KinematicsBatch<N>::addEvent(const KinematicsCalculator& kin) {
+    const EventFrame& f = kin.Frame();
+    const FourVector& P = kin.initialProton;
+
+    const double frame[NEventFields] = {
+        f.qVect.x, f.qVect.y, f.qVect.z,
+        P.px, P.py, P.pz, P.e,
+        f.missing.px, f.missing.py, f.missing.pz, f.missing.e,
+        f.toCM.b.x, f.toCM.b.y, f.toCM.b.z, f.toCM.gamma, f.toCM.gamma2,
+        f.W, f.Pq,
+        f.qcrossL.x, f.qcrossL.y, f.qcrossL.z, f.qcrossLMag,
+        f.qMag2
+    };
+    for (int i = 0; i < NEventFields; ++i) events[i].push_back(frame[i]);
+    return events[0].size() - 1;
+}
+
+template<std::size_t N>
+void KinematicsBatch<N>::addCandidate(std::size_t event, const HadronCandidate<N>& candidate) {
+    eventIndex.push_back((int)event);
+    for (std::size_t h = 0; h < N; ++h) {
+        hadrons[4 * h].push_back(candidate[h].px);
+        hadrons[4 * h + 1].push_back(candidate[h].py);
+        hadrons[4 * h + 2].push_back(candidate[h].pz);
+        hadrons[4 * h + 3].push_back(candidate[h].e);
+        ancestry[3 * h].push_back(candidate[h].parentPid);
+        ancestry[3 * h + 1].push_back(candidate[h].grandParentPid);
+        ancestry[3 * h + 2].push_back(candidate[h].status);
+    }
+}
+
+template<std::size_t N>
+void KinematicsBatch<N>::compute() {
+    std::size_t n = size();
+    const double* eventColumns[NEventFields];
+    const double* hadronColumns[4 * N];
+    double* outColumns[NFields];
+    for (int f = 0; f < NEventFields; ++f) eventColumns[f] = events[f].data();
+    for (std::size_t f = 0; f < 4 * N; ++f) hadronColumns[f] = hadrons[f].data();
+    for (std::size_t f = 0; f < NFields; ++f) {
+        out[f].resize(n);
+        outColumns[f] = out[f].data();
+    }
+    KinematicsBatchColumns columns{eventColumns, eventIndex.data(), hadronColumns, outColumns};
+
+    std::size_t done = 0;
+#ifdef KINEMATICS_BATCH_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        done = n - n % avx2::V::size;
+        avx2::computeKinematics<avx2::V, N>(columns, 0, done);
+    }
+#endif
+    scalar::computeKinematics<scalar::V, N>(columns, done, n);
+}
+
+template<>
+SingleHadronKinematics KinematicsBatch<1>::get(std::size_t i) const {
+    return SingleHadronKinematics{
+        out[0][i], out[1][i], out[2][i], out[3][i], out[4][i], out[5][i],
+        ancestry[0][i], ancestry[1][i], ancestry[2][i]
+    };
+}
+
+template<>
+DiHadronKinematics KinematicsBatch<2>::get(std::size_t i) const {
+    return DiHadronKinematics{
+        out[0][i], out[1][i], out[2][i], out[3][i], out[4][i], out[5][i], out[6][i], out[7][i],
+        out[8][i], out[9][i], out[10][i], out[11][i], out[12][i], out[13][i], out[14][i],
+        ancestry[0][i], ancestry[1][i], ancestry[2][i],
+        ancestry[3][i], ancestry[4][i], ancestry[5][i]
+    };
+}
+
+template class KinematicsBatch<1>;
+template class KinematicsBatch<2>;
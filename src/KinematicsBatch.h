@@ -0,0 +1,63 @@
+#ifndef KINEMATICS_BATCH_H
+#define KINEMATICS_BATCH_H
+
+#include "Kinematics.h"
+#include "KinematicsStructs.h"
+#include "HadroniumParser.h"
+#include <cstddef>
+#include <vector>
+
+// Raw columns handed to the batched kernels (see KinematicsBatchKernel.h)
+struct KinematicsBatchColumns {
+    const double* const* events; // per-event frame columns
+    const int* eventIndex;       // event of each candidate
+    const double* const* hadrons; // px, py, pz, e of each hadron, hadron by hadron
+    double* const* out;          // output columns
+};
+
+// Batched computation of the SingleHadronKinematics (N = 1) or
+// DiHadronKinematics (N = 2) of many candidates, possibly from many events.
+// Candidates and results are stored as structures of arrays, and the kernel
+// processes four candidates at a time with AVX2 when the CPU supports it,
+// falling back to a scalar loop otherwise. Results agree with
+// KinematicsCalculator to rounding (see benchmarks/bench_kinematics.cc).
+// DISTree::Fill uses it for events with many candidates.
+template<std::size_t N>
+class KinematicsBatch {
+    static_assert(N == 1 || N == 2, "KinematicsBatch supports single hadrons and dihadrons");
+public:
+    // Per-event columns, copied from the EventFrame of the event
+    enum EventField {
+        QX, QY, QZ,           // virtual photon momentum
+        PX, PY, PZ, PE,       // initial nucleon
+        XX, XY, XZ, XE,       // l + P - l', for the missing mass
+        BX, BY, BZ, GAMMA, GAMMA2, // boost to the photon-nucleon center of mass
+        W, PQ,                // W and P.q
+        CLX, CLY, CLZ, CLMAG, // q x l and its magnitude
+        Q2MAG,                // |q|^2 (three-vector)
+        NEventFields
+    };
+    // Number of double fields of HadronKinematics<N>, in struct order
+    static constexpr std::size_t NFields = N == 1 ? 6 : 15;
+
+    void clear();
+    // Adds the frame of an event and returns its index
+    std::size_t addEvent(const KinematicsCalculator& kin);
+    void addCandidate(std::size_t event, const HadronCandidate<N>& candidate);
+    // Computes the kinematics of all candidates
+    void compute();
+
+    std::size_t size() const { return eventIndex.size(); }
+    // Output column of the given field, valid after compute()
+    const double* column(std::size_t field) const { return out[field].data(); }
+    HadronKinematics<N> get(std::size_t i) const;
+
+private:
+    std::vector<double> events[NEventFields];
+    std::vector<int> eventIndex;
+    std::vector<double> hadrons[4 * N];
+    std::vector<int> ancestry[3 * N]; // parentPid, grandParentPid, status
+    std::vector<double> out[NFields];
+};
+
+#endif // KINEMATICS_BATCH_H
@@ -0,0 +1,211 @@
+// Batched kinematics kernel, written once for a generic lane type V.
+//
+// No include guard: KinematicsBatch.cc includes this file once per
+// instruction set, each time inside a namespace defining V (a pack of
+// V::size doubles with arithmetic operators and static load, store, gather
+// and broadcast) together with the lane functions vsqrt, vabs, vless,
+// vgreater and vselect. The operations follow KinematicsCalculator one by
+// one, so every lane reproduces the scalar results, except for the angles:
+// acos is evaluated with the rational approximation arccos instead of
+// std::acos, which differs by at most 2 ulp.
+
+template<class V>
+struct BatchFrame {
+    V qx, qy, qz, Px, Py, Pz, Pe, Xx, Xy, Xz, Xe, bx, by, bz, gamma, gamma2, W, Pq, clx, cly, clz, clmag, q2;
+};
+
+template<class V, std::size_t N>
+inline BatchFrame<V> gatherFrame(const double* const* ev, const int* idx) {
+    typedef KinematicsBatch<N> B;
+    BatchFrame<V> f;
+    f.qx = V::gather(ev[B::QX], idx); f.qy = V::gather(ev[B::QY], idx); f.qz = V::gather(ev[B::QZ], idx);
+    f.Px = V::gather(ev[B::PX], idx); f.Py = V::gather(ev[B::PY], idx); f.Pz = V::gather(ev[B::PZ], idx); f.Pe = V::gather(ev[B::PE], idx);
+    f.Xx = V::gather(ev[B::XX], idx); f.Xy = V::gather(ev[B::XY], idx); f.Xz = V::gather(ev[B::XZ], idx); f.Xe = V::gather(ev[B::XE], idx);
+    f.bx = V::gather(ev[B::BX], idx); f.by = V::gather(ev[B::BY], idx); f.bz = V::gather(ev[B::BZ], idx);
+    f.gamma = V::gather(ev[B::GAMMA], idx); f.gamma2 = V::gather(ev[B::GAMMA2], idx);
+    f.W = V::gather(ev[B::W], idx); f.Pq = V::gather(ev[B::PQ], idx);
+    f.clx = V::gather(ev[B::CLX], idx); f.cly = V::gather(ev[B::CLY], idx); f.clz = V::gather(ev[B::CLZ], idx);
+    f.clmag = V::gather(ev[B::CLMAG], idx); f.q2 = V::gather(ev[B::Q2MAG], idx);
+    return f;
+}
+
+// acos(x) = pi/2 - asin(x) for |x| <= 0.5, and 2 asin(sqrt((1 - |x|)/2))
+// (or pi minus it) otherwise, with the Cephes rational approximation of asin
+// on [-0.5, 0.5]. Arguments outside [-1, 1] and NaN give NaN, as std::acos.
+template<class V>
+inline V asinHalf(V t) {
+    V zz = t * t;
+    V p = V::broadcast(4.253011369004428248960E-3);
+    p = p * zz + V::broadcast(-6.019598008014123785661E-1);
+    p = p * zz + V::broadcast(5.444622390564711410273E0);
+    p = p * zz + V::broadcast(-1.626247967210700244449E1);
+    p = p * zz + V::broadcast(1.956261983317594739197E1);
+    p = p * zz + V::broadcast(-8.198089802484824371615E0);
+    V q = zz + V::broadcast(-1.474091372988853791896E1);
+    q = q * zz + V::broadcast(7.049610280856842141659E1);
+    q = q * zz + V::broadcast(-1.471791292232726029859E2);
+    q = q * zz + V::broadcast(1.395105614657485689735E2);
+    q = q * zz + V::broadcast(-4.918853881490881290097E1);
+    return t + t * (zz * p / q);
+}
+
+template<class V>
+inline V arccos(V x) {
+    const V pio4 = V::broadcast(0.78539816339744830962);
+    V a = vabs(x);
+    V outer = V::broadcast(2.0) * asinHalf(vsqrt(V::broadcast(0.5) * (V::broadcast(1.0) - a)));
+    outer = vselect(vgreater(x, V::broadcast(0.0)), outer, V::broadcast(3.14159265358979323846) - outer);
+    V inner = (pio4 - asinHalf(x) + V::broadcast(6.123233995736765886130E-17)) + pio4;
+    return vselect(vgreater(a, V::broadcast(0.5)), outer, inner);
+}
+
+template<class V>
+struct BatchVector {
+    V x, y, z, e;
+};
+
+template<class V>
+inline BatchVector<V> operator+(const BatchVector<V>& a, const BatchVector<V>& b) {
+    return BatchVector<V>{a.x + b.x, a.y + b.y, a.z + b.z, a.e + b.e};
+}
+
+// FourVector::m
+template<class V>
+inline V mass(V x, V y, V z, V e) {
+    V mm = e * e - (x * x + y * y + z * z);
+    V r = vsqrt(vabs(mm));
+    return vselect(vless(mm, V::broadcast(0.0)), -r, r);
+}
+
+// FourVector::boosted(const Boost&)
+template<class V>
+inline BatchVector<V> boost(const BatchVector<V>& p, V bx, V by, V bz, V gamma, V gamma2) {
+    V bp = bx * p.x + by * p.y + bz * p.z;
+    return BatchVector<V>{p.x + gamma2 * bp * bx + gamma * bx * p.e,
+                          p.y + gamma2 * bp * by + gamma * by * p.e,
+                          p.z + gamma2 * bp * bz + gamma * bz * p.e,
+                          gamma * (p.e + bp)};
+}
+
+// FourVector::boosted(const ThreeVector&)
+template<class V>
+inline BatchVector<V> boost(const BatchVector<V>& p, V bx, V by, V bz) {
+    V zero = V::broadcast(0.0);
+    V b2 = bx * bx + by * by + bz * bz;
+    V gamma = V::broadcast(1.0) / vsqrt(V::broadcast(1.0) - b2);
+    V gamma2 = vselect(vgreater(b2, zero), (gamma - V::broadcast(1.0)) / b2, zero);
+    return boost(p, bx, by, bz, gamma, gamma2);
+}
+
+// Boost to the photon-nucleon center of mass frame
+template<class V>
+inline BatchVector<V> toCM(const BatchFrame<V>& f, const BatchVector<V>& p) {
+    return boost(p, f.bx, f.by, f.bz, f.gamma, f.gamma2);
+}
+
+// KinematicsCalculator::azimuth
+template<class V>
+inline V azimuth(const BatchFrame<V>& f, V vx, V vy, V vz) {
+    V cx = f.qy * vz - vy * f.qz;
+    V cy = f.qz * vx - vz * f.qx;
+    V cz = f.qx * vy - vx * f.qy;
+    V lv = f.clx * vx + f.cly * vy + f.clz * vz;
+    V factor1 = lv / vabs(lv);
+    V factor2 = (f.clx * cx + f.cly * cy + f.clz * cz) / f.clmag / vsqrt(cx * cx + cy * cy + cz * cz);
+    return factor1 * arccos(factor2);
+}
+
+// Transverse momentum and xF from the momentum in the center of mass frame
+template<class V>
+inline V pt(const BatchVector<V>& pCM) {
+    return vsqrt(pCM.x * pCM.x + pCM.y * pCM.y);
+}
+
+template<class V>
+inline V xF(const BatchFrame<V>& f, const BatchVector<V>& pCM) {
+    return V::broadcast(2.0) * pCM.z / f.W;
+}
+
+template<class V>
+inline V z(const BatchFrame<V>& f, const BatchVector<V>& p) {
+    return (f.Pe * p.e - f.Pz * p.z - f.Py * p.y - f.Px * p.x) / f.Pq;
+}
+
+template<class V>
+inline V Mx(const BatchFrame<V>& f, const BatchVector<V>& p) {
+    return mass(f.Xx - p.x, f.Xy - p.y, f.Xz - p.z, f.Xe - p.e);
+}
+
+// ThreeVector::angle
+template<class V>
+inline V angle(V ax, V ay, V az, V bx, V by, V bz) {
+    V zero = V::broadcast(0.0), one = V::broadcast(1.0);
+    V ptot2 = (ax * ax + ay * ay + az * az) * (bx * bx + by * by + bz * bz);
+    V arg = (ax * bx + ay * by + az * bz) / vsqrt(ptot2);
+    arg = vselect(vgreater(arg, one), one, arg);
+    arg = vselect(vless(arg, -one), -one, arg);
+    return vselect(vgreater(ptot2, zero), arccos(arg), zero);
+}
+
+// Computes candidates [begin, end); end - begin must be a multiple of V::size
+template<class V, std::size_t N>
+void computeKinematics(const KinematicsBatchColumns& c, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i += V::size) {
+        BatchFrame<V> f = gatherFrame<V, N>(c.events, c.eventIndex + i);
+        BatchVector<V> p[N];
+        for (std::size_t h = 0; h < N; ++h) {
+            p[h] = BatchVector<V>{V::load(c.hadrons[4 * h] + i), V::load(c.hadrons[4 * h + 1] + i),
+                                  V::load(c.hadrons[4 * h + 2] + i), V::load(c.hadrons[4 * h + 3] + i)};
+        }
+
+        if constexpr (N == 1) {
+            BatchVector<V> pCM = toCM(f, p[0]);
+            pt(pCM).store(c.out[0] + i);
+            z(f, p[0]).store(c.out[1] + i);
+            azimuth(f, p[0].x, p[0].y, p[0].z).store(c.out[2] + i);
+            mass(p[0].x, p[0].y, p[0].z, p[0].e).store(c.out[3] + i);
+            xF(f, pCM).store(c.out[4] + i);
+            Mx(f, p[0]).store(c.out[5] + i);
+        } else {
+            const BatchVector<V>& p1 = p[0];
+            const BatchVector<V>& p2 = p[1];
+            BatchVector<V> ph = p1 + p2;
+            BatchVector<V> p1CM = toCM(f, p1), p2CM = toCM(f, p2), phCM = toCM(f, ph);
+            V z1 = z(f, p1), z2 = z(f, p2);
+
+            pt(p1CM).store(c.out[0] + i);
+            pt(p2CM).store(c.out[1] + i);
+            pt(phCM).store(c.out[2] + i);
+            z1.store(c.out[3] + i);
+            z2.store(c.out[4] + i);
+            z(f, ph).store(c.out[5] + i);
+            azimuth(f, ph.x, ph.y, ph.z).store(c.out[6] + i);
+
+            // phi_RT
+            V half = V::broadcast(0.5);
+            V rx = half * (p1.x - p2.x), ry = half * (p1.y - p2.y), rz = half * (p1.z - p2.z);
+            V rq = (rx * f.qx + ry * f.qy + rz * f.qz) / f.q2;
+            azimuth(f, rx - rq * f.qx, ry - rq * f.qy, rz - rq * f.qz).store(c.out[7] + i);
+
+            // phi_Rperp
+            V p1q = (p1.x * f.qx + p1.y * f.qy + p1.z * f.qz) / f.q2;
+            V p2q = (p2.x * f.qx + p2.y * f.qy + p2.z * f.qz) / f.q2;
+            V norm = V::broadcast(1.0) / (z1 + z2);
+            V Rx = (z2 * (p1.x - p1q * f.qx) - z1 * (p2.x - p2q * f.qx)) * norm;
+            V Ry = (z2 * (p1.y - p1q * f.qy) - z1 * (p2.y - p2q * f.qy)) * norm;
+            V Rz = (z2 * (p1.z - p1q * f.qz) - z1 * (p2.z - p2q * f.qz)) * norm;
+            azimuth(f, Rx, Ry, Rz).store(c.out[8] + i);
+
+            // th, in the dihadron rest frame
+            V hx = ph.x / ph.e, hy = ph.y / ph.e, hz = ph.z / ph.e;
+            BatchVector<V> p1h = boost(p1, -hx, -hy, -hz);
+            angle(p1h.x, p1h.y, p1h.z, hx, hy, hz).store(c.out[9] + i);
+
+            mass(ph.x, ph.y, ph.z, ph.e).store(c.out[10] + i);
+            xF(f, p1CM).store(c.out[11] + i);
+            xF(f, p2CM).store(c.out[12] + i);
+            xF(f, phCM).store(c.out[13] + i);
+            Mx(f, ph).store(c.out[14] + i);
+        }
+    }
+}
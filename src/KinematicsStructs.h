@@ -2,13 +2,25 @@
 #ifndef KINEMATICS_STRUCTS_H
 #define KINEMATICS_STRUCTS_H
 
+#include <cstddef>
 #include <vector>
 
 enum class HadroniumAnalysisType {
     SingleHadron,
-    DiHadron
+    DiHadron,
+    TriHadron
 };
 
+// Number of hadrons whose kinematics are stored for a given analysis type
+constexpr std::size_t candidateArity(HadroniumAnalysisType analysisType) {
+    return analysisType == HadroniumAnalysisType::TriHadron ? 3 :
+           analysisType == HadroniumAnalysisType::DiHadron  ? 2 : 1;
+}
+
+// Each struct lists its output columns, in branch order, through a static
+// visit(self, visitor) that calls visitor(name, field) for every field. The
+// tree branches and cut variables are generated from these lists.
+
 struct EventKinematics {
     double x = 0.0;
     double Q2 = 0.0;
@@ -24,11 +36,29 @@ struct EventKinematics {
     double depolW = 0.0;
     int target_polarization = 0;
     int beam_polarization = 0;
+
+    template<class Self, class Visitor>
+    static void visit(Self& k, Visitor&& v) {
+        v("x", k.x);
+        v("y", k.y);
+        v("Q2", k.Q2);
+        v("W", k.W);
+        v("phi_S", k.phi_S);
+        v("epsilon", k.epsilon);
+        v("gamma", k.gamma);
+        v("depolA", k.depolA);
+        v("depolB", k.depolB);
+        v("depolC", k.depolC);
+        v("depolV", k.depolV);
+        v("depolW", k.depolW);
+        v("bPol", k.beam_polarization);
+        v("tPol", k.target_polarization);
+    }
 };
 
 struct SingleHadronKinematics {
-    double pt = 0.0; 
-    double z = 0.0;   
+    double pt = 0.0;
+    double z = 0.0;
     double phi = 0.0;
     double Mh = 0.0;
     double xF = 0.0;
@@ -36,6 +66,19 @@ struct SingleHadronKinematics {
     int parentPid = 0;
     int grandParentPid = 0;
     int status = 0;
+
+    template<class Self, class Visitor>
+    static void visit(Self& k, Visitor&& v) {
+        v("pt", k.pt);
+        v("z", k.z);
+        v("phi", k.phi);
+        v("Mh", k.Mh);
+        v("xF", k.xF);
+        v("Mx", k.Mx);
+        v("parentPid", k.parentPid);
+        v("grandParentPid", k.grandParentPid);
+        v("status", k.status);
+    }
 };
 
 struct DiHadronKinematics {
@@ -60,6 +103,101 @@ struct DiHadronKinematics {
     int parentPid2 = 0;
     int grandParentPid2 = 0;
     int status2 = 0;
+
+    template<class Self, class Visitor>
+    static void visit(Self& k, Visitor&& v) {
+        v("pt1", k.pt1);
+        v("pt2", k.pt2);
+        v("pt", k.pt);
+        v("z1", k.z1);
+        v("z2", k.z2);
+        v("z", k.z);
+        v("phi_h", k.phi_h);
+        v("phi_RT", k.phi_RT);
+        v("phi_Rperp", k.phi_Rperp);
+        v("th", k.th);
+        v("Mh", k.Mh);
+        v("xF1", k.xF1);
+        v("xF2", k.xF2);
+        v("xF", k.xF);
+        v("Mx", k.Mx);
+        v("parentPid1", k.parentPid1);
+        v("grandParentPid1", k.grandParentPid1);
+        v("status1", k.status1);
+        v("parentPid2", k.parentPid2);
+        v("grandParentPid2", k.grandParentPid2);
+        v("status2", k.status2);
+    }
 };
 
-#endif // KINEMATICS_STRUCTS_H
\ No newline at end of file
+struct TriHadronKinematics {
+    double pt1 = 0.0;
+    double pt2 = 0.0;
+    double pt3 = 0.0;
+    double pt = 0.0;
+    double z1 = 0.0;
+    double z2 = 0.0;
+    double z3 = 0.0;
+    double z  = 0.0;
+    double phi_h = 0.0;
+    double Mh = 0.0;
+    double M12 = 0.0;
+    double M13 = 0.0;
+    double M23 = 0.0;
+    double xF1 = 0.0;
+    double xF2 = 0.0;
+    double xF3 = 0.0;
+    double xF  = 0.0;
+    double Mx  = 0.0;
+    int parentPid1 = 0;
+    int grandParentPid1 = 0;
+    int status1 = 0;
+    int parentPid2 = 0;
+    int grandParentPid2 = 0;
+    int status2 = 0;
+    int parentPid3 = 0;
+    int grandParentPid3 = 0;
+    int status3 = 0;
+
+    template<class Self, class Visitor>
+    static void visit(Self& k, Visitor&& v) {
+        v("pt1", k.pt1);
+        v("pt2", k.pt2);
+        v("pt3", k.pt3);
+        v("pt", k.pt);
+        v("z1", k.z1);
+        v("z2", k.z2);
+        v("z3", k.z3);
+        v("z", k.z);
+        v("phi_h", k.phi_h);
+        v("Mh", k.Mh);
+        v("M12", k.M12);
+        v("M13", k.M13);
+        v("M23", k.M23);
+        v("xF1", k.xF1);
+        v("xF2", k.xF2);
+        v("xF3", k.xF3);
+        v("xF", k.xF);
+        v("Mx", k.Mx);
+        v("parentPid1", k.parentPid1);
+        v("grandParentPid1", k.grandParentPid1);
+        v("status1", k.status1);
+        v("parentPid2", k.parentPid2);
+        v("grandParentPid2", k.grandParentPid2);
+        v("status2", k.status2);
+        v("parentPid3", k.parentPid3);
+        v("grandParentPid3", k.grandParentPid3);
+        v("status3", k.status3);
+    }
+};
+
+// Kinematics struct stored for a candidate of N hadrons
+template<std::size_t N> struct HadronKinematicsTraits;
+template<> struct HadronKinematicsTraits<1> { typedef SingleHadronKinematics type; };
+template<> struct HadronKinematicsTraits<2> { typedef DiHadronKinematics type; };
+template<> struct HadronKinematicsTraits<3> { typedef TriHadronKinematics type; };
+
+template<std::size_t N>
+using HadronKinematics = typename HadronKinematicsTraits<N>::type;
+
+#endif // KINEMATICS_STRUCTS_H
@@ -1,17 +1,35 @@
 #include "LundAnalysis.h"
+#include "ColumnarFile.h"
 #include "Riostream.h"
+#include "Version.h"
+#include "TChain.h"
+#include "TFileMerger.h"
+#include "TMD5.h"
+#include "TNamed.h"
+#include "TROOT.h"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 R__LOAD_LIBRARY(Spinthyia)
     
 LundAnalysis::LundAnalysis(const std::string& pattern, const std::string& outputFilename, HadroniumAnalysisType analysisType, int verbosity)
 : outputFilename(outputFilename), analysisType(analysisType), verbosity(verbosity) {
-    // Get the std::vector<string> filenames (capable of handling wildcards)
-    filenames = findMatchingFiles(pattern);
-    // Initialize distree once, assuming same outputFilename and analysisType for all files
-    distree.init(outputFilename, analysisType);
+    // Get the std::vector<string> filenames (capable of handling wildcards);
+    // analyses of an EventSource have no pattern
+    if (!pattern.empty()) filenames = findMatchingFiles(pattern);
 }
 
 void LundAnalysis::setCriteria(const std::string& criteria) {
+    size_t arity = candidateArity(analysisType);
+    if (arity > 1 && count_criteria_groups(criteria) != static_cast<int>(arity)) {
+        throw std::runtime_error("Criteria '" + criteria + "' must contain exactly " + std::to_string(arity) + " groups for this analysis type");
+    }
     this->criteria = criteria;
 }
 
@@ -20,38 +38,646 @@ void LundAnalysis::setFilterRules(const FilterRules& rules) {
 }
 
 void LundAnalysis::addKinematicCut(const KinematicCut& cut) {
-    distree.kinematicCuts.push_back(cut);
+    kinematicCuts.push_back(cut);
+}
+
+void LundAnalysis::setProgressive(int checkpointInterval, double targetError) {
+    this->checkpointInterval = checkpointInterval;
+    this->targetError = targetError;
 }
 
 void LundAnalysis::run() {
+    checkColumnar();
+    if (!binnedMoments.empty() && !cacheDirectory.empty()) {
+        throw std::runtime_error("Binned moments cannot be combined with a cache directory");
+    }
+    if (outputOptions.format == OutputFormat::None && !cacheDirectory.empty()) {
+        throw std::runtime_error("A cache directory needs an output format that stores the rows");
+    }
+    if (!eventMixing.empty()) {
+        if (checkpointInterval > 0 || !cacheDirectory.empty() || !candidateCache.empty()) {
+            throw std::runtime_error("Event mixing cannot be combined with progressive runs, a cache directory or a candidate cache");
+        }
+        if (outputOptions.format == OutputFormat::None) {
+            throw std::runtime_error("Event mixing needs an output format that stores the rows");
+        }
+        eventMixing.setCriteria(criteria);
+    }
+    if (!skimOutput.empty() && !cacheDirectory.empty()) {
+        throw std::runtime_error("A skim list cannot be written with a cache directory, as cached files are not processed again");
+    }
+    if (!skimInput.empty()) selection = SkimList::read(skimInput);
+    if (!skimOutput.empty()) skim = SkimList(filenames);
+    binnedMoments.setReplicas(bootstrap.replicas());
+    BinnedMoments::Shard sums = binnedMoments.shard();
+    if (checkpointInterval > 0) {
+        runProgressive(sums);
+    } else if (!cacheDirectory.empty()) {
+        runCached();
+    } else if (threads > 1 && candidateCache.empty()) {
+        runThreaded(sums);
+    } else {
+        runSingle(sums);
+    }
+    if (!binnedMoments.empty()) {
+        binnedMoments.write(momentsFilename, sums);
+        if (verbosity > 0) {
+            std::cout << "Wrote the binned moments of " << binnedMoments.bins() << " bins to " << momentsFilename << std::endl;
+        }
+    }
+    if (!skimOutput.empty()) {
+        skim.write(skimOutput);
+        if (verbosity > 0) std::cout << "Wrote the skim list to " << skimOutput << std::endl;
+    }
+    if (provenance) {
+        writeFileTable(outputFilename);
+        if (!eventMixing.empty()) writeFileTable(mixingFilename);
+    }
+}
+
+void LundAnalysis::runSingle(BinnedMoments::Shard& sums) {
+    // Initialize distree once, assuming same outputFilename and analysisType for all files
+    distree.init(outputFilename, analysisType, outputOptions);
+    configureTree(distree);
+    if (!binnedMoments.empty()) sums.attach(distree);
+    if (!skimOutput.empty()) attachSkim(distree);
+    if (!candidateCache.empty()) {
+        if (replayCandidates()) {
+            distree.Write();
+            return;
+        }
+        distree.recordCandidates(candidateCache, candidateFingerprint());
+    }
+    std::unique_ptr<DISTree> mixedTree;
+    if (!eventMixing.empty()) {
+        mixedTree.reset(new DISTree(mixingFilename, analysisType, outputOptions));
+        configureTree(*mixedTree);
+    }
     for (const auto& file : filenames) {
-        LundReader reader(file);
-        LundEvent event;
-        while (reader.readEvent(event)) {
-            processEvent(event);
-            eventCount++;
-            if (eventCount % 10000 == 0 && verbosity > 0) {
-                std::cout << "Processed " << eventCount << " events from " << file << std::endl;
+        processFile(file, distree, mixedTree.get());
+    }
+    distree.Write();
+    if (mixedTree) mixedTree->Write();
+}
+
+// Every file has its own partial output and shard of the binned moments, so
+// the result does not depend on which thread processed which file
+void LundAnalysis::runThreaded(BinnedMoments::Shard& sums) {
+    ROOT::EnableThreadSafety();
+    std::vector<std::string> parts, mixedParts;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        parts.push_back(outputFilename + ".part" + std::to_string(i) + ".root");
+        if (!eventMixing.empty()) mixedParts.push_back(mixingFilename + ".part" + std::to_string(i) + ".root");
+    }
+    std::vector<BinnedMoments::Shard> shards(filenames.size(), binnedMoments.shard());
+    std::vector<std::exception_ptr> errors(filenames.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < filenames.size(); i = next++) {
+            try {
+                DISTree tree(parts[i], analysisType, partOptions());
+                configureTree(tree);
+                if (!binnedMoments.empty()) shards[i].attach(tree);
+                if (!skimOutput.empty()) attachSkim(tree);
+                std::unique_ptr<DISTree> mixedTree;
+                if (!eventMixing.empty()) {
+                    mixedTree.reset(new DISTree(mixedParts[i], analysisType, partOptions()));
+                    configureTree(*mixedTree);
+                }
+                processFile(filenames[i], tree, mixedTree.get());
+                tree.Write();
+                if (mixedTree) mixedTree->Write();
+            } catch (...) {
+                errors[i] = std::current_exception();
             }
         }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) pool.emplace_back(worker);
+    for (auto& thread : pool) thread.join();
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
     }
-    distree.Write();
+    for (const auto& shard : shards) sums.merge(shard);
+    mergeOutputs(parts, true, outputFilename);
+    if (!eventMixing.empty()) mergeOutputs(mixedParts, true, mixingFilename);
+}
+
+void LundAnalysis::run(EventSource& source) {
+    if (checkpointInterval > 0 || !cacheDirectory.empty() || !candidateCache.empty() || !eventMixing.empty() ||
+        !skimInput.empty() || !skimOutput.empty()) {
+        throw std::runtime_error("Events of " + source.name() + " cannot be analyzed in progressive runs or with a cache directory, candidate cache, event mixing or skim lists");
+    }
+    checkColumnar();
+    filenames = {source.name()};
+    binnedMoments.setReplicas(bootstrap.replicas());
+    BinnedMoments::Shard sums = binnedMoments.shard();
+    if (threads <= 1) {
+        distree.init(outputFilename, analysisType, outputOptions);
+        configureTree(distree);
+        if (!binnedMoments.empty()) sums.attach(distree);
+        processSource(source, distree);
+        distree.Write();
+    } else {
+        ROOT::EnableThreadSafety();
+        std::vector<std::string> parts;
+        for (int t = 0; t < threads; ++t) parts.push_back(outputFilename + ".part" + std::to_string(t) + ".root");
+        std::vector<BinnedMoments::Shard> shards(threads, binnedMoments.shard());
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t]() {
+                try {
+                    DISTree tree(parts[t], analysisType, partOptions());
+                    configureTree(tree);
+                    if (!binnedMoments.empty()) shards[t].attach(tree);
+                    processSource(source, tree);
+                    tree.Write();
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+        for (auto& thread : pool) thread.join();
+        for (const auto& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+        for (const auto& shard : shards) sums.merge(shard);
+        mergeOutputs(parts, true, outputFilename);
+    }
+    if (!binnedMoments.empty()) {
+        binnedMoments.write(momentsFilename, sums);
+        if (verbosity > 0) {
+            std::cout << "Wrote the binned moments of " << binnedMoments.bins() << " bins to " << momentsFilename << std::endl;
+        }
+    }
+    if (provenance) writeFileTable(outputFilename);
+}
+
+// The index of the source stands for the event index in the file
+void LundAnalysis::processSource(EventSource& source, DISTree& tree) {
+    LundEvent event;
+    long index;
+    std::string name = source.name();
+    while (source.next(event, index)) {
+        tree.setSource(0, index);
+        processEvent(event, tree, FastSimulation::eventKey(name, index));
+        int count = ++eventCount;
+        if (count % 10000 == 0 && verbosity > 0) {
+            std::cout << "Processed " << count << " events from " << name << std::endl;
+        }
+    }
+}
+
+// With a mixed tree, the events of the file are mixed with each other only
+void LundAnalysis::processFile(const std::string& file, DISTree& tree, DISTree* mixedTree) {
+    LundReader reader(file);
+    selectEvents(reader, file);
+    LundEvent event;
+    int id = fileId(file);
+    EventMixing mixing;
+    if (mixedTree) {
+        mixing = eventMixing;
+        mixing.reset();
+    }
+    while (reader.readEvent(event)) {
+        tree.setSource(id, reader.eventIndex());
+        if (mixedTree) mixedTree->setSource(id, reader.eventIndex());
+        processEvent(event, tree, FastSimulation::eventKey(file, reader.eventIndex()), mixedTree ? &mixing : nullptr, mixedTree);
+        int count = ++eventCount;
+        if (count % 10000 == 0 && verbosity > 0) {
+            std::cout << "Processed " << count << " events from " << file << std::endl;
+        }
+    }
+}
+
+void LundAnalysis::setCacheDirectory(const std::string& cacheDirectory) {
+    this->cacheDirectory = cacheDirectory;
+}
+
+void LundAnalysis::setCandidateCache(const std::string& filename) {
+    candidateCache = filename;
+}
+
+void LundAnalysis::setFastSimulation(const std::string& mapFile, std::uint64_t seed) {
+    fastSimulation.reset(new FastSimulation(mapFile, seed));
+    fastSimulationMap = mapFile;
+    fastSimulationSeed = seed;
+}
+
+bool LundAnalysis::replayCandidates() {
+    if (!fs::exists(candidateCache)) return false;
+    std::unique_ptr<TFile> in(TFile::Open(candidateCache.c_str(), "READ"));
+    if (!in || in->IsZombie()) return false;
+    TNamed* fingerprint = (TNamed*)(in->Get("fingerprint"));
+    TTree* candidates = (TTree*)(in->Get("candidates"));
+    // Caches written before the event and source columns are rebuilt
+    if (!fingerprint || !candidates || !candidates->GetBranch("event") || !candidates->GetBranch("fileId") ||
+        candidateFingerprint() != fingerprint->GetTitle()) {
+        if (verbosity > 0) {
+            std::cout << "Candidate cache " << candidateCache << " does not match this analysis, rebuilding it" << std::endl;
+        }
+        return false;
+    }
+    Long64_t nFilled = distree.FillFromCandidates(candidates);
+    if (verbosity > 0) {
+        std::cout << "Applied the kinematic cuts to " << candidates->GetEntries() << " cached candidates, "
+                  << nFilled << " passed" << std::endl;
+    }
+    return true;
+}
+
+// Configuration and input files that determine the cached candidates
+std::string LundAnalysis::candidateFingerprint() const {
+    std::ostringstream fingerprint;
+    fingerprint << configFingerprint(false);
+    for (const auto& file : filenames) {
+        fingerprint << "file " << file << " " << fs::file_size(file) << " "
+                    << fs::last_write_time(file).time_since_epoch().count() << "\n";
+    }
+    return fingerprint.str();
+}
+
+void LundAnalysis::runCached() {
+    fs::create_directories(cacheDirectory);
+    std::string fingerprint = configFingerprint();
+    std::vector<std::string> parts;
+    for (const auto& file : filenames) {
+        // The provenance columns hold the file's position in this run's file table
+        std::string key = provenance ? cacheKey(file, fingerprint + "fileId " + std::to_string(fileId(file)) + "\n") : cacheKey(file, fingerprint);
+        std::string part = cacheDirectory + "/" + key + ".root";
+        if (!fs::exists(part)) {
+            // Written under a temporary name, so an interrupted job never leaves an incomplete entry
+            std::string temporary = part + ".tmp";
+            {
+                DISTree tree(temporary, analysisType, partOptions());
+                configureTree(tree);
+                processFile(file, tree);
+                tree.Write();
+            }
+            fs::rename(temporary, part);
+        } else if (verbosity > 0) {
+            std::cout << "Using cached result for " << file << std::endl;
+        }
+        parts.push_back(part);
+    }
+    mergeOutputs(parts, false, outputFilename);
+}
+
+// Everything that determines the content of the output of a file
+std::string LundAnalysis::configFingerprint(bool withCuts) const {
+    std::ostringstream fingerprint;
+    fingerprint << std::setprecision(17);
+    fingerprint << "version " << SPINTHYIA_VERSION << "\n";
+    fingerprint << "type " << static_cast<int>(analysisType) << "\n";
+    fingerprint << "criteria " << criteria << "\n";
+    fingerprint << "acceptance " << static_cast<int>(acc) << "\n";
+    if (fastSimulation) {
+        std::unique_ptr<TMD5> map(TMD5::FileChecksum(fastSimulationMap.c_str()));
+        fingerprint << "fastsim " << (map ? map->AsString() : fastSimulationMap.c_str()) << " " << fastSimulationSeed << "\n";
+    }
+    for (const auto& condition : rules.particleConditions) {
+        fingerprint << "condition " << condition.requiredParentPid << " " << condition.requiredGrandParentPid << "\n";
+    }
+    for (const auto& relationship : rules.parentIdRelationships) {
+        fingerprint << "relationship " << relationship.particleIndex1 << " " << relationship.particleIndex2;
+        for (const auto& type : relationship.types) fingerprint << " " << static_cast<int>(type);
+        fingerprint << "\n";
+    }
+    if (!skimInput.empty()) {
+        std::unique_ptr<TMD5> list(TMD5::FileChecksum(skimInput.c_str()));
+        fingerprint << "skim " << (list ? list->AsString() : skimInput.c_str()) << "\n";
+    }
+    if (bootstrap.replicas() > 0) {
+        fingerprint << "bootstrap " << bootstrap.replicas() << " " << bootstrapSeed << " " << storeReplicaWeights << "\n";
+    }
+    if (outputOptions.format != OutputFormat::ROOT) {
+        fingerprint << "format " << static_cast<int>(outputOptions.format) << "\n";
+    }
+    for (const auto& column : outputOptions.precision) {
+        fingerprint << "precision " << column.first << " " << static_cast<int>(column.second.type) << " "
+                    << column.second.min << " " << column.second.max << " " << column.second.bits << "\n";
+    }
+    if (withCuts) {
+        if (outputOptions.layout != OutputLayout::Rows) {
+            fingerprint << "layout " << static_cast<int>(outputOptions.layout) << "\n";
+        }
+        if (provenance) fingerprint << "provenance\n";
+        for (const auto& cut : kinematicCuts) {
+            fingerprint << "cut " << cut.variableName << " " << static_cast<int>(cut.type) << " " << cut.minValue << " " << cut.maxValue << "\n";
+        }
+    }
+    return fingerprint.str();
+}
+
+std::string LundAnalysis::cacheKey(const std::string& file, const std::string& fingerprint) const {
+    std::unique_ptr<TMD5> checksum(TMD5::FileChecksum(file.c_str()));
+    if (!checksum) {
+        throw std::runtime_error("Unable to checksum file: " + file);
+    }
+    std::ostringstream identity;
+    identity << fingerprint
+             << "size " << fs::file_size(file) << "\n"
+             << "mtime " << fs::last_write_time(file).time_since_epoch().count() << "\n"
+             << "md5 " << checksum->AsString() << "\n";
+    std::string key = identity.str();
+
+    TMD5 md5;
+    md5.Update(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+    md5.Final();
+    return fs::path(file).filename().string() + "." + md5.AsString();
+}
+
+void LundAnalysis::setOutputOptions(const OutputOptions& options) {
+    outputOptions = options;
+}
+
+void LundAnalysis::setEventMixing(const EventMixing& mixing, const std::string& filename) {
+    eventMixing = mixing;
+    mixingFilename = filename;
+}
+
+void LundAnalysis::setBootstrap(int replicas, std::uint64_t seed, bool store) {
+    bootstrap = BootstrapWeights(replicas, seed);
+    bootstrapSeed = seed;
+    storeReplicaWeights = store;
+}
+
+void LundAnalysis::setProvenance(bool provenance) {
+    this->provenance = provenance;
+}
+
+void LundAnalysis::setSkimOutput(const std::string& filename) {
+    skimOutput = filename;
+}
+
+void LundAnalysis::setSkimInput(const std::string& filename) {
+    skimInput = filename;
+}
+
+// The columnar format has no collection columns
+void LundAnalysis::checkColumnar() const {
+    if (outputOptions.format != OutputFormat::Columnar) return;
+    if (bootstrap.replicas() > 0 && storeReplicaWeights) {
+        throw std::runtime_error("The columnar format cannot store the replicaWeights collection, the bootstrap replicas need store = false");
+    }
+    if (provenance) {
+        throw std::runtime_error("The columnar format cannot store the provenance ids, provenance needs a ROOT or RNTuple output");
+    }
+}
+
+// Settings shared by all trees of the analysis
+void LundAnalysis::configureTree(DISTree& tree) const {
+    tree.kinematicCuts = kinematicCuts;
+    if (bootstrap.replicas() > 0) tree.setReplicas(bootstrap.replicas(), storeReplicaWeights);
+    if (provenance) tree.recordProvenance();
+}
+
+// Selects the event of every row of the tree. Each tree only fills the
+// events of its own files, so trees of different threads mark different bitmaps.
+void LundAnalysis::attachSkim(DISTree& tree) {
+    tree.addRowObserver([this, &tree]() { skim.mark(tree.sourceFile(), tree.sourceEvent()); });
+}
+
+// Position of the file in the file table of the run
+int LundAnalysis::fileId(const std::string& file) const {
+    return std::find(filenames.begin(), filenames.end(), file) - filenames.begin();
+}
+
+void LundAnalysis::selectEvents(LundReader& reader, const std::string& file) const {
+    if (skimInput.empty()) return;
+    const std::vector<std::uint64_t>* bitmap = selection.find(file);
+    reader.selectEvents(bitmap ? *bitmap : std::vector<std::uint64_t>());
+}
+
+void LundAnalysis::writeFileTable(const std::string& target) const {
+    std::ostringstream table;
+    for (const auto& file : filenames) table << file << "\n";
+    switch (outputOptions.format) {
+        case OutputFormat::ROOT:
+        case OutputFormat::RNTuple: {
+            // Past Output:maxFileSize the tree continues in <name>_1.root,
+            // <name>_2.root, ..., each of which gets the table as well
+            std::vector<std::string> targets{target};
+            if (outputOptions.format == OutputFormat::ROOT && outputOptions.maxFileSize > 0) {
+                fs::path path(target);
+                for (int n = 1;; ++n) {
+                    fs::path rotated = path.parent_path() / (path.stem().string() + "_" + std::to_string(n) + path.extension().string());
+                    if (!fs::exists(rotated)) break;
+                    targets.push_back(rotated.string());
+                }
+            }
+            TNamed files("files", table.str().c_str());
+            for (const auto& name : targets) {
+                std::unique_ptr<TFile> out(TFile::Open(name.c_str(), "UPDATE"));
+                if (!out || out->IsZombie()) {
+                    throw std::runtime_error("Unable to add the file table to " + name);
+                }
+                out->WriteTObject(&files);
+            }
+            break;
+        }
+        case OutputFormat::Columnar:
+        case OutputFormat::None: break;
+    }
+}
+
+void LundAnalysis::setThreads(int threads) {
+    this->threads = threads;
+}
+
+void LundAnalysis::setBinnedMoments(const BinnedMoments& moments, const std::string& filename) {
+    binnedMoments = moments;
+    momentsFilename = filename;
+}
+
+OutputOptions LundAnalysis::partOptions() const {
+    OutputOptions options = outputOptions;
+    options.maxFileSize = 0;
+    return options;
 }
 
 void LundAnalysis::setCLAS12() {
     acc = AcceptanceType::CLAS12;
 }
 
-void LundAnalysis::processEvent(LundEvent& event) {
-    std::vector<std::vector<Hadronium>> hadronia = reconstruct_hadronia(event, criteria, acc);
+// Files of a polarization mode open at once in a progressive run
+static const size_t progressiveWindow = 4;
+
+void LundAnalysis::runProgressive(BinnedMoments::Shard& sums) {
+    // Every input file is a stratum with its own partial output, so that the
+    // interleaved visiting order does not change the order of the output rows.
+    // A stratum is only open, with its reader and partial output, from its
+    // first to its last event.
+    struct Stratum {
+        std::unique_ptr<LundReader> reader;
+        std::unique_ptr<DISTree> tree;
+        LundEvent event;
+        bool opened = false;
+        bool changed = false; // rows filled since the last checkpoint
+    };
+    struct Mode {
+        std::vector<size_t> files;
+        size_t next = 0;
+        std::vector<size_t> open;
+    };
+    std::vector<Stratum> strata(filenames.size());
+    std::map<std::pair<int, int>, Mode> modes; // (bPol, tPol) -> strata
+    // The polarization of a file is that of its first event
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        LundReader reader(filenames[i]);
+        selectEvents(reader, filenames[i]);
+        LundEvent first;
+        if (reader.readEvent(first)) modes[{first.beam_polarization, first.target_polarization}].files.push_back(i);
+    }
+
+    auto open = [&](size_t i) {
+        Stratum& stratum = strata[i];
+        stratum.opened = true;
+        stratum.tree.reset(new DISTree(outputFilename + ".part" + std::to_string(i) + ".root", analysisType, partOptions()));
+        configureTree(*stratum.tree);
+        monitor.attach(*stratum.tree);
+        if (!binnedMoments.empty()) sums.attach(*stratum.tree);
+        if (!skimOutput.empty()) attachSkim(*stratum.tree);
+        stratum.tree->addRowObserver([&stratum]() { stratum.changed = true; });
+        stratum.reader.reset(new LundReader(filenames[i]));
+        selectEvents(*stratum.reader, filenames[i]);
+        stratum.reader->readEvent(stratum.event);
+    };
+    auto close = [&](size_t i) {
+        Stratum& stratum = strata[i];
+        stratum.tree->Write();
+        stratum.tree.reset();
+        stratum.reader.reset();
+    };
+    // Opens the next files of the mode up to the window
+    auto refill = [&](Mode& mode) {
+        while (mode.open.size() < progressiveWindow && mode.next < mode.files.size()) {
+            open(mode.files[mode.next]);
+            mode.open.push_back(mode.files[mode.next++]);
+        }
+    };
+    for (auto& mode : modes) refill(mode.second);
+
+    // Round-robin order alternating between the polarization modes, over the
+    // open files of each mode
+    std::string progressFilename = outputFilename + ".progress";
+    bool stop = false;
+    bool active = true;
+    while (active && !stop) {
+        active = false;
+        for (size_t rank = 0; !stop; ++rank) {
+            bool visited = false;
+            for (auto& entry : modes) {
+                Mode& mode = entry.second;
+                if (rank >= mode.open.size()) continue;
+                visited = true;
+                size_t i = mode.open[rank];
+                Stratum& stratum = strata[i];
+                if (!stratum.reader) continue;
+                stratum.tree->setSource(i, stratum.reader->eventIndex());
+                processEvent(stratum.event, *stratum.tree, FastSimulation::eventKey(filenames[i], stratum.reader->eventIndex()));
+                eventCount++;
+                if (!stratum.reader->readEvent(stratum.event)) close(i);
+                if (eventCount % checkpointInterval == 0) {
+                    for (auto& s : strata) {
+                        if (s.tree && s.changed) s.tree->Checkpoint();
+                        s.changed = false;
+                    }
+                    monitor.write(progressFilename, eventCount);
+                    if (verbosity > 0) monitor.print(eventCount);
+                    if (targetError > 0 && monitor.converged(targetError)) {
+                        std::cout << "Sin-moment uncertainties below " << targetError << " after " << eventCount << " events, stopping" << std::endl;
+                        stop = true;
+                        break;
+                    }
+                }
+            }
+            if (!visited) break;
+        }
+        // Files that ended leave room for the next files of their mode
+        for (auto& entry : modes) {
+            Mode& mode = entry.second;
+            mode.open.erase(std::remove_if(mode.open.begin(), mode.open.end(), [&](size_t i) { return !strata[i].reader; }), mode.open.end());
+            refill(mode);
+            if (!mode.open.empty()) active = true;
+        }
+    }
+    monitor.write(progressFilename, eventCount);
+
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < strata.size(); ++i) {
+        if (!strata[i].opened) continue;
+        if (strata[i].tree) close(i);
+        parts.push_back(outputFilename + ".part" + std::to_string(i) + ".root");
+    }
+    mergeOutputs(parts, true, outputFilename);
+}
+
+// Concatenates the partial outputs, in order, into the target file
+void LundAnalysis::mergeOutputs(const std::vector<std::string>& parts, bool removeParts, const std::string& target) {
+    if (parts.empty()) {
+        DISTree empty(target, analysisType, outputOptions);
+        configureTree(empty);
+        empty.Write();
+        return;
+    }
+    switch (outputOptions.format) {
+        case OutputFormat::ROOT: mergeTrees(parts, target); break;
+        case OutputFormat::Columnar: ColumnarWriter::concatenate(parts, target); break;
+        case OutputFormat::RNTuple: mergeNTuples(parts, target); break;
+        case OutputFormat::None: break;
+    }
+    if (removeParts) {
+        for (const auto& part : parts) fs::remove(part);
+    }
+}
+
+void LundAnalysis::mergeTrees(const std::vector<std::string>& parts, const std::string& target) {
+    TChain chain("tree");
+    for (const auto& part : parts) chain.Add(part.c_str());
+    // The parts are written with the same compression, so their baskets are copied as they are
+    TFile* merged = new TFile(target.c_str(), "RECREATE");
+    if (outputOptions.compression >= 0) merged->SetCompressionSettings(outputOptions.compression);
+    Long64_t previousMaxTreeSize = TTree::GetMaxTreeSize();
+    if (outputOptions.maxFileSize > 0) TTree::SetMaxTreeSize(outputOptions.maxFileSize);
+    // Closes and deletes the last file of the merged tree
+    chain.Merge(merged, 0, "fast");
+    TTree::SetMaxTreeSize(previousMaxTreeSize);
+}
+
+void LundAnalysis::mergeNTuples(const std::vector<std::string>& parts, const std::string& target) {
+    TFileMerger merger(false);
+    if (outputOptions.compression >= 0) merger.OutputFile(target.c_str(), "RECREATE", outputOptions.compression);
+    else merger.OutputFile(target.c_str(), "RECREATE");
+    for (const auto& part : parts) merger.AddFile(part.c_str());
+    if (!merger.Merge()) {
+        throw std::runtime_error("Unable to merge the partial outputs into " + target);
+    }
+}
+
+void LundAnalysis::processEvent(LundEvent& event, DISTree& tree, std::uint64_t eventKey, EventMixing* mixing, DISTree* mixedTree) {
+    if (fastSimulation && !fastSimulation->apply(event, eventKey)) return;
+    std::vector<Hadronium> particles = convertLundEventToHadronia(event, acc);
+    std::vector<std::vector<Hadronium>> hadronia = reconstruct_hadronia(particles, criteria);
     if (!rules.isEmpty()) {
         hadronia = filterHadronia(hadronia, rules);
     }
+    // Events without a candidate of their own still mix with, and feed, the pool
+    if (mixing) {
+        const std::vector<std::vector<Hadronium>>& mixed = mixing->mix(event, particles);
+        if (!mixed.empty()) {
+            if (bootstrap.replicas() > 0) bootstrap.generate(eventKey, mixedTree->replicaWeights());
+            mixedTree->Fill(event, mixed);
+        }
+    }
     if (hadronia.empty()) return;
-    distree.Fill(event, hadronia);
-    if (numPassed < 20 && verbosity > 0)
+    if (bootstrap.replicas() > 0) bootstrap.generate(eventKey, tree.replicaWeights());
+    tree.Fill(event, hadronia);
+    if (numPassed++ < 20 && verbosity > 0) {
+        std::lock_guard<std::mutex> lock(printMutex);
         printHadronia(hadronia);
-    numPassed++;
+    }
 }
 
 std::vector<std::string> LundAnalysis::findMatchingFiles(const std::string& pattern) {
@@ -75,10 +701,14 @@ std::vector<std::string> LundAnalysis::findMatchingFiles(const std::string& patt
 
     // Iterate over files in the directory and match against the pattern
     for (const auto& entry : fs::directory_iterator(dirPath)) {
+        // The generators' event counts of filtered samples are not event files
+        if (entry.path().extension() == ".counts") continue;
         if (fs::is_regular_file(entry) && std::regex_match(entry.path().filename().string(), finalPattern)) {
             matchingFiles.push_back(entry.path().string());
         }
     }
 
+    // Directory order is unspecified, process the files in a reproducible order
+    std::sort(matchingFiles.begin(), matchingFiles.end());
     return matchingFiles;
 }
\ No newline at end of file
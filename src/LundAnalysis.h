@@ -8,10 +8,20 @@
 #include "KinematicsStructs.h"
 #include "KinematicCut.h"
 #include "DISTree.h"
+#include "ProgressMonitor.h"
+#include "FastSimulation.h"
+#include "BinnedMoments.h"
+#include "Bootstrap.h"
+#include "EventMixing.h"
+#include "SkimList.h"
+#include "EventSource.h"
+#include <atomic>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 
 namespace fs = std::filesystem;
 using namespace std;
@@ -23,11 +33,80 @@ public:
     void setFilterRules(const FilterRules& rules);
     void addKinematicCut(const KinematicCut& cut);
     void run();
+    // Analyzes the events of source instead of input files, e.g. those of a
+    // generator running alongside (generate_and_analyze), so no event files
+    // are written. With threads > 1 every thread takes events from the source
+    // into its own partial output; the rows are then in the order the threads
+    // took the events. The file table holds source.name(). Not available in
+    // progressive runs, with a cache directory, candidate cache, event mixing
+    // or skim lists, which all need to read the events again.
+    void run(EventSource& source);
     void setCLAS12();
-    
+    // Progressive mode: events are visited interleaved across the input files
+    // (grouped by polarization mode) and every checkpointInterval events the
+    // changed outputs and the running statistics (<output>.progress) are saved.
+    // At most 4 files per mode are open at once; a mode moves on to its next
+    // file when one ends. With a targetError > 0 the run stops once all
+    // sin-moment uncertainties are below it. A progressive run over all events
+    // gives the same output as run().
+    void setProgressive(int checkpointInterval, double targetError = 0);
+    // Keeps the output of every input file in cacheDirectory, keyed by the
+    // file (size, modification time and content checksum) and by the analysis
+    // configuration. Files already analyzed with the same configuration are
+    // taken from the cache instead of being processed again.
+    void setCacheDirectory(const std::string& cacheDirectory);
+    // Keeps the reconstructed and filtered candidates, with their kinematics,
+    // in a candidate cache file. Later runs over the same files with the same
+    // type, criteria, filter rules and acceptance only re-apply the kinematic
+    // cuts to the cached candidates; otherwise the cache is rebuilt.
+    void setCandidateCache(const std::string& filename);
+    // Passes every event through the parametric detector response in mapFile
+    // (see FastSimulation) before the hadronia are reconstructed. Events whose
+    // scattered lepton is lost are skipped.
+    void setFastSimulation(const std::string& mapFile, std::uint64_t seed = 0);
+    // Compression, basket size, flush cadence, column precision and file size
+    // cap of the output (see OutputOptions). Partial outputs of cached and
+    // progressive runs are never split; the size cap applies to the merged output.
+    void setOutputOptions(const OutputOptions& options);
+    // Input files are processed by this many threads, each file into its own
+    // partial output, which are merged in file order. Progressive runs and
+    // runs with a candidate cache use one thread.
+    void setThreads(int threads);
+    // Accumulates binned yields and moments of the output rows (see
+    // BinnedMoments) and writes them to filename at the end of the run; with
+    // OutputFormat::None they are the only output. Not available with a cache
+    // directory, as cached files are not processed again.
+    void setBinnedMoments(const BinnedMoments& moments, const std::string& filename);
+    // Gives every event Poisson(1) weights for the given number of bootstrap
+    // replicas (see BootstrapWeights), accumulated by the binned moments and,
+    // with store, written to the "replicaWeights" column of the output, which
+    // the columnar format cannot store.
+    void setBootstrap(int replicas, std::uint64_t seed = 0, bool store = true);
+    // Also builds mixed-event candidates (see EventMixing) and fills them,
+    // with the kinematic cuts, into a second output with the same format.
+    // Events are only mixed with earlier events of the same input file, so
+    // the mixed output does not depend on the number of threads. Filter rules
+    // are not applied to the mixed candidates. Not available in progressive
+    // runs or with a cache directory or candidate cache.
+    void setEventMixing(const EventMixing& mixing, const std::string& filename);
+    // Adds the provenance columns fileId, eventIndex and ids to the outputs
+    // (see DISTree::recordProvenance). The file table, the input file of every
+    // fileId, is stored as the TNamed "files" (one path per line), in every
+    // file of an output split by Output:maxFileSize. Only ROOT and RNTuple
+    // outputs can store the ids collection.
+    void setProvenance(bool provenance);
+    // Writes the events with at least one output row as a skim list (see
+    // SkimList). Not available with a cache directory.
+    void setSkimOutput(const std::string& filename);
+    // Only processes the events of a skim list; files missing from it are
+    // skipped
+    void setSkimInput(const std::string& filename);
+
 private:
-    int numPassed = 0;
-    int eventCount = 0;
+    std::atomic<int> numPassed{0};
+    // The first events are printed from any analysis thread
+    std::mutex printMutex;
+    std::atomic<int> eventCount{0};
     int verbosity;
     DISTree distree;
     std::vector<std::string> filenames;
@@ -35,8 +114,51 @@ private:
     std::string criteria;
     HadroniumAnalysisType analysisType;
     FilterRules rules;
+    std::vector<KinematicCut> kinematicCuts;
     AcceptanceType acc = AcceptanceType::ALL;
-    void processEvent(LundEvent& event);
+    int checkpointInterval = 0;
+    double targetError = 0;
+    ProgressMonitor monitor;
+    std::string cacheDirectory;
+    std::string candidateCache;
+    std::string fastSimulationMap;
+    std::uint64_t fastSimulationSeed = 0;
+    std::unique_ptr<FastSimulation> fastSimulation;
+    OutputOptions outputOptions;
+    int threads = 1;
+    BinnedMoments binnedMoments;
+    std::string momentsFilename;
+    BootstrapWeights bootstrap;
+    std::uint64_t bootstrapSeed = 0;
+    bool storeReplicaWeights = true;
+    EventMixing eventMixing;
+    std::string mixingFilename;
+    bool provenance = false;
+    std::string skimOutput;
+    SkimList skim;
+    std::string skimInput;
+    SkimList selection;
+    void configureTree(DISTree& tree) const;
+    void checkColumnar() const;
+    OutputOptions partOptions() const;
+    void runSingle(BinnedMoments::Shard& sums);
+    void runThreaded(BinnedMoments::Shard& sums);
+    void runProgressive(BinnedMoments::Shard& sums);
+    void runCached();
+    void processFile(const std::string& file, DISTree& tree, DISTree* mixedTree = nullptr);
+    void processSource(EventSource& source, DISTree& tree);
+    void processEvent(LundEvent& event, DISTree& tree, std::uint64_t eventKey, EventMixing* mixing = nullptr, DISTree* mixedTree = nullptr);
+    void mergeOutputs(const std::vector<std::string>& parts, bool removeParts, const std::string& target);
+    void mergeTrees(const std::vector<std::string>& parts, const std::string& target);
+    void mergeNTuples(const std::vector<std::string>& parts, const std::string& target);
+    void writeFileTable(const std::string& target) const;
+    void attachSkim(DISTree& tree);
+    int fileId(const std::string& file) const;
+    void selectEvents(LundReader& reader, const std::string& file) const;
+    bool replayCandidates();
+    std::string configFingerprint(bool withCuts = true) const;
+    std::string candidateFingerprint() const;
+    std::string cacheKey(const std::string& file, const std::string& fingerprint) const;
     std::vector<std::string> findMatchingFiles(const std::string& pattern);
 };
 
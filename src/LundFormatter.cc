@@ -0,0 +1,100 @@
+#include "LundFormatter.h"
+#include <cmath>
+#include <cstdio>
+
+static void appendField(std::string& out, const char* text, int length, int width, bool left) {
+    if (!left && length < width) out.append(width - length, ' ');
+    out.append(text, length);
+    if (left && length < width) out.append(width - length, ' ');
+}
+
+void LundFormatter::appendInt(std::string& out, long value, int width, bool left) {
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* begin = end;
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        *--begin = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *--begin = '-';
+    appendField(out, begin, end - begin, width, left);
+}
+
+void LundFormatter::appendFixed(std::string& out, float value, int decimals, int width, bool left) {
+    static const long scales[] = {1, 10, 100, 1000, 10000};
+    long scale = scales[decimals];
+    // A float times 10^4 fits in the 53 bits of a double, so the product is
+    // exact, and nearbyint rounds half to even, as printf does
+    double scaled = std::nearbyint((double)value * scale);
+    if (!(std::fabs(scaled) < 1e15)) {
+        char buffer[64];
+        int length = std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, (double)value);
+        appendField(out, buffer, length, width, left);
+        return;
+    }
+    unsigned long magnitude = (unsigned long)std::fabs(scaled);
+    char buffer[32];
+    char* end = buffer + sizeof(buffer);
+    char* begin = end;
+    for (int d = 0; d < decimals; ++d) {
+        *--begin = '0' + magnitude % 10;
+        magnitude /= 10;
+    }
+    if (decimals > 0) *--begin = '.';
+    do {
+        *--begin = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+    // printf keeps the sign of negative values rounded to zero, and of -0
+    if (std::signbit(value)) *--begin = '-';
+    appendField(out, begin, end - begin, width, left);
+}
+
+void LundFormatter::appendHeaderFloat(std::string& out, float value) {
+    if (fixedHeader) {
+        appendFixed(out, value, 4, 8, true);
+        return;
+    }
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%g", (double)value);
+    appendField(out, buffer, length, 8, true);
+}
+
+void LundFormatter::header(std::string& out, int nParticles, float mass_target, int atomic_number_target,
+                           int target_polarization, int beam_polarization, int beam_type, float beam_energy,
+                           int interacted_nucleon_id, int process_id, float event_weight) {
+    out += '\t';
+    appendInt(out, nParticles, 8, true);
+    appendHeaderFloat(out, mass_target);
+    appendInt(out, atomic_number_target, 8, true);
+    appendInt(out, target_polarization, 8, true);
+    appendInt(out, beam_polarization, 8, true);
+    appendInt(out, beam_type, 8, true);
+    appendHeaderFloat(out, beam_energy);
+    appendInt(out, interacted_nucleon_id, 8, true);
+    appendInt(out, process_id, 8, true);
+    appendHeaderFloat(out, event_weight);
+    out += '\n';
+}
+
+void LundFormatter::particle(std::string& out, int index, float lifetime, int status, int particle_id,
+                             int index_of_parent, int index_of_first_daughter, float px, float py, float pz,
+                             float e, float m, float vx, float vy, float vz) {
+    appendInt(out, index, 4);
+    appendFixed(out, lifetime, 1, 8);
+    appendInt(out, status, 4);
+    appendInt(out, particle_id, 8);
+    appendInt(out, index_of_parent, 8);
+    appendInt(out, index_of_first_daughter, 8);
+    appendFixed(out, px, 4, 12);
+    appendFixed(out, py, 4, 12);
+    appendFixed(out, pz, 4, 12);
+    appendFixed(out, e, 4, 12);
+    appendFixed(out, m, 4, 12);
+    appendFixed(out, vx, 4, 12);
+    appendFixed(out, vy, 4, 12);
+    appendFixed(out, vz, 4, 12);
+    out += '\n';
+    fixedHeader = true;
+}
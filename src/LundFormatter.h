@@ -0,0 +1,35 @@
+#ifndef LUND_FORMATTER_H
+#define LUND_FORMATTER_H
+
+#include <string>
+
+// Appends LUND lines to a string, byte for byte as the iostream code of the
+// generators wrote them (setw, setprecision and fixed), without the streams:
+// integers and fixed-point floats are converted by integer arithmetic, which
+// is exact for float values. Like the stream, the header floats are written
+// in the default format (%g) until the first particle line, and in fixed
+// format with 4 decimals after it.
+class LundFormatter {
+public:
+    // fixedHeader: the stream state after earlier particle lines
+    explicit LundFormatter(bool fixedHeader = false) : fixedHeader(fixedHeader) {}
+
+    void header(std::string& out, int nParticles, float mass_target, int atomic_number_target,
+                int target_polarization, int beam_polarization, int beam_type, float beam_energy,
+                int interacted_nucleon_id, int process_id, float event_weight);
+    void particle(std::string& out, int index, float lifetime, int status, int particle_id,
+                  int index_of_parent, int index_of_first_daughter, float px, float py, float pz,
+                  float e, float m, float vx, float vy, float vz);
+
+    // Appends value in a field of the given width, right or left aligned
+    static void appendInt(std::string& out, long value, int width, bool left = false);
+    // Appends value with a number of decimals (at most 4), as printf("%.*f") does
+    static void appendFixed(std::string& out, float value, int decimals, int width, bool left = false);
+
+private:
+    bool fixedHeader;
+
+    void appendHeaderFloat(std::string& out, float value);
+};
+
+#endif // LUND_FORMATTER_H
@@ -1,4 +1,62 @@
 #include "LundReader.h"
+#include "RNTupleSupport.h"
+#include "TKey.h"
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+#ifdef SPINTHYIA_HAS_RNTUPLE
+// Views of the fields of an RNTuple written by pythia8_to_ttree
+struct LundReader::NTupleInput {
+    std::unique_ptr<ROOT::RNTupleReader> reader;
+    ROOT::RNTupleView<int> nParticles;
+    ROOT::RNTupleView<float> mass_target;
+    ROOT::RNTupleView<int> atomic_number_target;
+    ROOT::RNTupleView<int> target_polarization;
+    ROOT::RNTupleView<int> beam_polarization;
+    ROOT::RNTupleView<int> beam_type;
+    ROOT::RNTupleView<float> beam_energy;
+    ROOT::RNTupleView<int> interacted_nucleon_id;
+    ROOT::RNTupleView<int> process_id;
+    ROOT::RNTupleView<float> event_weight;
+    ROOT::RNTupleView<std::vector<int>> index;
+    ROOT::RNTupleView<std::vector<float>> lifetime;
+    ROOT::RNTupleView<std::vector<int>> status;
+    ROOT::RNTupleView<std::vector<int>> particle_id;
+    ROOT::RNTupleView<std::vector<int>> index_of_parent;
+    ROOT::RNTupleView<std::vector<int>> index_of_first_daughter;
+    ROOT::RNTupleView<std::vector<float>> px, py, pz, e, m, vx, vy, vz;
+
+    explicit NTupleInput(const std::string& filename)
+        : reader(ROOT::RNTupleReader::Open("tree", filename)),
+          nParticles(reader->GetView<int>("nParticles")),
+          mass_target(reader->GetView<float>("mass_target")),
+          atomic_number_target(reader->GetView<int>("atomic_number_target")),
+          target_polarization(reader->GetView<int>("target_polarization")),
+          beam_polarization(reader->GetView<int>("beam_polarization")),
+          beam_type(reader->GetView<int>("beam_type")),
+          beam_energy(reader->GetView<float>("beam_energy")),
+          interacted_nucleon_id(reader->GetView<int>("interacted_nucleon_id")),
+          process_id(reader->GetView<int>("process_id")),
+          event_weight(reader->GetView<float>("event_weight")),
+          index(reader->GetView<std::vector<int>>("index")),
+          lifetime(reader->GetView<std::vector<float>>("lifetime")),
+          status(reader->GetView<std::vector<int>>("status")),
+          particle_id(reader->GetView<std::vector<int>>("particle_id")),
+          index_of_parent(reader->GetView<std::vector<int>>("index_of_parent")),
+          index_of_first_daughter(reader->GetView<std::vector<int>>("index_of_first_daughter")),
+          px(reader->GetView<std::vector<float>>("px")),
+          py(reader->GetView<std::vector<float>>("py")),
+          pz(reader->GetView<std::vector<float>>("pz")),
+          e(reader->GetView<std::vector<float>>("e")),
+          m(reader->GetView<std::vector<float>>("m")),
+          vx(reader->GetView<std::vector<float>>("vx")),
+          vy(reader->GetView<std::vector<float>>("vy")),
+          vz(reader->GetView<std::vector<float>>("vz")) {}
+};
+#else
+struct LundReader::NTupleInput {};
+#endif
 
 LundReader::LundReader(const std::string& fname) : filename(fname) {
   // Check if the file has a .root extension
@@ -13,6 +71,16 @@ LundReader::LundReader(const std::string& fname) : filename(fname) {
       if (!fIn || !fIn->IsOpen()) {
           throw std::runtime_error("Unable to open ROOT file: " + filename);
       }
+      // pythia8_to_ttree writes either a TTree or an RNTuple
+      TKey* key = fIn->GetKey("tree");
+      if (key && std::string(key->GetClassName()).find("RNTuple") != std::string::npos) {
+#ifdef SPINTHYIA_HAS_RNTUPLE
+          ntuple.reset(new NTupleInput(filename));
+          return;
+#else
+          throw std::runtime_error("Reading the RNTuple in " + filename + " needs ROOT 6.36 or later");
+#endif
+      }
       tIn = (TTree*)(fIn->Get("tree"));
       if (!tIn) {
           throw std::runtime_error("Unable to find TTree named 'tree' in file: " + filename);
@@ -60,7 +128,47 @@ LundReader::~LundReader() {
     }
 }
 
+void LundReader::selectEvents(const std::vector<std::uint64_t>& bitmap) {
+    selective = true;
+    selection = bitmap;
+}
+
+// First selected event from the given one on, or -1
+long LundReader::nextSelected(long from) const {
+    std::size_t word = from / 64;
+    if (word >= selection.size()) return -1;
+    std::uint64_t bits = selection[word] & (~std::uint64_t(0) << (from % 64));
+    while (bits == 0) {
+        if (++word == selection.size()) return -1;
+        bits = selection[word];
+    }
+    return word * 64 + __builtin_ctzll(bits);
+}
+
+// Steps over the next event of a .dat file, reading only its particle count
+bool LundReader::skipEvent() {
+    eventCount++;
+    std::string line;
+    if (!std::getline(inFile, line)) return false;
+    long nParticles = std::strtol(line.c_str(), nullptr, 10);
+    for (long i = 0; i < nParticles; ++i) {
+        if (!inFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n')) return false;
+    }
+    return true;
+}
+
 bool LundReader::readEvent(LundEvent& event) {
+    if (selective) {
+        long next = nextSelected(eventCount + 1);
+        if (next < 0) return false;
+        if (isDat) {
+            while (eventCount + 1 < next) {
+                if (!skipEvent()) return false;
+            }
+        } else {
+            eventCount = next - 1;
+        }
+    }
     eventCount++;
     event.particles.clear(); // Clear any existing particles
     if (isDat == true){
@@ -86,8 +194,44 @@ bool LundReader::readEvent(LundEvent& event) {
           event.particles.push_back(particle);
       }
     }
+#ifdef SPINTHYIA_HAS_RNTUPLE
+    else if (ntuple){
+      if((std::uint64_t)eventCount>=ntuple->reader->GetNEntries()) return false;
+      NTupleInput& in = *ntuple;
+      event.nParticles = in.nParticles(eventCount);
+      event.mass_target = in.mass_target(eventCount);
+      event.atomic_number_target = in.atomic_number_target(eventCount);
+      event.target_polarization = in.target_polarization(eventCount);
+      event.beam_polarization = in.beam_polarization(eventCount);
+      event.beam_type = in.beam_type(eventCount);
+      event.beam_energy = in.beam_energy(eventCount);
+      event.interacted_nucleon_id = in.interacted_nucleon_id(eventCount);
+      event.process_id = in.process_id(eventCount);
+      event.event_weight = in.event_weight(eventCount);
+      const std::vector<int>& index = in.index(eventCount);
+      const std::vector<float>& lifetime = in.lifetime(eventCount);
+      const std::vector<int>& status = in.status(eventCount);
+      const std::vector<int>& particle_id = in.particle_id(eventCount);
+      const std::vector<int>& index_of_parent = in.index_of_parent(eventCount);
+      const std::vector<int>& index_of_first_daughter = in.index_of_first_daughter(eventCount);
+      const std::vector<float>& px = in.px(eventCount);
+      const std::vector<float>& py = in.py(eventCount);
+      const std::vector<float>& pz = in.pz(eventCount);
+      const std::vector<float>& e = in.e(eventCount);
+      const std::vector<float>& m = in.m(eventCount);
+      const std::vector<float>& vx = in.vx(eventCount);
+      const std::vector<float>& vy = in.vy(eventCount);
+      const std::vector<float>& vz = in.vz(eventCount);
+      for (size_t i = 0; i < px.size(); i++) {
+          LundParticle particle{index[i], lifetime[i], status[i], particle_id[i],
+                                index_of_parent[i], index_of_first_daughter[i],
+                                px[i], py[i], pz[i], e[i], m[i], vx[i], vy[i], vz[i]};
+          event.particles.push_back(particle);
+      }
+    }
+#endif
     else if (isTFile == true){
-      if(eventCount==tIn->GetEntries()) return false;
+      if(eventCount>=tIn->GetEntries()) return false;
       tIn->GetEntry(eventCount);
       event.nParticles = levent.nParticles;
       event.mass_target = levent.mass_target;
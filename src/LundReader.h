@@ -1,6 +1,7 @@
 #ifndef LUND_READER_H
 #define LUND_READER_H
 
+#include <cstdint>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -8,6 +9,7 @@
 #include "TFile.h"
 #include "TTree.h"
 #include <iostream>
+#include <memory>
 
 enum class AcceptanceType {
     ALL,
@@ -40,9 +42,11 @@ struct LundEvent {
     std::vector<LundParticle> particles;
 };
 
-// Class to read Lund data from a .dat file
+// Class to read Lund data from a .dat file, or from the ROOT file of
+// pythia8_to_ttree holding a TTree or an RNTuple named "tree"
 class LundReader {
 private:
+    struct NTupleInput;
     bool isTFile = false;
     bool isDat   = false;
     std::ifstream inFile;
@@ -64,11 +68,23 @@ private:
     std::vector<float> * vx= 0;
     std::vector<float> * vy= 0;
     std::vector<float> * vz= 0;
+    std::unique_ptr<NTupleInput> ntuple;
     int eventCount = -1;
+    bool selective = false;
+    std::vector<std::uint64_t> selection;
+    long nextSelected(long from) const;
+    bool skipEvent();
 public:
     LundReader(const std::string& fname);
     ~LundReader();
     bool readEvent(LundEvent& event);
+    // Only reads the events whose bit is set in the bitmap (bit e of word
+    // e/64 for event e, see SkimList). Events of ROOT files are read by entry
+    // number; the events of .dat files in between are skipped by their line
+    // count, without parsing them. Reading stops after the last selected event.
+    void selectEvents(const std::vector<std::uint64_t>& bitmap);
+    // Number in the file of the last event read, counting from 0
+    int eventIndex() const { return eventCount; }
 };
 
 void analyzeEvent(const LundEvent& event);
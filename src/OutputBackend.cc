@@ -0,0 +1,219 @@
+#include "OutputBackend.h"
+#include "ColumnarFile.h"
+#include "RNTupleSupport.h"
+#include "TFile.h"
+#include "TTree.h"
+#include <deque>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// TTree "tree", with the branch settings of the output options
+class TreeOutput : public OutputBackend {
+public:
+    TreeOutput(const std::string& filename, const OutputOptions& options) : options(options) {
+        file = new TFile(filename.data(), "RECREATE");
+        if (options.compression >= 0) file->SetCompressionSettings(options.compression);
+        // The size cap is global to the process; the previous one is restored with the output
+        if (options.maxFileSize > 0) {
+            previousMaxTreeSize = TTree::GetMaxTreeSize();
+            TTree::SetMaxTreeSize(options.maxFileSize);
+        }
+        tree = new TTree("tree", "Kinematics Data Tree");
+        if (options.autoFlush != 0) tree->SetAutoFlush(options.autoFlush);
+        if (options.autoSave != 0) tree->SetAutoSave(options.autoSave);
+    }
+    ~TreeOutput() {
+        delete file;
+        if (options.maxFileSize > 0) TTree::SetMaxTreeSize(previousMaxTreeSize);
+    }
+
+    void addColumn(const std::string& name, double* value) override {
+        auto found = options.precision.find(name);
+        if (found == options.precision.end()) {
+            tree->Branch(name.c_str(), value, (name + "/D").c_str(), options.basketSize);
+        } else if (found->second.type == ColumnPrecision::Type::Float) {
+            floatColumns.push_back(FloatColumn{value, 0});
+            tree->Branch(name.c_str(), &floatColumns.back().value, (name + "/F").c_str(), options.basketSize);
+        } else {
+            const ColumnPrecision& p = found->second;
+            std::ostringstream leaf;
+            leaf << name << "/d";
+            if (p.min != 0 || p.max != 0) leaf << "[" << p.min << "," << p.max << "," << p.bits << "]";
+            tree->Branch(name.c_str(), value, leaf.str().c_str(), options.basketSize);
+        }
+    }
+    void addColumn(const std::string& name, int* value) override {
+        tree->Branch(name.c_str(), value, (name + "/I").c_str(), options.basketSize);
+    }
+    void addColumn(const std::string& name, std::vector<double>* values) override {
+        if (options.precision.count(name)) {
+            floatCollections.push_back(FloatCollection{values, {}});
+            tree->Branch(name.c_str(), &floatCollections.back().values, options.basketSize);
+        } else {
+            tree->Branch(name.c_str(), values, options.basketSize);
+        }
+    }
+    void addColumn(const std::string& name, std::vector<int>* values) override {
+        tree->Branch(name.c_str(), values, options.basketSize);
+    }
+
+    void fill() override {
+        for (auto& column : floatColumns) column.value = (float)*column.source;
+        for (auto& column : floatCollections) column.values.assign(column.source->begin(), column.source->end());
+        tree->Fill();
+        // TTree::Fill closes the file and opens the next one at the size cap
+        file = tree->GetCurrentFile();
+    }
+    void checkpoint() override {
+        tree->AutoSave("SaveSelf");
+    }
+    void write() override {
+        file->WriteTObject(tree);
+        file->Close();
+    }
+
+private:
+    // Float_t copy of a double column, refreshed before every Fill
+    struct FloatColumn {
+        const double* source;
+        float value;
+    };
+    struct FloatCollection {
+        const std::vector<double>* source;
+        std::vector<float> values;
+    };
+
+    OutputOptions options;
+    // Current file of the tree, which changes when the file reaches options.maxFileSize
+    TFile* file = nullptr;
+    TTree* tree = nullptr;
+    Long64_t previousMaxTreeSize = 0;
+    std::deque<FloatColumn> floatColumns;
+    std::deque<FloatCollection> floatCollections;
+};
+
+// Discards the rows
+class NullOutput : public OutputBackend {
+public:
+    void addColumn(const std::string&, double*) override {}
+    void addColumn(const std::string&, int*) override {}
+    void addColumn(const std::string&, std::vector<double>*) override {}
+    void addColumn(const std::string&, std::vector<int>*) override {}
+    void fill() override {}
+    void checkpoint() override {}
+    void write() override {}
+};
+
+#ifdef SPINTHYIA_HAS_RNTUPLE
+// RNTuple "tree". The model is complete once the first row is filled, so the
+// writer is created then.
+class NTupleOutput : public OutputBackend {
+public:
+    NTupleOutput(const std::string& filename, const OutputOptions& options)
+        : filename(filename), options(options), model(ROOT::RNTupleModel::Create()) {}
+
+    void addColumn(const std::string& name, double* value) override {
+        auto found = options.precision.find(name);
+        const ColumnPrecision* p = found == options.precision.end() ? nullptr : &found->second;
+        if (p && p->type == ColumnPrecision::Type::Double32 && (p->min != 0 || p->max != 0)) {
+            auto field = std::make_unique<ROOT::RField<double>>(name);
+            field->SetQuantized(p->min, p->max, p->bits);
+            model->AddField(std::move(field));
+            bind.push_back([name, value](ROOT::REntry& entry) { entry.BindRawPtr(name, value); });
+        } else if (p) {
+            floatColumns.push_back(FloatColumn{value, 0});
+            float* shadow = &floatColumns.back().value;
+            model->MakeField<float>(name);
+            bind.push_back([name, shadow](ROOT::REntry& entry) { entry.BindRawPtr(name, shadow); });
+        } else {
+            model->MakeField<double>(name);
+            bind.push_back([name, value](ROOT::REntry& entry) { entry.BindRawPtr(name, value); });
+        }
+    }
+    void addColumn(const std::string& name, int* value) override {
+        model->MakeField<int>(name);
+        bind.push_back([name, value](ROOT::REntry& entry) { entry.BindRawPtr(name, value); });
+    }
+    void addColumn(const std::string& name, std::vector<double>* values) override {
+        if (options.precision.count(name)) {
+            floatCollections.push_back(FloatCollection{values, {}});
+            std::vector<float>* shadow = &floatCollections.back().values;
+            model->MakeField<std::vector<float>>(name);
+            bind.push_back([name, shadow](ROOT::REntry& entry) { entry.BindRawPtr(name, shadow); });
+        } else {
+            model->MakeField<std::vector<double>>(name);
+            bind.push_back([name, values](ROOT::REntry& entry) { entry.BindRawPtr(name, values); });
+        }
+    }
+    void addColumn(const std::string& name, std::vector<int>* values) override {
+        model->MakeField<std::vector<int>>(name);
+        bind.push_back([name, values](ROOT::REntry& entry) { entry.BindRawPtr(name, values); });
+    }
+
+    void fill() override {
+        if (!writer) open();
+        for (auto& column : floatColumns) column.value = (float)*column.source;
+        for (auto& column : floatCollections) column.values.assign(column.source->begin(), column.source->end());
+        writer->Fill(*entry);
+    }
+    // The rows are committed to the file, but it can only be read once the
+    // footer is written by write()
+    void checkpoint() override {
+        if (!writer) open();
+        writer->CommitCluster();
+    }
+    void write() override {
+        if (!writer) open();
+        entry.reset();
+        writer.reset();
+    }
+
+private:
+    struct FloatColumn {
+        const double* source;
+        float value;
+    };
+    struct FloatCollection {
+        const std::vector<double>* source;
+        std::vector<float> values;
+    };
+
+    std::string filename;
+    OutputOptions options;
+    std::unique_ptr<ROOT::RNTupleModel> model;
+    std::unique_ptr<ROOT::RNTupleWriter> writer;
+    std::unique_ptr<ROOT::REntry> entry;
+    std::vector<std::function<void(ROOT::REntry&)>> bind;
+    std::deque<FloatColumn> floatColumns;
+    std::deque<FloatCollection> floatCollections;
+
+    void open() {
+        ROOT::RNTupleWriteOptions writeOptions;
+        if (options.compression >= 0) writeOptions.SetCompression(options.compression);
+        writer = ROOT::RNTupleWriter::Recreate(std::move(model), "tree", filename, writeOptions);
+        entry = writer->CreateEntry();
+        for (const auto& b : bind) b(*entry);
+    }
+};
+#endif
+
+} // namespace
+
+std::unique_ptr<OutputBackend> OutputBackend::create(const std::string& filename, const OutputOptions& options) {
+    switch (options.format) {
+        case OutputFormat::Columnar: return std::unique_ptr<OutputBackend>(new ColumnarWriter(filename, options));
+        case OutputFormat::RNTuple:
+#ifdef SPINTHYIA_HAS_RNTUPLE
+            return std::unique_ptr<OutputBackend>(new NTupleOutput(filename, options));
+#else
+            throw std::runtime_error("RNTuple output needs ROOT 6.36 or later (see RNTupleSupport.h)");
+#endif
+        case OutputFormat::None: return std::unique_ptr<OutputBackend>(new NullOutput());
+        case OutputFormat::ROOT: break;
+    }
+    return std::unique_ptr<OutputBackend>(new TreeOutput(filename, options));
+}
@@ -0,0 +1,76 @@
+#ifndef OUTPUT_BACKEND_H
+#define OUTPUT_BACKEND_H
+
+#include "RtypesCore.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Stored precision of a double column: Float_t, or Double32_t packed into
+// bits bits over [min, max] (with min == max == 0, stored as a float)
+struct ColumnPrecision {
+    enum class Type { Float, Double32 };
+    Type type = Type::Float;
+    double min = 0;
+    double max = 0;
+    int bits = 0;
+};
+
+enum class OutputFormat {
+    ROOT,     // TTree "tree" in a ROOT file
+    Columnar, // memory mappable column arrays (see ColumnarFile.h)
+    RNTuple,  // RNTuple "tree" in a ROOT file (see RNTupleSupport.h)
+    None      // no file; the rows are only seen by the row observers (see BinnedMoments)
+};
+
+enum class OutputLayout {
+    Rows,  // one row per candidate, with the event columns repeated
+    Events // one entry per event with candidates, the candidate columns as collections
+};
+
+// Storage settings of the output tree. Zero keeps ROOT's default.
+struct OutputOptions {
+    OutputFormat format = OutputFormat::ROOT;
+    OutputLayout layout = OutputLayout::Rows;
+    // ROOT compression setting, 100 * algorithm + level (ROOT::CompressionSettings);
+    // -1 keeps ROOT's default
+    int compression = -1;
+    int basketSize = 32000;
+    // Rows (> 0) or bytes (< 0) between basket flushes and between saves of the tree header
+    Long64_t autoFlush = 0;
+    Long64_t autoSave = 0;
+    // Once the file holds this many bytes the tree continues in <name>_1.root,
+    // <name>_2.root, ... (TTree::SetMaxTreeSize, which is global to the process
+    // and restored when the output is closed)
+    Long64_t maxFileSize = 0;
+    // Columns stored with reduced precision; the others are stored as Double_t.
+    // The columnar format stores both reduced types as float; RNTuple stores
+    // Double32 columns with a range as quantized fields. Collections with a
+    // reduced precision are stored as float.
+    std::map<std::string, ColumnPrecision> precision;
+};
+
+// Storage of the rows of a DISTree. The columns are declared once, pointing
+// at the buffers holding the values of the current row, and fill() stores
+// that row. Collection columns hold a variable number of values per row.
+// The ROOT and RNTuple formats use the compression setting; only the ROOT
+// format uses the basket, flush and file size settings.
+class OutputBackend {
+public:
+    virtual ~OutputBackend() {}
+    virtual void addColumn(const std::string& name, double* value) = 0;
+    virtual void addColumn(const std::string& name, int* value) = 0;
+    virtual void addColumn(const std::string& name, std::vector<double>* values) = 0;
+    virtual void addColumn(const std::string& name, std::vector<int>* values) = 0;
+    virtual void fill() = 0;
+    // Saves the rows filled so far. They can be read at once from ROOT and
+    // columnar files; an RNTuple can only be read after write()
+    virtual void checkpoint() = 0;
+    // Completes and closes the file
+    virtual void write() = 0;
+
+    static std::unique_ptr<OutputBackend> create(const std::string& filename, const OutputOptions& options);
+};
+
+#endif // OUTPUT_BACKEND_H
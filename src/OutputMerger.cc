@@ -0,0 +1,145 @@
+#include "OutputMerger.h"
+#include "BinnedMoments.h"
+#include "ColumnarFile.h"
+#include "TFile.h"
+#include "TFileMerger.h"
+#include "TROOT.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+void OutputMerger::setThreads(int threads) {
+    this->threads = std::max(1, threads);
+}
+
+void OutputMerger::setFanIn(int fanIn) {
+    if (fanIn < 2) throw std::runtime_error("The fan-in of a merge must be at least 2");
+    this->fanIn = fanIn;
+}
+
+void OutputMerger::setCompression(int compression) {
+    this->compression = compression;
+}
+
+void OutputMerger::setRemoveInputs(bool remove) {
+    removeInputs = remove;
+}
+
+// By the content, since columnar outputs may be named .root
+static bool isRootFile(const std::string& filename) {
+    return !ColumnarFile::isColumnar(filename);
+}
+
+MergeStatistics OutputMerger::merge(const std::vector<std::string>& inputs, const std::string& output) const {
+    if (inputs.empty()) throw std::runtime_error("No files to merge into " + output);
+    auto start = std::chrono::steady_clock::now();
+    MergeStatistics statistics;
+    statistics.files = inputs.size();
+    for (const auto& input : inputs) statistics.bytesIn += fs::file_size(input);
+
+    std::size_t nRoot = std::count_if(inputs.begin(), inputs.end(), isRootFile);
+    if (nRoot == 0) {
+        ColumnarWriter::concatenate(inputs, output);
+        statistics.levels = 1;
+    } else if (nRoot != inputs.size()) {
+        throw std::runtime_error("ROOT and columnar files cannot be merged together into " + output);
+    } else {
+        // fileId is an index into the file table of its own job, which the
+        // merge can neither renumber (baskets are copied as they are) nor join
+        int settings = compression;
+        for (const auto& input : inputs) {
+            std::unique_ptr<TFile> file(TFile::Open(input.c_str(), "READ"));
+            if (!file || file->IsZombie()) throw std::runtime_error("Unable to open " + input);
+            if (file->GetKey("files")) {
+                throw std::runtime_error(input + " has a provenance file table, whose fileId values would collide with those of the other inputs");
+            }
+            if (settings < 0) settings = file->GetCompressionSettings();
+        }
+        ROOT::EnableThreadSafety();
+
+        // Every level copies all the data, so there are as few as possible:
+        // one parallel level of a group per thread (more when the groups would
+        // exceed fanIn), and the final merge once at most fanIn files are left.
+        // Inputs too few to give each thread two files are merged at once.
+        std::vector<std::string> level = inputs;
+        bool intermediate = false;
+        while (true) {
+            statistics.levels++;
+            bool parallel = !intermediate && threads > 1 && level.size() >= 2 * (std::size_t)threads;
+            if (level.size() <= (std::size_t)fanIn && !parallel) {
+                mergeFiles(level, output, settings);
+                break;
+            }
+            std::size_t nGroups = std::max<std::size_t>((level.size() + fanIn - 1) / fanIn, intermediate ? 1 : threads);
+            std::size_t size = (level.size() + nGroups - 1) / nGroups;
+            nGroups = (level.size() + size - 1) / size;
+            std::vector<std::string> next;
+            for (std::size_t g = 0; g < nGroups; ++g) {
+                next.push_back(output + ".merge" + std::to_string(statistics.levels) + "_" + std::to_string(g) + ".root");
+            }
+            std::vector<std::exception_ptr> errors(nGroups);
+            std::atomic<std::size_t> task(0);
+            auto worker = [&]() {
+                for (std::size_t g = task++; g < nGroups; g = task++) {
+                    try {
+                        std::size_t begin = g * size;
+                        std::size_t end = std::min(begin + size, level.size());
+                        mergeFiles(std::vector<std::string>(level.begin() + begin, level.begin() + end), next[g], settings);
+                    } catch (...) {
+                        errors[g] = std::current_exception();
+                    }
+                }
+            };
+            std::vector<std::thread> pool;
+            for (int t = 0; t < std::min<int>(threads, nGroups); ++t) pool.emplace_back(worker);
+            for (auto& thread : pool) thread.join();
+            for (const auto& error : errors) {
+                if (error) std::rethrow_exception(error);
+            }
+            if (intermediate) {
+                for (const auto& file : level) fs::remove(file);
+            }
+            level = next;
+            intermediate = true;
+        }
+        if (intermediate) {
+            for (const auto& file : level) fs::remove(file);
+        }
+
+        // The added "mean<k>" of binned moments are not means any more
+        std::unique_ptr<TFile> merged(TFile::Open(output.c_str(), "UPDATE"));
+        if (merged && !merged->IsZombie() && merged->GetKey("yield_replicas")) {
+            BinnedMoments::completeMeans(*merged);
+        }
+    }
+
+    if (removeInputs) {
+        for (const auto& input : inputs) fs::remove(input);
+    }
+    statistics.bytesOut = fs::file_size(output);
+    statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return statistics;
+}
+
+void OutputMerger::mergeFiles(const std::vector<std::string>& inputs, const std::string& output, int compression) const {
+    TFileMerger merger(false, false);
+    merger.SetPrintLevel(0);
+    merger.SetFastMethod(true);
+    merger.SetMaxOpenedFiles(fanIn);
+    if (!merger.OutputFile(output.c_str(), "RECREATE", compression)) {
+        throw std::runtime_error("Unable to create " + output);
+    }
+    for (const auto& input : inputs) {
+        if (!merger.AddFile(input.c_str(), false)) throw std::runtime_error("Unable to open " + input);
+    }
+    if (!merger.Merge()) {
+        throw std::runtime_error("Unable to merge the files into " + output);
+    }
+}
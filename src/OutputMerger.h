@@ -0,0 +1,50 @@
+#ifndef OUTPUT_MERGER_H
+#define OUTPUT_MERGER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MergeStatistics {
+    std::size_t files = 0;
+    std::uintmax_t bytesIn = 0;
+    std::uintmax_t bytesOut = 0;
+    double seconds = 0;
+    int levels = 0;
+};
+
+// Merges the outputs of several analysis jobs, as hadd does, in a tree
+// reduction over threads. A first level splits the files, in order, into one
+// group of consecutive files per thread (or more, of at most fanIn files),
+// merged by TFileMerger in parallel into intermediate files; the final merge
+// writes the output once at most fanIn files are left. The rows therefore
+// keep the order of the inputs. Outputs with a provenance file table are
+// refused, as their fileId values only hold within their own job.
+//
+// Trees with the same branches are merged by copying their compressed
+// baskets (fast cloning), one basket at a time, so memory does not grow with
+// the size of the inputs; histograms, e.g. of BinnedMoments, are added and
+// their "mean<k>" recomputed. Columnar outputs (recognized by their magic,
+// whatever their name) are concatenated with ColumnarWriter::concatenate.
+class OutputMerger {
+public:
+    void setThreads(int threads);
+    // Most files merged by one TFileMerger
+    void setFanIn(int fanIn);
+    // ROOT compression setting of the output; by default that of the first input
+    void setCompression(int compression);
+    // Deletes the inputs once the output is complete
+    void setRemoveInputs(bool remove);
+
+    MergeStatistics merge(const std::vector<std::string>& inputs, const std::string& output) const;
+
+private:
+    int threads = 1;
+    int fanIn = 64;
+    int compression = -1;
+    bool removeInputs = false;
+
+    void mergeFiles(const std::vector<std::string>& inputs, const std::string& output, int compression) const;
+};
+
+#endif // OUTPUT_MERGER_H
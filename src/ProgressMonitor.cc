@@ -0,0 +1,81 @@
+#include "ProgressMonitor.h"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+void ProgressMonitor::define(const DISTree& tree) {
+    for (const char* name : {"Q2", "x", "y", "W", "z", "pt", "Mh", "xF", "Mx"}) {
+        if (tree.findVariable(name)) quantities.push_back(Quantity{name, RunningStatistic()});
+    }
+    // Azimuthal angle of the hadron (single hadron) or of the pair (dihadron)
+    std::string phi = tree.findVariable("phi") ? "phi" : "phi_h";
+    std::vector<std::pair<std::string, std::string>> modulations = {
+        {"bPol", phi}, {"tPol", phi}, {"bPol", "phi_RT"}, {"bPol", "phi_Rperp"}
+    };
+    for (const auto& modulation : modulations) {
+        if (!tree.findVariable(modulation.second)) continue;
+        for (int harmonic : {1, 2}) {
+            // The beam-spin asymmetries are dominated by the first harmonic
+            if (modulation.first == "bPol" && harmonic == 2) continue;
+            std::string name = modulation.first + "*sin(" + (harmonic == 2 ? "2" : "") + modulation.second + ")";
+            moments.push_back(Moment{name, modulation.first, modulation.second, harmonic, RunningStatistic()});
+        }
+    }
+}
+
+void ProgressMonitor::attach(DISTree& tree) {
+    if (quantities.empty() && moments.empty()) define(tree);
+
+    std::vector<const BranchVariable*> quantityVariables;
+    for (const auto& q : quantities) quantityVariables.push_back(tree.findVariable(q.name));
+    std::vector<std::pair<const BranchVariable*, const BranchVariable*>> momentVariables;
+    for (const auto& m : moments) {
+        momentVariables.push_back({tree.findVariable(m.polarization), tree.findVariable(m.angle)});
+    }
+
+    tree.addRowObserver([this, quantityVariables, momentVariables]() {
+        rows++;
+        for (size_t i = 0; i < quantities.size(); ++i) {
+            quantities[i].stat.add(quantityVariables[i]->value());
+        }
+        for (size_t i = 0; i < moments.size(); ++i) {
+            double pol = momentVariables[i].first->value();
+            if (pol == 0) continue; // only rows of the corresponding polarization mode
+            moments[i].stat.add(pol * std::sin(moments[i].harmonic * momentVariables[i].second->value()));
+        }
+    });
+}
+
+bool ProgressMonitor::converged(double targetError) const {
+    bool any = false;
+    for (const auto& m : moments) {
+        // No row of the sample has this polarization, e.g. tPol in an LU-only sample
+        if (m.stat.n == 0 && rows > 0) continue;
+        if (m.stat.n < 100 || m.stat.error() > targetError) return false;
+        any = true;
+    }
+    return any;
+}
+
+void ProgressMonitor::table(std::ostream& os, long events) const {
+    os << "# events " << events << " rows " << rows << "\n";
+    os << std::left << std::setw(24) << "# quantity" << std::right << std::setw(12) << "n"
+       << std::setw(16) << "mean" << std::setw(16) << "stddev" << std::setw(16) << "error" << "\n";
+    auto line = [&os](const std::string& name, const RunningStatistic& stat) {
+        os << std::left << std::setw(24) << name << std::right << std::setw(12) << stat.n
+           << std::setw(16) << stat.mean << std::setw(16) << std::sqrt(stat.variance())
+           << std::setw(16) << stat.error() << "\n";
+    };
+    for (const auto& q : quantities) line(q.name, q.stat);
+    for (const auto& m : moments) line(m.name, m.stat);
+}
+
+void ProgressMonitor::write(const std::string& filename, long events) const {
+    std::ofstream out(filename);
+    table(out, events);
+}
+
+void ProgressMonitor::print(long events) const {
+    table(std::cout, events);
+}
@@ -0,0 +1,62 @@
+#ifndef PROGRESS_MONITOR_H
+#define PROGRESS_MONITOR_H
+
+#include "DISTree.h"
+#include <cmath>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Running mean and variance (Welford's algorithm)
+struct RunningStatistic {
+    long n = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void add(double x) {
+        n++;
+        double delta = x - mean;
+        mean += delta / n;
+        m2 += delta * (x - mean);
+    }
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+    double error() const { return n > 1 ? std::sqrt(variance() / n) : 0.0; }
+};
+
+// Running statistics of the rows written by one or more DISTrees, used by the
+// progressive mode of LundAnalysis to report early estimates. It follows the
+// mean and variance of the key kinematic variables and the polarization
+// weighted sin-moments of the hadron azimuthal angles, e.g. <bPol sin(phi_h)>
+// over the rows with a polarized beam, whose mean is A_LU/2.
+class ProgressMonitor {
+public:
+    // Starts following the rows filled by the tree
+    void attach(DISTree& tree);
+    // Writes the current statistics as a text table
+    void write(const std::string& filename, long events) const;
+    void print(long events) const;
+    // True when every sin-moment has an uncertainty below targetError; moments
+    // without any row of their polarization are left out
+    bool converged(double targetError) const;
+
+private:
+    struct Quantity {
+        std::string name;
+        RunningStatistic stat;
+    };
+    struct Moment {
+        std::string name;
+        std::string polarization; // bPol or tPol
+        std::string angle;
+        int harmonic;
+        RunningStatistic stat;
+    };
+    long rows = 0;
+    std::vector<Quantity> quantities;
+    std::vector<Moment> moments;
+
+    void define(const DISTree& tree);
+    void table(std::ostream& os, long events) const;
+};
+
+#endif // PROGRESS_MONITOR_H
@@ -0,0 +1,24 @@
+#ifndef RNTUPLE_SUPPORT_H
+#define RNTUPLE_SUPPORT_H
+
+// RNTuple output and input need the stable RNTuple classes in the ROOT
+// namespace (ROOT 6.36 and later); with older ROOT versions
+// SPINTHYIA_HAS_RNTUPLE is not defined and the RNTuple options report an
+// error instead. The Makefile links libROOTNTuple when ROOT provides it.
+
+#include "RVersion.h"
+
+#if defined(__has_include)
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 36, 0) && __has_include(<ROOT/RNTupleWriter.hxx>)
+#define SPINTHYIA_HAS_RNTUPLE 1
+#include <ROOT/REntry.hxx>
+#include <ROOT/RField.hxx>
+#include <ROOT/RNTupleModel.hxx>
+#include <ROOT/RNTupleReader.hxx>
+#include <ROOT/RNTupleView.hxx>
+#include <ROOT/RNTupleWriteOptions.hxx>
+#include <ROOT/RNTupleWriter.hxx>
+#endif
+#endif
+
+#endif // RNTUPLE_SUPPORT_H
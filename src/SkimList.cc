@@ -0,0 +1,85 @@
+#include "SkimList.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+SkimList::SkimList(const std::vector<std::string>& files) : fileNames(files), bitmaps(files.size()) {}
+
+void SkimList::mark(int fileId, std::uint64_t event) {
+    std::vector<std::uint64_t>& bitmap = bitmaps.at(fileId);
+    std::size_t word = event / 64;
+    if (word >= bitmap.size()) bitmap.resize(word + 1, 0);
+    bitmap[word] |= std::uint64_t(1) << (event % 64);
+}
+
+std::uint64_t SkimList::selected(int fileId) const {
+    std::uint64_t n = 0;
+    for (std::uint64_t word : bitmaps.at(fileId)) n += __builtin_popcountll(word);
+    return n;
+}
+
+const std::vector<std::uint64_t>* SkimList::find(const std::string& file) const {
+    for (std::size_t i = 0; i < fileNames.size(); ++i) {
+        if (fileNames[i] == file) return &bitmaps[i];
+    }
+    std::string name = fs::path(file).filename().string();
+    for (std::size_t i = 0; i < fileNames.size(); ++i) {
+        if (fs::path(fileNames[i]).filename().string() == name) return &bitmaps[i];
+    }
+    return nullptr;
+}
+
+void SkimList::write(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out) {
+        throw std::runtime_error("Unable to write skim list: " + filename);
+    }
+    out << std::hex << std::setfill('0');
+    for (std::size_t i = 0; i < fileNames.size(); ++i) {
+        out << "file " << fileNames[i] << "\n"
+            << "selected " << std::dec << selected(i) << " words " << bitmaps[i].size() << std::hex << "\n";
+        for (std::size_t w = 0; w < bitmaps[i].size(); ++w) {
+            out << std::setw(16) << bitmaps[i][w] << ((w % 8 == 7 || w + 1 == bitmaps[i].size()) ? "\n" : " ");
+        }
+    }
+}
+
+SkimList SkimList::read(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw std::runtime_error("Unable to open skim list: " + filename);
+    }
+    SkimList skim;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (line.compare(0, 5, "file ") != 0) {
+            throw std::runtime_error("Malformed skim list " + filename + ": expected 'file <path>'");
+        }
+        std::string file = line.substr(5);
+        std::string keyword, words;
+        std::uint64_t nSelected = 0, nWords = 0;
+        if (!std::getline(in, line) || !(std::istringstream(line) >> keyword >> nSelected >> words >> nWords) ||
+            keyword != "selected" || words != "words") {
+            throw std::runtime_error("Malformed skim list " + filename + ": expected 'selected <n> words <n>'");
+        }
+        std::vector<std::uint64_t> bitmap(nWords);
+        for (std::uint64_t w = 0; w < nWords; w += 8) {
+            std::getline(in, line);
+            std::istringstream values(line);
+            for (std::uint64_t k = w; k < std::min(w + 8, nWords); ++k) {
+                if (!(values >> std::hex >> bitmap[k])) {
+                    throw std::runtime_error("Malformed skim list " + filename + ": missing bitmap words of " + file);
+                }
+            }
+        }
+        skim.fileNames.push_back(file);
+        skim.bitmaps.push_back(bitmap);
+    }
+    return skim;
+}
@@ -0,0 +1,39 @@
+#ifndef SKIM_LIST_H
+#define SKIM_LIST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Selected events of a set of input files, as one bitmap per file: bit e of
+// word e/64 is set when event e of the file is selected. Written by
+// LundAnalysis for the events with at least one output row, and read back to
+// reprocess only those events (see LundReader::selectEvents).
+//
+// The text format lists, per file
+//
+//   file <path>
+//   selected <number of selected events> words <number of 64-bit words>
+//   <words in hexadecimal, eight per line>
+class SkimList {
+public:
+    SkimList() {}
+    explicit SkimList(const std::vector<std::string>& files);
+    static SkimList read(const std::string& filename);
+    void write(const std::string& filename) const;
+
+    // Selects an event of the file with the given index in files(). Events of
+    // different files may be selected from different threads.
+    void mark(int fileId, std::uint64_t event);
+    const std::vector<std::string>& files() const { return fileNames; }
+    std::uint64_t selected(int fileId) const;
+    // Bitmap of the file, found by its path or else by its file name, or
+    // nullptr when the file is not in the list
+    const std::vector<std::uint64_t>* find(const std::string& file) const;
+
+private:
+    std::vector<std::string> fileNames;
+    std::vector<std::vector<std::uint64_t>> bitmaps;
+};
+
+#endif // SKIM_LIST_H
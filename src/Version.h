@@ -0,0 +1,9 @@
+#ifndef SPINTHYIA_VERSION_H
+#define SPINTHYIA_VERSION_H
+
+// Version of the spinthyia library. It is part of the fingerprint of cached
+// analysis results, so it must be increased whenever a change to the library
+// alters the content of the analysis outputs.
+#define SPINTHYIA_VERSION "1.1.0"
+
+#endif // SPINTHYIA_VERSION_H